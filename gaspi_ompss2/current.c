@@ -17,6 +17,7 @@
 
 #include "utilities.h"
 #include "zdf.h"
+#include "timer.h"
 #include "task_management.h"
 
 /*********************************************************************************************
@@ -83,11 +84,14 @@ void current_delete(t_current *current)
 // Set the current buffer to zero
 void current_zero(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	current->iter++;
 
 	// zero fields
 	size_t size = current->nrow * current->ncol;
 	memset(current->J_buf, 0, size * sizeof(t_vfld));
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 /*********************************************************************************************
@@ -197,6 +201,7 @@ void current_add_remote_offset(t_current *current, const int region_id, const bo
 
 void current_send_gc_x(t_current *current, const int region_id, const gaspi_rank_t adj_ranks[4])
 {
+	const uint64_t t0 = timer_ticks();
 	const unsigned int queue = get_gaspi_queue(region_id);
 
 	const int nrow = current->nrow;
@@ -262,10 +267,13 @@ void current_send_gc_x(t_current *current, const int region_id, const gaspi_rank
 		        queue,										// Queue
 		        GASPI_BLOCK));								// Timeout in ms
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 void current_reduction_x(t_current *current, const int region_id, gaspi_rank_t adj_ranks[4])
 {
+	const uint64_t t0 = timer_ticks();
 	const unsigned int queue = get_gaspi_queue(region_id);
 
 	const int nrow = current->nrow;
@@ -322,10 +330,13 @@ void current_reduction_x(t_current *current, const int region_id, gaspi_rank_t a
 	                               queue, GASPI_BLOCK));
 
 	current->first_comm = false;
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 void current_update_gc_x(t_current *current, const int region_id, gaspi_rank_t adj_ranks[4])
 {
+	const uint64_t t0 = timer_ticks();
 	const unsigned int queue = get_gaspi_queue(region_id);
 
 	const int nrow = current->nrow;
@@ -364,11 +375,14 @@ void current_update_gc_x(t_current *current, const int region_id, gaspi_rank_t a
 	notif_id = NOTIFICATION_ID(GRID_RIGHT, region_id, NOTIF_ID_CURRENT_ACK);
 	CHECK_GASPI_ERROR(gaspi_notify(J_SEGMENT_ID, adj_ranks[GRID_LEFT], notif_id, COMM_CURRENT_ACK,
 	                               queue, GASPI_BLOCK));
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 
 void current_send_gc_y(t_current *current, const int region_id, const gaspi_rank_t adj_ranks[4])
 {
+	const uint64_t t0 = timer_ticks();
 	int remote_offset;
 	const int nrow = current->nrow;
 
@@ -423,11 +437,14 @@ void current_send_gc_y(t_current *current, const int region_id, const gaspi_rank
 		        queue,															// Queue
 		        GASPI_BLOCK));													// Timeout in ms
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 // Each region is only responsible to do the reduction operation in its bottom edge
 void current_reduction_y(t_current *current, const int region_id, const gaspi_rank_t adj_ranks[4])
 {
+	const uint64_t t0 = timer_ticks();
 	const unsigned int queue = get_gaspi_queue(region_id);
 
 	const int nrow = current->nrow;
@@ -482,6 +499,8 @@ void current_reduction_y(t_current *current, const int region_id, const gaspi_ra
 		CHECK_GASPI_ERROR(gaspi_notify(J_SEGMENT_ID, adj_ranks[GRID_UP], notif_id,
 		                               COMM_CURRENT_ACK, queue, GASPI_BLOCK));
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 
@@ -579,6 +598,7 @@ void kernel_y(t_current *const current, const t_fld sa, const t_fld sb)
 // Or, apply a compensation filter (if applicable)
 void current_smooth_x(t_current *current, enum smooth_type type)
 {
+	const uint64_t t0 = timer_ticks();
 	// filter kernel [sa, sb, sa]
 	t_fld sa, sb;
 
@@ -594,12 +614,15 @@ void current_smooth_x(t_current *current, enum smooth_type type)
 		default:
 			break;
 	}
+
+	timer_phase_add(TIMER_FILTER, t0);
 }
 
 // Apply a binomial filter to reduce noise (Y direction).
 // Or, apply a compensation filter (if applicable)
 void current_smooth_y(t_current *current, enum smooth_type type)
 {
+	const uint64_t t0 = timer_ticks();
 	// filter kernel [sa, sb, sa]
 	t_fld sa, sb;
 
@@ -615,6 +638,8 @@ void current_smooth_y(t_current *current, enum smooth_type type)
 		default:
 			break;
 	}
+
+	timer_phase_add(TIMER_FILTER, t0);
 }
 
 /*********************************************************************************************
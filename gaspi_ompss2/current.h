@@ -17,6 +17,7 @@
 
 #include "utilities.h"
 #include "zpic.h"
+#include "task_priority.h"
 
 enum smooth_type {
 	NONE, BINOMIAL, COMPENSATED
@@ -89,41 +90,49 @@ void current_report(const float *restrict global_buffer, const int iter_num, con
 
 // CPU Tasks
 #pragma oss task label("Current Reset") \
-	out(current->J_buf[0; current->total_size])
+	out(current->J_buf[0; current->total_size]) \
+	priority(task_priority[TASK_CURRENT_RESET])
 void current_zero(t_current *current);
 
 #pragma oss task label("Current Send X") \
-	in(current->J_buf[0; current->total_size])
+	in(current->J_buf[0; current->total_size]) \
+	priority(task_priority[TASK_CURRENT_SEND_X])
 void current_send_gc_x(t_current *current, const int region_id,
                        const gaspi_rank_t adj_ranks[NUM_ADJ_GRID]);
 
 #pragma oss task label("Current Reduction X") \
-	inout(current->J_buf[0; current->total_size])
+	inout(current->J_buf[0; current->total_size]) \
+	priority(task_priority[TASK_CURRENT_REDUCTION_X])
 void current_reduction_x(t_current *current, const int region_id,
                          gaspi_rank_t adj_ranks[NUM_ADJ_GRID]);
 
 #pragma oss task label("Current Update GC X") \
-	inout(current->J_buf[0; current->total_size])
+	inout(current->J_buf[0; current->total_size]) \
+	priority(task_priority[TASK_CURRENT_UPDATE_GC_X])
 void current_update_gc_x(t_current *current, const int region_id,
                          gaspi_rank_t adj_ranks[NUM_ADJ_GRID]);
 
 #pragma oss task label("Current Filter X") \
-	inout(current->J_buf[0; current->total_size])
+	inout(current->J_buf[0; current->total_size]) \
+	priority(task_priority[TASK_CURRENT_FILTER_X])
 void current_smooth_x(t_current *current, enum smooth_type type);
 
 #pragma oss task label("Current Send Y") \
-	inout(current->J_buf[0; current->total_size])
+	inout(current->J_buf[0; current->total_size]) \
+	priority(task_priority[TASK_CURRENT_SEND_Y])
 void current_send_gc_y(t_current *current, const int region_id,
                        const gaspi_rank_t adj_ranks[NUM_ADJ_GRID]);
 
 #pragma oss task label("Current Reduction Y") \
 	inout(current->J_buf[0; current->overlap_size]) \
-	inout(current->receive_J[GRID_DOWN][0; current->overlap_size])
+	inout(current->receive_J[GRID_DOWN][0; current->overlap_size]) \
+	priority(task_priority[TASK_CURRENT_REDUCTION_Y])
 void current_reduction_y(t_current *current, const int region_id,
                          const gaspi_rank_t adj_ranks[NUM_ADJ_GRID]);
 
 #pragma oss task label("Current Filter Y") \
-	inout(current->J_buf[0; current->total_size])
+	inout(current->J_buf[0; current->total_size]) \
+	priority(task_priority[TASK_CURRENT_FILTER_Y])
 void current_smooth_y(t_current *current, enum smooth_type type);
 
 #endif
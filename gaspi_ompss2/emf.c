@@ -20,11 +20,10 @@
 #include "timer.h"
 #include "task_management.h"
 
-static double _emf_time = 0.0;
 
 double emf_time(void)
 {
-	return _emf_time;
+	return timer_phase_seconds(TIMER_SOLVE);
 }
 
 /*********************************************************************************************
@@ -522,6 +521,7 @@ void emf_add_remote_offset(t_emf *emf, const int region_id, const bool first_reg
 
 void emf_send_gc_x(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks[NUM_ADJ_GRID])
 {
+	const uint64_t t0 = timer_ticks();
 	const unsigned int queue = get_gaspi_queue(region_id);
 
 	t_vfld *restrict E = emf->E;
@@ -608,10 +608,13 @@ void emf_send_gc_x(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks
 		        queue,														// Queue
 		        GASPI_BLOCK));												// Timeout in ms
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 void emf_update_gc_x(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks[4])
 {
+	const uint64_t t0 = timer_ticks();
 	const unsigned int queue = get_gaspi_queue(region_id);
 
 	const int nrow = emf->nrow;
@@ -680,10 +683,13 @@ void emf_update_gc_x(t_emf *emf, const int region_id, const gaspi_rank_t adj_ran
 	notif_id = NOTIFICATION_ID(GRID_RIGHT, region_id, NOTIF_ID_EMF_ACK);
 	CHECK_GASPI_ERROR(gaspi_notify(B_SEGMENT_ID, adj_ranks[GRID_LEFT], notif_id, COMM_EMF_ACK,
 	                               queue, GASPI_BLOCK));
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 void emf_send_gc_y(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks[NUM_ADJ_GRID])
 {
+	const uint64_t t0 = timer_ticks();
 	const unsigned int queue = get_gaspi_queue(region_id);
 
 	int remote_offset;
@@ -761,10 +767,13 @@ void emf_send_gc_y(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks
 		        queue,													// Queue
 		        GASPI_BLOCK));											// Timeout in ms
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 void emf_update_gc_y(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks[4])
 {
+	const uint64_t t0 = timer_ticks();
 	const unsigned int queue = get_gaspi_queue(region_id);
 
 	t_vfld *restrict E = emf->E_buf;
@@ -809,6 +818,8 @@ void emf_update_gc_y(t_emf *emf, const int region_id, const gaspi_rank_t adj_ran
 		CHECK_GASPI_ERROR(gaspi_notify(B_SEGMENT_ID, adj_ranks[GRID_DOWN], notif_id,
 		                               COMM_EMF_ACK, queue, GASPI_BLOCK));
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 void emf_update_gc_serial(t_vfld *restrict E, t_vfld *restrict B, const int nx[2], const int nrow,
@@ -969,6 +980,7 @@ void yee_e(t_emf *emf, const t_current *current, const float dt)
 // Perform the local integration of the fields (and post processing)
 void emf_advance(t_emf *emf, const t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const float dt = emf->dt;
 
 	// Advance EM field using Yee algorithm modified for having E and B time centered
@@ -982,5 +994,7 @@ void emf_advance(t_emf *emf, const t_current *current)
 	emf->shift_window_iter = false;
 	if (emf->moving_window)
 		emf_move_window(emf);
+
+	timer_phase_add(TIMER_SOLVE, t0);
 }
 
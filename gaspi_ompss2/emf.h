@@ -113,17 +113,20 @@ void emf_report(const float *restrict global_buffer, const float box[2], const i
 #pragma oss task  label("EMF Advance") \
 	in(current->J_buf[0; current->total_size]) \
 	inout(emf->E_buf[0; emf->total_size]) \
-	inout(emf->B_buf[0; emf->total_size])
+	inout(emf->B_buf[0; emf->total_size]) \
+	priority(task_priority[TASK_EMF_ADVANCE])
 void emf_advance(t_emf *emf, const t_current *current);
 
 #pragma oss task  label("EMF Update GC X") \
 	inout(emf->E_buf[0; emf->total_size]) \
-	inout(emf->B_buf[0; emf->total_size])
+	inout(emf->B_buf[0; emf->total_size]) \
+	priority(task_priority[TASK_EMF_UPDATE_GC_X])
 void emf_update_gc_x(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks[4]);
 
 #pragma oss task  label("EMF Send X") \
 	inout(emf->E_buf[0; emf->total_size]) \
-	inout(emf->B_buf[0; emf->total_size])
+	inout(emf->B_buf[0; emf->total_size]) \
+	priority(task_priority[TASK_EMF_SEND_X])
 void emf_send_gc_x(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks[NUM_ADJ_GRID]);
 
 #pragma oss task  label("EMF Update GC Y") \
@@ -134,12 +137,14 @@ void emf_send_gc_x(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks
 	inout(emf->E_buf[0; emf->gc[1][0] * emf->nrow]) \
 	inout(emf->B_buf[0; emf->gc[1][0] * emf->nrow]) \
 	inout(emf->E[emf->nx[1] * emf->nrow; emf->gc[1][1] * emf->nrow]) \
-	inout(emf->B[emf->nx[1] * emf->nrow; emf->gc[1][1] * emf->nrow])
+	inout(emf->B[emf->nx[1] * emf->nrow; emf->gc[1][1] * emf->nrow]) \
+	priority(task_priority[TASK_EMF_UPDATE_GC_Y])
 void emf_update_gc_y(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks[4]);
 
 #pragma oss task  label("EMF Send Y") \
 	inout(emf->E_buf[0; emf->total_size]) \
-	inout(emf->B_buf[0; emf->total_size])
+	inout(emf->B_buf[0; emf->total_size]) \
+	priority(task_priority[TASK_EMF_SEND_Y])
 void emf_send_gc_y(t_emf *emf, const int region_id, const gaspi_rank_t adj_ranks[NUM_ADJ_GRID]);
 
 void emf_update_gc_serial(t_vfld *restrict E, t_vfld *restrict B, const int nx[2], const int nrow,
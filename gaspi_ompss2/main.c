@@ -34,7 +34,11 @@
 #include "timer.h"
 
 // Simulation parameters (naming scheme : <type>-<number of particles>-<grid size x>-<grid size y>.c)
+#ifdef INPUT
+#include INPUT
+#else
 #include "input/lwfa-4000-16M-2000-512.c"
+#endif
 //#include "input/lwfa-8000-32M-4000-2048.c"
 // #include "input/weibel-1000-604M-4096-4096.c"
 //#include "input/weibel-500-151M-1024-1024.c"
@@ -95,6 +99,10 @@ int main(int argc, const char *argv[])
 #endif
 
 	CHECK_GASPI_ERROR(gaspi_barrier(GASPI_GROUP_ALL, GASPI_BLOCK));
+	const uint64_t t1 = timer_ticks();
+
+	t_phase_timings timings;
+	sim_reduce_timings(&sim, &timings);
 
 	if(sim.proc_rank == ROOT)
 	{
@@ -103,7 +111,7 @@ int main(int argc, const char *argv[])
 #endif
 
 		// Simulation times
-		sim_timings(&sim, t0, timer_ticks());
+		sim_timings(&sim, t0, t1, &timings);
 	}
 
 	// Cleanup data
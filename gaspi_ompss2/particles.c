@@ -423,6 +423,7 @@ void spec_merge_vectors(t_part_vector *dest, t_part_vector *source)
 void spec_send_particles(t_species *spec, const int region_id, const int spec_id,
                          gaspi_rank_t adj_ranks[NUM_ADJ_PART])
 {
+	const uint64_t t0 = timer_ticks();
 	const unsigned int queue = get_gaspi_queue(region_id);
 
 	if (spec->gaspi_segm_offset_recv[PART_DOWN_LEFT] < 0)
@@ -505,11 +506,14 @@ void spec_send_particles(t_species *spec, const int region_id, const int spec_id
 			}
 		}
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 void spec_receive_particles(t_species *spec, const int region_id, const int spec_id,
                             const gaspi_rank_t adj_ranks[8])
 {
+	const uint64_t t0 = timer_ticks();
 	int np_inj = 0;
 	const unsigned int queue = get_gaspi_queue(region_id);
 
@@ -596,6 +600,8 @@ void spec_receive_particles(t_species *spec, const int region_id, const int spec
 	for (int i = 0; i < spec->main_vector.size; ++i)
 		if (spec->main_vector.data[i].invalid)
 			spec->main_vector.data[i--] = spec->main_vector.data[--spec->main_vector.size];
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 /*********************************************************************************************
@@ -883,6 +889,7 @@ void interpolate_fld(const t_vfld *restrict const E, const t_vfld *restrict cons
 void spec_advance(t_species *spec, const t_emf *emf, t_current *current,
                   const int region_limits[2][2], const int sim_nx[2])
 {
+	const uint64_t t0 = timer_ticks();
 	const t_part_data tem = 0.5 * spec->dt / spec->m_q;
 	const t_part_data dt_dx = spec->dt / spec->dx[0];
 	const t_part_data dt_dy = spec->dt / spec->dx[1];
@@ -1046,6 +1053,8 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current,
 		spec_inject_particles(&spec->main_vector, range, region_limits, spec->ppc, &spec->density,
 		                      spec->dx, spec->n_move, spec->ufl, spec->uth);
 	}
+
+	timer_phase_add(TIMER_PUSH, t0);
 }
 
 /*********************************************************************************************
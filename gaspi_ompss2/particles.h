@@ -130,7 +130,8 @@ void spec_delete(t_species *spec);
 	out(*spec->outgoing_part[PART_DOWN]) \
 	out(*spec->outgoing_part[PART_DOWN_LEFT]) \
 	out(*spec->outgoing_part[PART_DOWN_RIGHT]) \
-	inout(current->J_buf[0; current->total_size])
+	inout(current->J_buf[0; current->total_size]) \
+	priority(task_priority[TASK_SPEC_ADVANCE])
 void spec_advance(t_species *spec, const t_emf *emf, t_current *current,
                   const int region_limits[2][2], const int sim_nx[2]);
 
@@ -139,13 +140,15 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current,
 	inout(spec->incoming_part[PART_DOWN_LEFT]) \
 	inout(spec->incoming_part[PART_DOWN_RIGHT]) \
 	inout(spec->incoming_part[PART_UP_LEFT]) \
-	inout(spec->incoming_part[PART_UP_RIGHT])
+	inout(spec->incoming_part[PART_UP_RIGHT]) \
+	priority(task_priority[TASK_SPEC_SEND])
 void spec_send_particles(t_species *spec, const int region_id, const int spec_id,
                          gaspi_rank_t adj_ranks[8]);
 
 #pragma oss task label("Spec Receive") \
 	inout(spec->main_vector) \
-	in(spec->incoming_part[0:7])
+	in(spec->incoming_part[0:7]) \
+	priority(task_priority[TASK_SPEC_RECEIVE])
 void spec_receive_particles(t_species *spec, const int region_id, const int spec_id,
                             const gaspi_rank_t adj_ranks[8]);
 
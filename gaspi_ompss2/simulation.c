@@ -214,6 +214,7 @@ void sim_new(t_simulation *sim, int nx[2], float box[2], float dt, float tmax, i
 	strncpy(sim->name, name, 64);
 	sim->iter = 0;
 	sim->moving_window = false;
+	sim_set_task_priority(sim, TASK_PRIORITY_DEPTH);
 	sim->dt = dt;
 	sim->tmax = tmax;
 	sim->ndump = ndump;
@@ -415,6 +416,13 @@ void sim_set_smooth(t_simulation *sim, t_smooth *smooth)
 		sim->regions[i].local_current.smooth = *smooth;
 }
 
+// Select how the priorities of the tasks are set (see task_priority.h)
+void sim_set_task_priority(t_simulation *sim, const enum task_priority_policy policy)
+{
+	sim->priority = policy;
+	task_priority_set_policy(policy);
+}
+
 void sim_set_moving_window(t_simulation *sim)
 {
 	sim->moving_window = true;
@@ -538,7 +546,23 @@ int report(int n, int ndump)
 	}
 }
 
-void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1)
+// Reduce the phase timings of all processes (sum and slowest worker)
+void sim_reduce_timings(t_simulation *sim, t_phase_timings *timings)
+{
+	t_phase_timings local;
+	timer_phase_collect(&local);
+
+	CHECK_GASPI_ERROR(gaspi_allreduce(local.total, timings->total, TIMER_N_PHASES, GASPI_OP_SUM,
+	                                  GASPI_TYPE_DOUBLE, GASPI_GROUP_ALL, GASPI_BLOCK));
+	CHECK_GASPI_ERROR(gaspi_allreduce(local.max, timings->max, TIMER_N_PHASES, GASPI_OP_MAX,
+	                                  GASPI_TYPE_DOUBLE, GASPI_GROUP_ALL, GASPI_BLOCK));
+	CHECK_GASPI_ERROR(gaspi_allreduce(local.count, timings->count, TIMER_N_PHASES, GASPI_OP_SUM,
+	                                  GASPI_TYPE_ULONG, GASPI_GROUP_ALL, GASPI_BLOCK));
+	CHECK_GASPI_ERROR(gaspi_allreduce(&local.n_workers, &timings->n_workers, 1, GASPI_OP_SUM,
+	                                  GASPI_TYPE_INT, GASPI_GROUP_ALL, GASPI_BLOCK));
+}
+
+void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1, const t_phase_timings *timings)
 {
 	int npart = 0;
 
@@ -553,23 +577,17 @@ void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1)
 			npart += sim->regions[j].species[i].main_vector.size;
 
 #ifndef TEST
+	static const char *priority_names[] = {"none", "fixed", "depth"};
+
 	fprintf(stdout, "Topology: %d x %d\n", sim->num_procs_cart[0], sim->num_procs_cart[1]);
 	fprintf(stdout, "Simulation: %s\n", sim->name);
 	fprintf(stdout, "Number of regions: %d\n", sim->n_regions);
 	fprintf(stdout, "Number of processes: %d\n", sim->num_procs);
 	fprintf(stdout, "Number of threads per process: %d\n", num_threads);
-//	fprintf(stdout, "Time for spec. advance = %f s\n", spec_time() / n_threads); // Disable due to compatibility issues
-//	fprintf(stdout, "Time for emf   advance = %f s\n", emf_time() / n_threads); // Disable due to compatibility issues
+	fprintf(stdout, "Task priorities: %s\n", priority_names[sim->priority]);
 	fprintf(stdout, "Total simulation time  = %f s\n", timer_interval_seconds(t0, t1));
-	fprintf(stdout, "\n");
 
-	// Disable due to compatibility issues
-//	if (spec_time() > 0)
-//	{
-//		double perf = spec_perf();
-//		fprintf(stderr, "Particle advance [nsec/part] = %f \n", 1.e9 * perf);
-//		fprintf(stderr, "Particle advance [Mpart/sec] = %f \n", 1.e-6 / perf);
-//	}
+	timer_phase_report(timings);
 
 #else
 	printf("%s,%d,%d,%d,%f\n", sim->name, sim->num_procs, num_threads, sim->n_regions, timer_interval_seconds(t0, t1));
@@ -674,7 +692,7 @@ void sim_report_grid_zdf(t_simulation *sim, enum report_grid_type type, const in
 
 // Save a particle property to a ZDF file
 void sim_report_spec_zdf(t_simulation *sim, const int species, const int rep_type,
-                         const int pha_nx[2], const float pha_range[][2])
+                         const int pha_nx[], const float pha_range[][2])
 {
 	char path[128] = "";
 	sprintf(path, "output/%s/%s", sim->name, sim->regions->species[species].name);
@@ -17,6 +17,7 @@
 
 #include "utilities.h"
 #include "zdf.h"
+#include "timer.h"
 #include "task_management.h"
 
 static MPI_Datatype MPI_VFLD = MPI_DATATYPE_NULL;
@@ -107,11 +108,14 @@ void current_delete(t_current *current)
 // Set the current buffer to zero
 void current_zero(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	current->iter++;
 
 	// zero fields
 	size_t size = current->nrow * current->ncol;
 	memset(current->J_buf, 0, size * sizeof(t_vfld));
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 /*********************************************************************************************
@@ -170,6 +174,7 @@ void current_link_adj_regions(t_current *current, t_current *current_down, t_cur
 
 void current_exchange_gc_x(t_current *current, const int region_id, const unsigned int adj_ranks[4])
 {
+	const uint64_t t0 = timer_ticks();
 	const int segm_nrow = current->gc[0][0] + current->gc[0][1];
 	const int nrow = current->nrow;
 
@@ -226,10 +231,13 @@ void current_exchange_gc_x(t_current *current, const int region_id, const unsign
 		                          MPI_COMM_WORLD,
 		                          &current->mpi_requests[current->num_mpi_requests++]));
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 void current_reduction_x(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = current->nrow;
 	const int segm_nrow = current->gc[0][0] + current->gc[0][1];
 
@@ -264,10 +272,13 @@ void current_reduction_x(t_current *current)
 			}
 		}
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 void current_update_gc_x(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = current->nrow;
 	const int segm_nrow = current->gc[0][0] + current->gc[0][1];
 
@@ -286,11 +297,14 @@ void current_update_gc_x(t_current *current)
 		for (int j = 0; j < current->ncol; ++j)
 			for (int i = current->gc[0][0]; i < segm_nrow; ++i)
 				J[current->nx[0] + i + j * nrow] = J_right[i + j * segm_nrow];
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 
 void current_exchange_gc_y(t_current *current, const unsigned int adj_ranks[4])
 {
+	const uint64_t t0 = timer_ticks();
 	current->num_mpi_requests = 0;
 	for (int i = 0; i < 4; ++i)
 		current->mpi_requests[i] = MPI_REQUEST_NULL;
@@ -337,11 +351,14 @@ void current_exchange_gc_y(t_current *current, const unsigned int adj_ranks[4])
 		                          MPI_COMM_WORLD,
 		                          &current->mpi_requests[current->num_mpi_requests++]));
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 // Each region is only responsible to do the reduction operation in its bottom edge
 void current_reduction_y(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = current->nrow;
 	t_vfld *restrict const J = current->J_buf;
 	t_vfld *restrict const J_down = current->receive_J[GRID_DOWN];
@@ -373,6 +390,8 @@ void current_reduction_y(t_current *current)
 			}
 		}
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 /*********************************************************************************************
@@ -469,6 +488,7 @@ void kernel_y(t_current *const current, const t_fld sa, const t_fld sb)
 // Or, apply a compensation filter (if applicable)
 void current_smooth_x(t_current *current, enum smooth_type type)
 {
+	const uint64_t t0 = timer_ticks();
 	// filter kernel [sa, sb, sa]
 	t_fld sa, sb;
 
@@ -484,12 +504,15 @@ void current_smooth_x(t_current *current, enum smooth_type type)
 		default:
 			break;
 	}
+
+	timer_phase_add(TIMER_FILTER, t0);
 }
 
 // Apply a binomial filter to reduce noise (Y direction).
 // Or, apply a compensation filter (if applicable)
 void current_smooth_y(t_current *current, enum smooth_type type)
 {
+	const uint64_t t0 = timer_ticks();
 	// filter kernel [sa, sb, sa]
 	t_fld sa, sb;
 
@@ -505,6 +528,8 @@ void current_smooth_y(t_current *current, enum smooth_type type)
 		default:
 			break;
 	}
+
+	timer_phase_add(TIMER_FILTER, t0);
 }
 
 /*********************************************************************************************
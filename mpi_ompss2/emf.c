@@ -20,12 +20,11 @@
 #include "timer.h"
 #include "task_management.h"
 
-static double _emf_time = 0.0;
 static MPI_Datatype MPI_VFLD = MPI_DATATYPE_NULL;
 
 double emf_time(void)
 {
-	return _emf_time;
+	return timer_phase_seconds(TIMER_SOLVE);
 }
 
 /*********************************************************************************************
@@ -499,6 +498,7 @@ void emf_link_adj_regions(t_emf *emf, t_emf *emf_down, t_emf *emf_up)
 
 void emf_exchange_gc_x(t_emf *emf, const int region_id, const unsigned int adj_ranks[NUM_ADJ_GRID])
 {
+	const uint64_t t0 = timer_ticks();
 	t_vfld *restrict E = emf->E;
 	t_vfld *restrict B = emf->B;
 	t_vfld *restrict E_left = emf->send_E[GRID_LEFT];
@@ -600,10 +600,13 @@ void emf_exchange_gc_x(t_emf *emf, const int region_id, const unsigned int adj_r
 		                         MPI_COMM_WORLD,
 		                         &emf->mpi_requests[emf->num_mpi_requests++]));
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 void emf_update_gc_x(t_emf *emf)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = emf->nrow;
 	const int segm_nrow = emf->gc[0][0] + emf->gc[0][1];
 
@@ -652,10 +655,13 @@ void emf_update_gc_x(t_emf *emf)
 			}
 		}
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 void emf_exchange_gc_y(t_emf *emf, const unsigned int adj_ranks[NUM_ADJ_GRID])
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = emf->nrow;
 
 	emf->num_mpi_requests = 0;
@@ -739,10 +745,13 @@ void emf_exchange_gc_y(t_emf *emf, const unsigned int adj_ranks[NUM_ADJ_GRID])
 								 MPI_COMM_WORLD,
 								 &emf->mpi_requests[emf->num_mpi_requests++]));
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 void emf_update_gc_y(t_emf *emf)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = emf->nrow;
 	t_vfld *restrict E = emf->E_buf;
 	t_vfld *restrict B = emf->B_buf;
@@ -760,6 +769,7 @@ void emf_update_gc_y(t_emf *emf)
 	memcpy(B + (emf->gc[1][0] + emf->nx[1]) * nrow, B_up + emf->gc[1][0] * nrow,
 	       emf->gc[1][1] * nrow * sizeof(t_vfld));
 
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 void emf_update_gc_serial(t_vfld *restrict E, t_vfld *restrict B, const int nx[2], const int nrow,
@@ -920,6 +930,7 @@ void yee_e(t_emf *emf, const t_current *current, const float dt)
 // Perform the local integration of the fields (and post processing)
 void emf_advance(t_emf *emf, const t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const float dt = emf->dt;
 
 	// Advance EM field using Yee algorithm modified for having E and B time centered
@@ -933,5 +944,7 @@ void emf_advance(t_emf *emf, const t_current *current)
 	emf->shift_window_iter = false;
 	if (emf->moving_window)
 		emf_move_window(emf);
+
+	timer_phase_add(TIMER_SOLVE, t0);
 }
 
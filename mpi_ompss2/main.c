@@ -49,7 +49,11 @@
 //#include "input/weak/weibel-64n.c"
 //#include "input/weak/weibel-256n.c"
 
+#ifdef INPUT
+#include INPUT
+#else
 #include "input/weak/cold-1n.c"
+#endif
 //#include "input/weak/cold-4n.c"
 //#include "input/weak/cold-16n.c"
 //#include "input/weak/cold-64n.c"
@@ -57,7 +61,7 @@
 
 #pragma oss assert("version.dependencies==regions")
 
-int main(int argc, const char *argv[])
+static int run_simulation(int argc, const char *argv[])
 {
 	if(argc != 2)
 	{
@@ -112,9 +116,16 @@ int main(int argc, const char *argv[])
 
 #ifdef ENABLE_TASKING
 	#pragma oss taskwait
+#ifdef ENABLE_OPENMP_TASKS
+	#pragma omp taskwait
+#endif
 #endif
 
 	CHECK_MPI_ERROR(MPI_Barrier(MPI_COMM_WORLD));
+	const uint64_t t1 = timer_ticks();
+
+	t_phase_timings timings;
+	sim_reduce_timings(&sim, &timings);
 
 	if(sim.proc_rank == ROOT)
 	{
@@ -123,7 +134,7 @@ int main(int argc, const char *argv[])
 #endif
 
 		// Simulation times
-		sim_timings(&sim, t0, timer_ticks());
+		sim_timings(&sim, t0, t1, &timings);
 	}
 
 	// Cleanup data
@@ -132,3 +143,18 @@ int main(int argc, const char *argv[])
 
 	return 0;
 }
+
+int main(int argc, const char *argv[])
+{
+#ifdef ENABLE_OPENMP_TASKS
+	// The OpenMP tasks are created by the master thread of the parallel region, which is also the
+	// one that initializes MPI (in OmpSs-2, the main function is already a task)
+	int ret;
+	#pragma omp parallel
+	#pragma omp master
+	ret = run_simulation(argc, argv);
+	return ret;
+#else
+	return run_simulation(argc, argv);
+#endif
+}
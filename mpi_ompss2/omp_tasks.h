@@ -0,0 +1,261 @@
+/*********************************************************************************************
+ ZPIC
+ omp_tasks.h
+
+ OpenMP version of the OmpSs-2 tasks, for compilers without OmpSs-2 support (GCC, Clang). Each
+ task function is replaced by a wrapper that creates an OpenMP task with the same dependencies
+ and priority. The tasks that wait for MPI requests are preceded by a detached task, completed
+ by the task management when the requests finish. Only included by simulation.c, when compiled
+ with -DENABLE_OPENMP_TASKS (make openmp).
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __OMP_TASKS__
+#define __OMP_TASKS__
+
+#include <omp.h>
+
+#include "simulation.h"
+#include "task_management.h"
+
+// Number of threads executing the tasks (the tasks are created inside the parallel region)
+#define nanos6_get_num_cpus() omp_get_num_threads()
+
+// The OpenMP runtimes match the dependencies by the address of the first element (the length
+// of the array sections is ignored), so the tasks that touch the whole buffer depend on the
+// first element of every section used by the other tasks: the ghost cells shared with the
+// region below (buf[0] and buf[nrow]) and with the region above (equal to receive_*[GRID_DOWN]
+// in the region above, and the upper ghost cells of the field)
+#define CURRENT_DEPS(current) (current)->J_buf[0], \
+	(current)->J_buf[(current)->nx[1] * (current)->nrow]
+
+#define FIELD_DEPS(buf, fld, emf) (buf)[0], (buf)[(emf)->nrow], \
+	(buf)[(emf)->nx[1] * (emf)->nrow], (fld)[(emf)->nx[1] * (emf)->nrow]
+
+#define EMF_DEPS(emf) FIELD_DEPS((emf)->E_buf, (emf)->E, emf), \
+	FIELD_DEPS((emf)->B_buf, (emf)->B, emf)
+
+/*********************************************************************************************
+ Current
+ *********************************************************************************************/
+
+static inline void omp_current_zero(t_current *current)
+{
+	#pragma omp task depend(out: CURRENT_DEPS(current)) \
+		priority(task_priority[TASK_CURRENT_RESET])
+	current_zero(current);
+}
+
+static inline void omp_current_exchange_gc_x(t_current *current, const int region_id,
+		const unsigned int adj_ranks[NUM_ADJ_GRID])
+{
+	#pragma omp task depend(in: CURRENT_DEPS(current)) \
+		priority(task_priority[TASK_CURRENT_SEND_X])
+	current_exchange_gc_x(current, region_id, adj_ranks);
+}
+
+static inline void omp_current_reduction_x(t_current *current)
+{
+	omp_event_handle_t event;
+
+	#pragma omp task detach(event) depend(inout: CURRENT_DEPS(current)) \
+		priority(task_priority[TASK_CURRENT_REDUCTION_X])
+	detach_comm_task(current->mpi_requests, current->num_mpi_requests, event);
+
+	#pragma omp task depend(inout: CURRENT_DEPS(current)) \
+		priority(task_priority[TASK_CURRENT_REDUCTION_X])
+	current_reduction_x(current);
+}
+
+static inline void omp_current_update_gc_x(t_current *current)
+{
+	omp_event_handle_t event;
+
+	#pragma omp task detach(event) depend(inout: CURRENT_DEPS(current)) \
+		priority(task_priority[TASK_CURRENT_UPDATE_GC_X])
+	detach_comm_task(current->mpi_requests, current->num_mpi_requests, event);
+
+	#pragma omp task depend(inout: CURRENT_DEPS(current)) \
+		priority(task_priority[TASK_CURRENT_UPDATE_GC_X])
+	current_update_gc_x(current);
+}
+
+static inline void omp_current_smooth_x(t_current *current, enum smooth_type type)
+{
+	#pragma omp task depend(inout: CURRENT_DEPS(current)) \
+		priority(task_priority[TASK_CURRENT_FILTER_X])
+	current_smooth_x(current, type);
+}
+
+static inline void omp_current_exchange_gc_y(t_current *current,
+		const unsigned int adj_ranks[NUM_ADJ_GRID])
+{
+	#pragma omp task depend(inout: CURRENT_DEPS(current)) \
+		priority(task_priority[TASK_CURRENT_SEND_Y])
+	current_exchange_gc_y(current, adj_ranks);
+}
+
+static inline void omp_current_reduction_y(t_current *current)
+{
+	omp_event_handle_t event;
+
+	#pragma omp task detach(event) \
+		depend(inout: current->J_buf[0], current->receive_J[GRID_DOWN][0]) \
+		priority(task_priority[TASK_CURRENT_REDUCTION_Y])
+	detach_comm_task(current->mpi_requests, current->num_mpi_requests, event);
+
+	#pragma omp task depend(inout: current->J_buf[0], current->receive_J[GRID_DOWN][0]) \
+		priority(task_priority[TASK_CURRENT_REDUCTION_Y])
+	current_reduction_y(current);
+}
+
+static inline void omp_current_smooth_y(t_current *current, enum smooth_type type)
+{
+	#pragma omp task depend(inout: CURRENT_DEPS(current)) \
+		priority(task_priority[TASK_CURRENT_FILTER_Y])
+	current_smooth_y(current, type);
+}
+
+#define current_zero omp_current_zero
+#define current_exchange_gc_x omp_current_exchange_gc_x
+#define current_reduction_x omp_current_reduction_x
+#define current_update_gc_x omp_current_update_gc_x
+#define current_smooth_x omp_current_smooth_x
+#define current_exchange_gc_y omp_current_exchange_gc_y
+#define current_reduction_y omp_current_reduction_y
+#define current_smooth_y omp_current_smooth_y
+
+/*********************************************************************************************
+ EMF
+ *********************************************************************************************/
+
+static inline void omp_emf_advance(t_emf *emf, const t_current *current)
+{
+	#pragma omp task depend(in: CURRENT_DEPS(current)) depend(inout: EMF_DEPS(emf)) \
+		priority(task_priority[TASK_EMF_ADVANCE])
+	emf_advance(emf, current);
+}
+
+static inline void omp_emf_update_gc_x(t_emf *emf)
+{
+	omp_event_handle_t event;
+
+	#pragma omp task detach(event) depend(inout: EMF_DEPS(emf)) \
+		priority(task_priority[TASK_EMF_UPDATE_GC_X])
+	detach_comm_task(emf->mpi_requests, emf->num_mpi_requests, event);
+
+	#pragma omp task depend(inout: EMF_DEPS(emf)) \
+		priority(task_priority[TASK_EMF_UPDATE_GC_X])
+	emf_update_gc_x(emf);
+}
+
+static inline void omp_emf_exchange_gc_x(t_emf *emf, const int region_id,
+		const unsigned int adj_ranks[NUM_ADJ_GRID])
+{
+	#pragma omp task depend(inout: EMF_DEPS(emf)) \
+		priority(task_priority[TASK_EMF_SEND_X])
+	emf_exchange_gc_x(emf, region_id, adj_ranks);
+}
+
+static inline void omp_emf_update_gc_y(t_emf *emf)
+{
+	omp_event_handle_t event;
+
+	#pragma omp task detach(event) \
+		depend(inout: emf->receive_E[GRID_DOWN][0], emf->receive_B[GRID_DOWN][0]) \
+		depend(inout: emf->receive_E[GRID_UP][emf->nrow], emf->receive_B[GRID_UP][emf->nrow]) \
+		depend(inout: emf->E_buf[0], emf->B_buf[0]) \
+		depend(inout: emf->E[emf->nx[1] * emf->nrow], emf->B[emf->nx[1] * emf->nrow]) \
+		priority(task_priority[TASK_EMF_UPDATE_GC_Y])
+	detach_comm_task(emf->mpi_requests, emf->num_mpi_requests, event);
+
+	#pragma omp task depend(inout: emf->receive_E[GRID_DOWN][0], emf->receive_B[GRID_DOWN][0]) \
+		depend(inout: emf->receive_E[GRID_UP][emf->nrow], emf->receive_B[GRID_UP][emf->nrow]) \
+		depend(inout: emf->E_buf[0], emf->B_buf[0]) \
+		depend(inout: emf->E[emf->nx[1] * emf->nrow], emf->B[emf->nx[1] * emf->nrow]) \
+		priority(task_priority[TASK_EMF_UPDATE_GC_Y])
+	emf_update_gc_y(emf);
+}
+
+static inline void omp_emf_exchange_gc_y(t_emf *emf, const unsigned int adj_ranks[NUM_ADJ_GRID])
+{
+	#pragma omp task depend(inout: EMF_DEPS(emf)) \
+		priority(task_priority[TASK_EMF_SEND_Y])
+	emf_exchange_gc_y(emf, adj_ranks);
+}
+
+#define emf_advance omp_emf_advance
+#define emf_update_gc_x omp_emf_update_gc_x
+#define emf_exchange_gc_x omp_emf_exchange_gc_x
+#define emf_update_gc_y omp_emf_update_gc_y
+#define emf_exchange_gc_y omp_emf_exchange_gc_y
+
+/*********************************************************************************************
+ Particles
+ *********************************************************************************************/
+
+static inline void omp_spec_advance(t_species *spec, const t_emf *emf, t_current *current,
+		const int region_limits[2][2], const int sim_nx[2])
+{
+	#pragma omp task depend(in: EMF_DEPS(emf)) \
+		depend(inout: spec->main_vector, CURRENT_DEPS(current)) \
+		depend(out: *spec->outgoing_part[PART_UP], *spec->outgoing_part[PART_UP_LEFT]) \
+		depend(out: *spec->outgoing_part[PART_UP_RIGHT], *spec->outgoing_part[PART_DOWN]) \
+		depend(out: *spec->outgoing_part[PART_DOWN_LEFT], *spec->outgoing_part[PART_DOWN_RIGHT]) \
+		priority(task_priority[TASK_SPEC_ADVANCE])
+	spec_advance(spec, emf, current, region_limits, sim_nx);
+}
+
+static inline void omp_spec_send_outgoing_np(t_species *spec, const int region_id,
+		const int spec_id, unsigned int adj_ranks[NUM_ADJ_PART])
+{
+	#pragma omp task depend(inout: spec->main_vector) \
+		depend(in: spec->incoming_part[PART_DOWN_LEFT], spec->incoming_part[PART_DOWN_RIGHT]) \
+		depend(in: spec->incoming_part[PART_UP_LEFT], spec->incoming_part[PART_UP_RIGHT]) \
+		priority(task_priority[TASK_SPEC_SEND_NP])
+	spec_send_outgoing_np(spec, region_id, spec_id, adj_ranks);
+}
+
+static inline void omp_spec_send_particles(t_species *spec, const int region_id,
+		const int spec_id, unsigned int adj_ranks[NUM_ADJ_PART])
+{
+	omp_event_handle_t event;
+
+	#pragma omp task detach(event) depend(inout: spec->main_vector) \
+		depend(in: spec->incoming_part[PART_DOWN_LEFT], spec->incoming_part[PART_DOWN_RIGHT]) \
+		depend(in: spec->incoming_part[PART_UP_LEFT], spec->incoming_part[PART_UP_RIGHT]) \
+		priority(task_priority[TASK_SPEC_SEND_PARTICLES])
+	detach_comm_task(spec->mpi_requests_np, spec->num_requests_np, event);
+
+	#pragma omp task depend(inout: spec->main_vector) \
+		depend(in: spec->incoming_part[PART_DOWN_LEFT], spec->incoming_part[PART_DOWN_RIGHT]) \
+		depend(in: spec->incoming_part[PART_UP_LEFT], spec->incoming_part[PART_UP_RIGHT]) \
+		priority(task_priority[TASK_SPEC_SEND_PARTICLES])
+	spec_send_particles(spec, region_id, spec_id, adj_ranks);
+}
+
+static inline void omp_spec_receive_particles(t_species *spec)
+{
+	omp_event_handle_t event;
+
+	#pragma omp task detach(event) depend(inout: spec->main_vector) \
+		depend(in: spec->incoming_part[PART_DOWN_LEFT], spec->incoming_part[PART_DOWN_RIGHT]) \
+		depend(in: spec->incoming_part[PART_UP_LEFT], spec->incoming_part[PART_UP_RIGHT]) \
+		priority(task_priority[TASK_SPEC_RECEIVE])
+	detach_comm_task(spec->mpi_requests_part, spec->num_requests_part, event);
+
+	#pragma omp task depend(inout: spec->main_vector) \
+		depend(in: spec->incoming_part[PART_DOWN_LEFT], spec->incoming_part[PART_DOWN_RIGHT]) \
+		depend(in: spec->incoming_part[PART_UP_LEFT], spec->incoming_part[PART_UP_RIGHT]) \
+		priority(task_priority[TASK_SPEC_RECEIVE])
+	spec_receive_particles(spec);
+}
+
+#define spec_advance omp_spec_advance
+#define spec_send_outgoing_np omp_spec_send_outgoing_np
+#define spec_send_particles omp_spec_send_particles
+#define spec_receive_particles omp_spec_receive_particles
+
+#endif
@@ -26,7 +26,6 @@
 
 static MPI_Datatype MPI_PART = MPI_DATATYPE_NULL;
 
-static double _spec_time = 0.0;
 static double _spec_npush = 0.0;
 
 /**
@@ -35,7 +34,7 @@ static double _spec_npush = 0.0;
  */
 double spec_time(void)
 {
-	return _spec_time;
+	return timer_phase_seconds(TIMER_PUSH);
 }
 
 /**
@@ -44,7 +43,7 @@ double spec_time(void)
  */
 double spec_perf(void)
 {
-	return (_spec_npush > 0) ? _spec_time / _spec_npush : 0.0;
+	return (_spec_npush > 0) ? spec_time() / _spec_npush : 0.0;
 }
 
 /*********************************************************************************************
@@ -425,6 +424,7 @@ void spec_merge_vectors(t_part_vector *dest, t_part_vector *source)
 void spec_send_outgoing_np(t_species *spec, const int region_id, const int spec_id,
                            unsigned int adj_ranks[NUM_ADJ_PART])
 {
+	const uint64_t t0 = timer_ticks();
 	spec->num_requests_np = 0;
 	for (int i = 0; i < 16; ++i)
 		spec->mpi_requests_np[i] = MPI_REQUEST_NULL;
@@ -489,11 +489,14 @@ void spec_send_outgoing_np(t_species *spec, const int region_id, const int spec_
 			                          &spec->mpi_requests_np[spec->num_requests_np++]));
 		}
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 void spec_send_particles(t_species *spec, const int region_id, const int spec_id,
                          unsigned int adj_ranks[NUM_ADJ_PART])
 {
+	const uint64_t t0 = timer_ticks();
 	int np_inj = 0;
 
 	mpi_wait_async_comm(spec->mpi_requests_np, spec->num_requests_np);
@@ -555,11 +558,14 @@ void spec_send_particles(t_species *spec, const int region_id, const int spec_id
 		realloc_vector((void**) &spec->main_vector.data, spec->main_vector.size,
 		               spec->main_vector.size_max, sizeof(t_part));
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 
 void spec_receive_particles(t_species *spec)
 {
+	const uint64_t t0 = timer_ticks();
 	mpi_wait_async_comm(spec->mpi_requests_part, spec->num_requests_part);
 
 	// Add the incoming particles to the main particle buffer
@@ -570,6 +576,8 @@ void spec_receive_particles(t_species *spec)
 	for (int i = 0; i < spec->main_vector.size; ++i)
 		if (spec->main_vector.data[i].invalid)
 			spec->main_vector.data[i--] = spec->main_vector.data[--spec->main_vector.size];
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 /*********************************************************************************************
@@ -857,6 +865,7 @@ void interpolate_fld(const t_vfld *restrict const E, const t_vfld *restrict cons
 void spec_advance(t_species *spec, const t_emf *emf, t_current *current,
                   const int region_limits[2][2], const int sim_nx[2])
 {
+	const uint64_t t0 = timer_ticks();
 	const t_part_data tem = 0.5 * spec->dt / spec->m_q;
 	const t_part_data dt_dx = spec->dt / spec->dx[0];
 	const t_part_data dt_dy = spec->dt / spec->dx[1];
@@ -1020,6 +1029,8 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current,
 		spec_inject_particles(&spec->main_vector, range, region_limits, spec->ppc, &spec->density,
 		                      spec->dx, spec->n_move, spec->ufl, spec->uth);
 	}
+
+	timer_phase_add(TIMER_PUSH, t0);
 }
 
 /*********************************************************************************************
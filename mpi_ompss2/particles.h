@@ -130,7 +130,8 @@ double spec_perf(void);
 		out(*spec->outgoing_part[PART_DOWN]) \
 		out(*spec->outgoing_part[PART_DOWN_LEFT]) \
 		out(*spec->outgoing_part[PART_DOWN_RIGHT]) \
-		inout(current->J_buf[0; current->total_size])
+		inout(current->J_buf[0; current->total_size]) \
+		priority(task_priority[TASK_SPEC_ADVANCE])
 void spec_advance(t_species *spec, const t_emf *emf, t_current *current,
                   const int region_limits[2][2], const int sim_nx[2]);
 
@@ -139,7 +140,8 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current,
 		in(spec->incoming_part[PART_DOWN_LEFT]) \
 		in(spec->incoming_part[PART_DOWN_RIGHT]) \
 		in(spec->incoming_part[PART_UP_LEFT]) \
-		in(spec->incoming_part[PART_UP_RIGHT])
+		in(spec->incoming_part[PART_UP_RIGHT]) \
+		priority(task_priority[TASK_SPEC_SEND_NP])
 void spec_send_outgoing_np(t_species *spec, const int region_id, const int spec_id,
                            unsigned int adj_ranks[NUM_ADJ_PART]);
 
@@ -148,7 +150,8 @@ void spec_send_outgoing_np(t_species *spec, const int region_id, const int spec_
 		in(spec->incoming_part[PART_DOWN_LEFT]) \
 		in(spec->incoming_part[PART_DOWN_RIGHT]) \
 		in(spec->incoming_part[PART_UP_LEFT]) \
-		in(spec->incoming_part[PART_UP_RIGHT])
+		in(spec->incoming_part[PART_UP_RIGHT]) \
+		priority(task_priority[TASK_SPEC_SEND_PARTICLES])
 void spec_send_particles(t_species *spec, const int region_id, const int spec_id,
                          unsigned int adj_ranks[NUM_ADJ_PART]);
 
@@ -157,7 +160,8 @@ void spec_send_particles(t_species *spec, const int region_id, const int spec_id
 		in(spec->incoming_part[PART_DOWN_LEFT]) \
 		in(spec->incoming_part[PART_DOWN_RIGHT]) \
 		in(spec->incoming_part[PART_UP_LEFT]) \
-		in(spec->incoming_part[PART_UP_RIGHT])
+		in(spec->incoming_part[PART_UP_RIGHT]) \
+		priority(task_priority[TASK_SPEC_RECEIVE])
 void spec_receive_particles(t_species *spec);
 
 /*********************************************************************************************
@@ -15,6 +15,7 @@
 #include <stdint.h>
 
 #include "utilities.h"
+#include "timer.h"
 #include "region.h"
 #include "particles.h"
 #include "emf.h"
@@ -56,6 +57,9 @@ typedef struct {
 	int proc_nx[2];
 	float proc_box[2];
 
+	// Policy for the priority of the tasks
+	enum task_priority_policy priority;
+
 	int n_regions;
 	t_region *regions;
 
@@ -69,6 +73,7 @@ void sim_new(t_simulation *sim, int nx[2], float box[2], float dt, float tmax, i
 void sim_init(t_simulation *sim, int n_regions);
 void sim_set_moving_window(t_simulation *sim);
 void sim_set_smooth(t_simulation *sim, t_smooth *smooth);
+void sim_set_task_priority(t_simulation *sim, const enum task_priority_policy policy);
 void sim_add_laser(t_simulation *sim, t_emf_laser *laser);
 void sim_delete(t_simulation *sim);
 
@@ -79,7 +84,8 @@ void sim_iter(t_simulation *sim);
 int report(int n, int ndump);
 void sim_report(t_simulation *sim);
 void sim_report_energy(t_simulation *sim);
-void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1);
+void sim_reduce_timings(t_simulation *sim, t_phase_timings *timings);
+void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1, const t_phase_timings *timings);
 //void sim_region_timings(t_simulation *sim);
 void sim_report_grid_zdf(t_simulation *sim, enum report_grid_type type, const int coord);
 void sim_report_spec_zdf(t_simulation *sim, const int species, const int rep_type, const int pha_nx[],
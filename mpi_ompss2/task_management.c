@@ -2,6 +2,128 @@
 
 #ifdef ENABLE_TASKING
 
+#ifdef ENABLE_OPENMP_TASKS
+
+/*********************************************************************************************
+ OpenMP tasks
+ *********************************************************************************************/
+
+// The task that consumes the data of a communication depends on a detached task, which is only
+// completed (omp_fulfill_event) when all the MPI requests have finished. The requests are tested
+// by a progress thread, which replaces the polling service of Nanos6
+
+typedef struct {
+	omp_event_handle_t event;
+	MPI_Request *requests;
+	int num_requests;
+	bool is_blocked;
+} t_comm_task;
+
+static t_comm_task _blocked_tasks[MAX_BLOCKED_TASKS];
+static unsigned int _blocked_tasks_count = 0;
+static pthread_t _progress_thread;
+static bool _stop_progress;
+
+// Checks periodically if the requests from a detached task have finished
+// When this happens, complete the detached task
+static void* progress_comm_tasks(void *data)
+{
+	bool is_blocked;
+	bool stop = false;
+
+	while(!stop)
+	{
+		for (int task_id = 0; task_id < MAX_BLOCKED_TASKS; task_id++)
+		{
+			// Acquire: the task fields are visible once is_blocked is seen
+			is_blocked = __atomic_load_n(&_blocked_tasks[task_id].is_blocked, __ATOMIC_ACQUIRE);
+
+			if(is_blocked)
+			{
+				t_comm_task task = _blocked_tasks[task_id];
+
+				int received = 0;
+				CHECK_MPI_ERROR(MPI_Testall(task.num_requests, task.requests, &received,
+				                            MPI_STATUSES_IGNORE));
+
+				if(received)
+				{
+					__atomic_store_n(&_blocked_tasks[task_id].is_blocked, false, __ATOMIC_RELEASE);
+					omp_fulfill_event(task.event);
+				}
+			}
+		}
+
+		#pragma omp atomic read
+		stop = _stop_progress;
+
+		sched_yield();
+	}
+
+	return NULL;
+}
+
+// Init the task management mechanism
+void init_task_management()
+{
+	for (int task_id = 0; task_id < MAX_BLOCKED_TASKS; task_id++)
+		_blocked_tasks[task_id].is_blocked = false;
+
+	_stop_progress = false;
+	pthread_create(&_progress_thread, NULL, progress_comm_tasks, NULL);
+}
+
+// Delete the task management mechanism
+void delete_task_management()
+{
+	#pragma omp atomic write
+	_stop_progress = true;
+
+	pthread_join(_progress_thread, NULL);
+}
+
+// Complete a detached task when all the requests have finished
+void detach_comm_task(MPI_Request *requests, const int num_requests, omp_event_handle_t event)
+{
+	int id;
+	int received = 1;
+
+	if(num_requests > 0 && requests)
+		CHECK_MPI_ERROR(MPI_Testall(num_requests, requests, &received, MPI_STATUSES_IGNORE));
+
+	if(received)
+	{
+		omp_fulfill_event(event);
+		return;
+	}
+
+	#pragma omp atomic capture
+	id = _blocked_tasks_count++;
+	id = id % MAX_BLOCKED_TASKS;
+
+	if(!__atomic_load_n(&_blocked_tasks[id].is_blocked, __ATOMIC_ACQUIRE))
+	{
+		_blocked_tasks[id].requests = requests;
+		_blocked_tasks[id].num_requests = num_requests;
+		_blocked_tasks[id].event = event;
+
+		// Release: publish the task fields to the progress thread
+		__atomic_store_n(&_blocked_tasks[id].is_blocked, true, __ATOMIC_RELEASE);
+	}else
+	{
+		CHECK_MPI_ERROR(MPI_Waitall(num_requests, requests, MPI_STATUSES_IGNORE));
+		omp_fulfill_event(event);
+	}
+}
+
+// The requests are already finished when the task starts (see detach_comm_task)
+void block_comm_task(MPI_Request *requests, const int num_requests)
+{
+	CHECK_MPI_ERROR(MPI_Waitall(num_requests, requests, MPI_STATUSES_IGNORE));
+}
+
+#else
+
 typedef struct {
 	void *context;
 	MPI_Request *requests;
@@ -21,8 +143,8 @@ static int poolingService(void *data)
 
 	for (int task_id = 0; task_id < MAX_BLOCKED_TASKS; task_id++)
 	{
-		#pragma omp atomic read
-		is_blocked = _blocked_tasks[task_id].is_blocked;
+		// Acquire: the task fields are visible once is_blocked is seen
+		is_blocked = __atomic_load_n(&_blocked_tasks[task_id].is_blocked, __ATOMIC_ACQUIRE);
 
 		if(is_blocked)
 		{
@@ -33,7 +155,7 @@ static int poolingService(void *data)
 
 			if(received)
 			{
-				_blocked_tasks[task_id].is_blocked = false;
+				__atomic_store_n(&_blocked_tasks[task_id].is_blocked, false, __ATOMIC_RELEASE);
 				nanos6_unblock_task(task.context);
 			}
 		}
@@ -65,14 +187,14 @@ void block_comm_task(MPI_Request *requests, const int num_requests)
 	id = _blocked_tasks_count++;
 	id = id % MAX_BLOCKED_TASKS;
 
-	if(!_blocked_tasks[id].is_blocked)
+	if(!__atomic_load_n(&_blocked_tasks[id].is_blocked, __ATOMIC_ACQUIRE))
 	{
 		_blocked_tasks[id].requests = requests;
 		_blocked_tasks[id].num_requests = num_requests;
 		_blocked_tasks[id].context = nanos6_get_current_blocking_context();
 
-		#pragma omp atomic write
-		_blocked_tasks[id].is_blocked = true;
+		// Release: publish the task fields to the polling service
+		__atomic_store_n(&_blocked_tasks[id].is_blocked, true, __ATOMIC_RELEASE);
 
 		nanos6_block_current_task(_blocked_tasks[id].context);
 	}else
@@ -81,4 +203,6 @@ void block_comm_task(MPI_Request *requests, const int num_requests)
 	}
 }
 
+#endif /* ENABLE_OPENMP_TASKS */
+
 #endif
@@ -5,9 +5,16 @@
 
 #ifdef ENABLE_TASKING
 #include <stdbool.h>
-#include <nanos6.h>
 #include <mpi.h>
 
+#ifdef ENABLE_OPENMP_TASKS
+#include <omp.h>
+#include <pthread.h>
+#include <sched.h>
+#else
+#include <nanos6.h>
+#endif
+
 #include "utilities.h"
 
 #define MAX_BLOCKED_TASKS 512
@@ -16,5 +23,9 @@ void init_task_management();
 void delete_task_management();
 void block_comm_task(MPI_Request *requests, const int num_requests);
 
+#ifdef ENABLE_OPENMP_TASKS
+void detach_comm_task(MPI_Request *requests, const int num_requests, omp_event_handle_t event);
+#endif
+
 #endif
 #endif /* _TASK_MANAGEMENT_H_ */
@@ -0,0 +1,98 @@
+/*********************************************************************************************
+ ZPIC
+ task_priority.c
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#include "task_priority.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+int task_priority[TASK_N_TYPES] = {0};
+
+// Dependencies between the tasks of one time step (predecessor, successor), following the
+// order of sim_iter. The filter passes are represented only once
+static const int step_graph[][2] = {
+	{TASK_CURRENT_RESET, TASK_SPEC_ADVANCE},
+	{TASK_SPEC_ADVANCE, TASK_CURRENT_SEND_Y},
+	{TASK_SPEC_ADVANCE, TASK_CURRENT_REDUCTION_Y},
+	{TASK_SPEC_ADVANCE, TASK_SPEC_SEND_NP},
+	{TASK_SPEC_SEND_NP, TASK_SPEC_SEND_PARTICLES},
+	{TASK_SPEC_SEND_PARTICLES, TASK_SPEC_RECEIVE},
+	{TASK_CURRENT_SEND_Y, TASK_CURRENT_REDUCTION_Y},
+	{TASK_CURRENT_REDUCTION_Y, TASK_CURRENT_SEND_X},
+	{TASK_CURRENT_SEND_X, TASK_CURRENT_REDUCTION_X},
+	{TASK_CURRENT_REDUCTION_X, TASK_CURRENT_FILTER_X},
+	{TASK_CURRENT_REDUCTION_X, TASK_EMF_ADVANCE},
+	{TASK_CURRENT_FILTER_X, TASK_CURRENT_UPDATE_GC_X},
+	{TASK_CURRENT_UPDATE_GC_X, TASK_EMF_ADVANCE},
+	{TASK_EMF_ADVANCE, TASK_EMF_SEND_X},
+	{TASK_EMF_SEND_X, TASK_EMF_UPDATE_GC_X},
+	{TASK_EMF_UPDATE_GC_X, TASK_EMF_SEND_Y},
+	{TASK_EMF_SEND_Y, TASK_EMF_UPDATE_GC_Y},
+};
+
+#define STEP_GRAPH_EDGES (int) (sizeof(step_graph) / sizeof(step_graph[0]))
+
+// The successors of the send tasks are in the neighbouring processes, so they are not in the
+// graph of this process
+static const int send_tasks[] = {
+	TASK_SPEC_SEND_NP, TASK_SPEC_SEND_PARTICLES, TASK_CURRENT_SEND_Y, TASK_CURRENT_SEND_X,
+	TASK_EMF_SEND_X, TASK_EMF_SEND_Y
+};
+
+#define N_SEND_TASKS (int) (sizeof(send_tasks) / sizeof(send_tasks[0]))
+
+// The priority of a task is the latest depth at which it can run without making the time step
+// longer than the critical path of the graph, i.e., the critical path length minus the longest
+// path from the task to the end of the step. The halo updates and reductions get the highest
+// priorities, while the tasks of the next time step (particle advance) that are already ready
+// wait for them. The send tasks always come first
+static void task_priority_depth(void)
+{
+	int level[TASK_N_TYPES];   // Longest path to the end of the step
+	bool in_graph[TASK_N_TYPES];
+	memset(level, 0, sizeof(level));
+	memset(in_graph, 0, sizeof(in_graph));
+
+	for (int e = 0; e < STEP_GRAPH_EDGES; e++)
+		in_graph[step_graph[e][0]] = in_graph[step_graph[e][1]] = true;
+
+	// The graph is acyclic, so the levels do not change after (number of tasks) passes
+	for (int pass = 0; pass < TASK_N_TYPES; pass++)
+		for (int e = 0; e < STEP_GRAPH_EDGES; e++)
+			if (level[step_graph[e][0]] < level[step_graph[e][1]] + 1)
+				level[step_graph[e][0]] = level[step_graph[e][1]] + 1;
+
+	int critical_path = 0;
+	for (int t = 0; t < TASK_N_TYPES; t++)
+		if (level[t] > critical_path) critical_path = level[t];
+
+	for (int t = 0; t < TASK_N_TYPES; t++)
+		task_priority[t] = in_graph[t] ? critical_path - level[t] + 1 : 0;
+
+	for (int i = 0; i < N_SEND_TASKS; i++)
+		task_priority[send_tasks[i]] = critical_path + 2;
+}
+
+// Set the priority of each type of task
+void task_priority_set_policy(const enum task_priority_policy policy)
+{
+	memset(task_priority, 0, sizeof(task_priority));
+
+	switch (policy)
+	{
+		case TASK_PRIORITY_NONE:
+			break;
+		case TASK_PRIORITY_FIXED:
+			for (int i = 0; i < N_SEND_TASKS; i++)
+				task_priority[send_tasks[i]] = 1;
+			break;
+		case TASK_PRIORITY_DEPTH:
+			task_priority_depth();
+			break;
+	}
+}
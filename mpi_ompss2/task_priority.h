@@ -0,0 +1,35 @@
+/*********************************************************************************************
+ ZPIC
+ task_priority.h
+
+ Priority of each type of task. The priorities are computed from the dependencies between the
+ tasks of one time step, so that the tasks that release the work of the other regions and
+ processes (and of the next time step) run first.
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __TASK_PRIORITY__
+#define __TASK_PRIORITY__
+
+enum task_type {
+	TASK_CURRENT_RESET, TASK_SPEC_ADVANCE, TASK_SPEC_SEND_NP, TASK_SPEC_SEND_PARTICLES,
+	TASK_SPEC_RECEIVE, TASK_CURRENT_SEND_Y, TASK_CURRENT_REDUCTION_Y, TASK_CURRENT_SEND_X,
+	TASK_CURRENT_REDUCTION_X, TASK_CURRENT_FILTER_X, TASK_CURRENT_UPDATE_GC_X,
+	TASK_CURRENT_FILTER_Y, TASK_EMF_ADVANCE, TASK_EMF_SEND_X, TASK_EMF_UPDATE_GC_X, TASK_EMF_SEND_Y,
+	TASK_EMF_UPDATE_GC_Y, TASK_N_TYPES
+};
+
+enum task_priority_policy {
+	TASK_PRIORITY_NONE,   // All the tasks with the same priority (original version)
+	TASK_PRIORITY_FIXED,  // Only the send tasks with a higher priority
+	TASK_PRIORITY_DEPTH   // From the depth of the task in the time step graph (default)
+};
+
+// Priority of each type of task (used in the priority clause of the task pragmas)
+extern int task_priority[TASK_N_TYPES];
+
+void task_priority_set_policy(const enum task_priority_policy policy);
+
+#endif
@@ -0,0 +1,162 @@
+/*********************************************************************************************
+ ZPIC
+ autotune.c
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <unistd.h>
+
+#include "autotune.h"
+#include "random.h"
+#include "timer.h"
+
+#ifdef ENABLE_OPENMP_TASKS
+#include "omp_tasks.h"
+#else
+#include <nanos6.h>
+#endif
+
+// Candidates (times the number of workers)
+static const int autotune_factors[] = { 1, 2, 4, 8, 16 };
+
+/*********************************************************************************************
+ Cache
+ *********************************************************************************************/
+
+// Return the cached number of regions (0 if not found)
+int autotune_cache_lookup(const char *name, const char *host, const int workers)
+{
+	char line[256], c_name[64], c_host[64];
+	int c_workers, c_regions;
+	int regions = 0;
+
+	FILE *file = fopen(AUTOTUNE_CACHE, "r");
+	if (!file) return 0;
+
+	while (fgets(line, sizeof(line), file))
+	{
+		if (sscanf(line, "%63[^;];%63[^;];%d;%d", c_name, c_host, &c_workers, &c_regions) != 4)
+			continue;
+
+		// The last entry is the most recent one
+		if (!strcmp(c_name, name) && !strcmp(c_host, host) && c_workers == workers)
+			regions = c_regions;
+	}
+
+	fclose(file);
+	return regions;
+}
+
+void autotune_cache_store(const char *name, const char *host, const int workers,
+		const int regions)
+{
+	FILE *file = fopen(AUTOTUNE_CACHE, "a");
+	if (!file)
+	{
+		fprintf(stderr, "Warning: unable to write the region count to %s\n", AUTOTUNE_CACHE);
+		return;
+	}
+
+	fprintf(file, "%s;%s;%d;%d\n", name, host, workers, regions);
+	fclose(file);
+}
+
+/*********************************************************************************************
+ Calibration
+ *********************************************************************************************/
+
+// Initialize the simulation with the same random sequence (and phase timings) as a regular run
+void autotune_init(t_simulation *sim, const int n_regions)
+{
+	set_rand_seed(12345, 67890);
+	timer_phase_reset();
+	sim_init(sim, n_regions);
+}
+
+// Average time per step (seconds)
+double autotune_measure(t_simulation *sim)
+{
+	// Warm-up
+	sim_iter(sim);
+	#pragma oss taskwait
+#ifdef ENABLE_OPENMP_TASKS
+	#pragma omp taskwait
+#endif
+
+	uint64_t t0 = timer_ticks();
+	for (int n = 1; n < AUTOTUNE_STEPS; n++)
+		sim_iter(sim);
+	#pragma oss taskwait
+#ifdef ENABLE_OPENMP_TASKS
+	#pragma omp taskwait
+#endif
+
+	return timer_interval_seconds(t0, timer_ticks()) / (AUTOTUNE_STEPS - 1);
+}
+
+void autotune_regions(t_simulation *sim)
+{
+	const int workers = nanos6_get_num_cpus();
+	const int n_factors = sizeof(autotune_factors) / sizeof(autotune_factors[0]);
+	char host[64];
+
+	if (gethostname(host, sizeof(host)) != 0) strcpy(host, "unknown");
+	host[sizeof(host) - 1] = '\0';
+
+	// The first candidate is also used to get the simulation name and size
+	autotune_init(sim, workers * autotune_factors[0]);
+
+	const int cached = autotune_cache_lookup(sim->name, host, workers);
+	if (cached > 0)
+	{
+		if (cached != (int) sim->n_regions)
+		{
+			sim_delete(sim);
+			autotune_init(sim, cached);
+		}
+
+#ifndef TEST
+		fprintf(stderr, "Number of regions: %d (cached in %s)\n", cached, AUTOTUNE_CACHE);
+#endif
+		return;
+	}
+
+	int best = sim->n_regions;
+	double best_time = DBL_MAX;
+
+	for (int f = 0; f < n_factors; f++)
+	{
+		const int n_regions = workers * autotune_factors[f];
+		if (f > 0 && sim->nx[1] / n_regions < AUTOTUNE_MIN_ROWS) break;
+
+		if (f > 0) autotune_init(sim, n_regions);
+
+		const double time = autotune_measure(sim);
+		sim_delete(sim);
+
+#ifndef TEST
+		fprintf(stderr, "Auto-tune: %4d regions, %f s/step\n", n_regions, time);
+#endif
+
+		if (time < best_time)
+		{
+			best_time = time;
+			best = n_regions;
+		}
+	}
+
+#ifndef TEST
+	fprintf(stderr, "Number of regions: %d\n\n", best);
+#endif
+
+	autotune_init(sim, best);
+	autotune_cache_store(sim->name, host, workers, best);
+}
@@ -0,0 +1,29 @@
+/*********************************************************************************************
+ ZPIC
+ autotune.h
+
+ Automatic selection of the number of regions. Each candidate (multiple of the number of
+ workers) runs a few calibration steps and the simulation is initialized with the fastest one.
+ The choice is cached per simulation, machine and number of workers in AUTOTUNE_CACHE.
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __AUTOTUNE__
+#define __AUTOTUNE__
+
+#include "simulation.h"
+
+// Calibration steps per candidate (the first one is not timed)
+#define AUTOTUNE_STEPS 5
+
+// Minimum number of cells in the y direction per region
+#define AUTOTUNE_MIN_ROWS 8
+
+#define AUTOTUNE_CACHE "output/regions.cache"
+
+// Initialize the simulation with the best number of regions (calls sim_init)
+void autotune_regions(t_simulation *sim);
+
+#endif
@@ -0,0 +1,507 @@
+/*********************************************************************************************
+ ZPIC
+ bench.c
+
+ Kernel microbenchmarks. Each kernel runs in isolation (single region, no tasking) over a
+ synthetic particle distribution and the results are reported per particle or per cell.
+
+ The Boris push is measured through spec_advance (interpolation + push + deposition).
+
+ Usage: ./bench [grid size] [particles per cell (per direction)] [repetitions]
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "zpic.h"
+#include "emf.h"
+#include "current.h"
+#include "particles.h"
+#include "random.h"
+#include "timer.h"
+
+// Kernels that are not exported in the headers
+void interpolate_fld(const t_vfld *restrict const E, const t_vfld *restrict const B, const int nrow,
+		const t_part *restrict const part, t_vfld *restrict const Ep, t_vfld *restrict const Bp,
+		const int offset);
+void dep_current_zamb(int ix, int iy, int di, int dj, float x0, float y0, float dx, float dy,
+		float qnx, float qny, float qvz, t_current *current);
+void dep_current_esk(int ix0, int iy0, int di, int dj, t_part_data x0, t_part_data y0,
+		t_part_data x1, t_part_data y1, t_part_data qvx, t_part_data qvy, t_part_data qvz,
+		t_current *current);
+void interpolate_fld_s2(const t_vfld *restrict const E, const t_vfld *restrict const B,
+		const int nrow, const t_part *restrict const part, t_vfld *restrict const Ep,
+		t_vfld *restrict const Bp, const int offset);
+void interpolate_fld_s3(const t_vfld *restrict const E, const t_vfld *restrict const B,
+		const int nrow, const t_part *restrict const part, t_vfld *restrict const Ep,
+		t_vfld *restrict const Bp, const int offset);
+void dep_current_s2(const int ix, const int iy, const t_fld x0, const t_fld y0, const t_fld x1,
+		const t_fld y1, const t_part_data qnx, const t_part_data qny, const t_part_data qvz,
+		t_current *current);
+void dep_current_s3(const int ix, const int iy, const t_fld x0, const t_fld y0, const t_fld x1,
+		const t_fld y1, const t_part_data qnx, const t_part_data qny, const t_part_data qvz,
+		t_current *current);
+void yee_b(t_emf *emf, const float dt);
+void yee_e(t_emf *emf, const t_current *current, const float dt);
+void yee_e_consume(t_emf *emf, t_current *current, const float dt);
+void kernel_x(t_current *const current, const t_fld sa, const t_fld sb);
+void kernel_y(t_current *const current, const t_fld sa, const t_fld sb);
+
+// Same parameters as the decks in input/weak
+#define BENCH_BOX 51.2f
+#define BENCH_DT 0.07f
+
+// Fraction of particles exchanged between regions in the merge benchmark
+#define BENCH_MERGE_FRACTION 0.02f
+
+// Synthetic particle distributions
+typedef struct {
+	const char *name;
+	t_part_data uth;    // Thermal momentum
+	bool shuffle;       // Random particle order (instead of the cell order of the injection)
+} t_bench_dist;
+
+static const t_bench_dist distributions[] = {
+	{ .name = "cold-sorted", .uth = 0.0f, .shuffle = false },
+	{ .name = "cold-shuffled", .uth = 0.0f, .shuffle = true },
+	{ .name = "warm-sorted", .uth = 0.01f, .shuffle = false },
+	{ .name = "warm-shuffled", .uth = 0.01f, .shuffle = true }
+};
+
+typedef struct {
+	t_species spec;
+	t_emf emf;
+	t_current current;
+	int limits_y[2];
+
+	// Copy of the initial particles (restored before each run)
+	t_part_vector initial;
+	t_part_queue outgoing[2];
+
+	// Particle trajectories for the deposition benchmarks (one push of the initial particles)
+	int *di, *dj;
+	t_part_data *dx, *dy, *qvz;
+} t_bench;
+
+typedef struct {
+	double min, median, mean, stddev;
+} t_bench_stats;
+
+// Prevent the compiler from removing the interpolation
+static volatile float bench_sink;
+
+/*********************************************************************************************
+ Setup
+ *********************************************************************************************/
+
+// Fisher-Yates shuffle of the particle vector
+void bench_shuffle(t_part_vector *vector)
+{
+	for (int i = vector->size - 1; i > 0; i--)
+	{
+		int k = rand_uint32() % (i + 1);
+		t_part temp = vector->data[i];
+		vector->data[i] = vector->data[k];
+		vector->data[k] = temp;
+	}
+}
+
+// Fill the grid (including the guard cells) with random values
+void bench_fill_grid(t_vfld *restrict buffer, const int size, const float amplitude)
+{
+	for (int i = 0; i < size; i++)
+	{
+		buffer[i].x = amplitude * rand_norm();
+		buffer[i].y = amplitude * rand_norm();
+		buffer[i].z = amplitude * rand_norm();
+	}
+}
+
+// Push the initial particles once to get the trajectories used by the deposition benchmarks
+void bench_trajectories(t_bench *bench)
+{
+	const int np = bench->initial.size;
+	const t_part_data dt_dx = bench->spec.dt / bench->spec.dx[0];
+	const t_part_data dt_dy = bench->spec.dt / bench->spec.dx[1];
+
+	bench->di = malloc(np * sizeof(int));
+	bench->dj = malloc(np * sizeof(int));
+	bench->dx = malloc(np * sizeof(t_part_data));
+	bench->dy = malloc(np * sizeof(t_part_data));
+	bench->qvz = malloc(np * sizeof(t_part_data));
+
+	for (int i = 0; i < np; i++)
+	{
+		const t_part *part = &bench->initial.data[i];
+		t_part_data rg = 1.0f / sqrtf(1.0f + part->ux * part->ux + part->uy * part->uy
+				+ part->uz * part->uz);
+
+		bench->dx[i] = dt_dx * rg * part->ux;
+		bench->dy[i] = dt_dy * rg * part->uy;
+		bench->di[i] = LTRIM(part->x + bench->dx[i]);
+		bench->dj[i] = LTRIM(part->y + bench->dy[i]);
+		bench->qvz[i] = bench->spec.q * part->uz * rg;
+	}
+}
+
+void bench_new(t_bench *bench, const int nx, const int ppc, const t_bench_dist *dist)
+{
+	int grid[2] = { nx, nx };
+	int spec_ppc[2] = { ppc, ppc };
+	t_fld box[2] = { BENCH_BOX, BENCH_BOX };
+	t_part_data ufl[3] = { 0.0f, 0.0f, 0.0f };
+	t_part_data uth[3] = { dist->uth, dist->uth, dist->uth };
+
+	set_rand_seed(12345, 67890);
+
+	emf_new(&bench->emf, grid, box, BENCH_DT);
+	current_new(&bench->current, grid, box, BENCH_DT);
+	bench_fill_grid(bench->emf.E_buf, bench->emf.total_size, 0.01f);
+	bench_fill_grid(bench->emf.B_buf, bench->emf.total_size, 0.01f);
+
+	// A single region covering the whole simulation space
+	bench->limits_y[0] = 0;
+	bench->limits_y[1] = nx;
+
+	spec_new(&bench->spec, "electrons", -1.0f, spec_ppc, ufl, uth, grid, box, BENCH_DT, NULL);
+	const int range[][2] = { { 0, nx }, { 0, nx } };
+	spec_inject_particles(&bench->spec.main_vector, range, spec_ppc, &bench->spec.density,
+			bench->spec.dx, 0, ufl, uth, false);
+
+	if (dist->shuffle) bench_shuffle(&bench->spec.main_vector);
+
+	for (int n = 0; n < 2; n++)
+	{
+		part_queue_new(&bench->outgoing[n], bench->spec.main_vector.size);
+		bench->spec.outgoing_part[n] = &bench->outgoing[n];
+	}
+
+	bench->initial.size = bench->spec.main_vector.size;
+	bench->initial.size_max = bench->spec.main_vector.size_max;
+	bench->initial.data = malloc(bench->initial.size_max * sizeof(t_part));
+	memcpy(bench->initial.data, bench->spec.main_vector.data, bench->initial.size * sizeof(t_part));
+
+	bench_trajectories(bench);
+}
+
+void bench_delete(t_bench *bench)
+{
+	spec_delete(&bench->spec);
+	emf_delete(&bench->emf);
+	current_delete(&bench->current);
+
+	for (int n = 0; n < 2; n++)
+		part_queue_delete(&bench->outgoing[n]);
+	free(bench->initial.data);
+
+	free(bench->di);
+	free(bench->dj);
+	free(bench->dx);
+	free(bench->dy);
+	free(bench->qvz);
+}
+
+// Restore the initial state of the particles and zero the current
+void bench_reset(t_bench *bench)
+{
+	bench->spec.main_vector.size = bench->initial.size;
+	memcpy(bench->spec.main_vector.data, bench->initial.data, bench->initial.size * sizeof(t_part));
+
+	for (int n = 0; n < 2; n++)
+	{
+		bench->outgoing[n].head = bench->outgoing[n].tail = 0;
+		bench->spec.incoming_part[n].head = bench->spec.incoming_part[n].tail = 0;
+	}
+
+	bench->spec.iter = 0;
+	current_zero(&bench->current);
+}
+
+// Invalidate a fraction of the particles and fill the incoming buffers with the same amount
+void bench_reset_merge(t_bench *bench)
+{
+	bench_reset(bench);
+
+	const int stride = 1.0f / BENCH_MERGE_FRACTION;
+	const int n_moving = bench->initial.size / stride;
+
+	for (int i = 0; i < n_moving; i++)
+		bench->spec.main_vector.data[i * stride].invalid = true;
+
+	for (int n = 0; n < 2; n++)
+	{
+		t_part_vector *incoming = part_queue_stage(&bench->spec.incoming_part[n]);
+		const int size = n == 0 ? n_moving / 2 : n_moving - n_moving / 2;
+
+		if (size > incoming->size_max)
+		{
+			incoming->size_max = size;
+			incoming->data = realloc(incoming->data, size * sizeof(t_part));
+		}
+
+		memcpy(incoming->data, bench->initial.data + n * (n_moving / 2), size * sizeof(t_part));
+		incoming->size = size;
+		part_queue_publish(&bench->spec.incoming_part[n], bench->spec.iter);
+	}
+}
+
+/*********************************************************************************************
+ Kernels
+ *********************************************************************************************/
+
+void bench_interpolate(t_bench *bench)
+{
+	const t_emf *emf = &bench->emf;
+	float sum = 0;
+
+	for (int i = 0; i < bench->spec.main_vector.size; i++)
+	{
+		t_vfld Ep, Bp;
+		interpolate_fld(emf->E, emf->B, emf->nrow, &bench->spec.main_vector.data[i], &Ep, &Bp,
+				bench->limits_y[0]);
+		sum += Ep.x + Ep.y + Ep.z + Bp.x + Bp.y + Bp.z;
+	}
+
+	bench_sink = sum;
+}
+
+void bench_dep_zamb(t_bench *bench)
+{
+	const t_species *spec = &bench->spec;
+	const t_part_data qnx = spec->q * spec->dx[0] / spec->dt;
+	const t_part_data qny = spec->q * spec->dx[1] / spec->dt;
+
+	for (int i = 0; i < spec->main_vector.size; i++)
+	{
+		const t_part *part = &spec->main_vector.data[i];
+		dep_current_zamb(part->ix, part->iy, bench->di[i], bench->dj[i], part->x, part->y,
+				bench->dx[i], bench->dy[i], qnx, qny, bench->qvz[i], &bench->current);
+	}
+}
+
+void bench_dep_esk(t_bench *bench)
+{
+	const t_species *spec = &bench->spec;
+	const t_part_data qnx = spec->q * spec->dx[0] / spec->dt;
+	const t_part_data qny = spec->q * spec->dx[1] / spec->dt;
+
+	for (int i = 0; i < spec->main_vector.size; i++)
+	{
+		const t_part *part = &spec->main_vector.data[i];
+		t_part_data x1 = part->x + bench->dx[i] - bench->di[i];
+		t_part_data y1 = part->y + bench->dy[i] - bench->dj[i];
+
+		dep_current_esk(part->ix, part->iy, bench->di[i], bench->dj[i], part->x, part->y, x1, y1,
+				qnx, qny, bench->qvz[i], &bench->current);
+	}
+}
+
+// Higher order shapes (the grids only have enough guard cells for the shape of the build)
+#if SHAPE_ORDER > 1
+void bench_interpolate_shape(t_bench *bench)
+{
+	const t_emf *emf = &bench->emf;
+	float sum = 0;
+
+	for (int i = 0; i < bench->spec.main_vector.size; i++)
+	{
+		t_vfld Ep, Bp;
+#if SHAPE_ORDER == 2
+		interpolate_fld_s2(emf->E, emf->B, emf->nrow, &bench->spec.main_vector.data[i], &Ep, &Bp,
+				bench->limits_y[0]);
+#else
+		interpolate_fld_s3(emf->E, emf->B, emf->nrow, &bench->spec.main_vector.data[i], &Ep, &Bp,
+				bench->limits_y[0]);
+#endif
+		sum += Ep.x + Ep.y + Ep.z + Bp.x + Bp.y + Bp.z;
+	}
+
+	bench_sink = sum;
+}
+
+void bench_dep_shape(t_bench *bench)
+{
+	const t_species *spec = &bench->spec;
+	const t_part_data qnx = spec->q * spec->dx[0] / spec->dt;
+	const t_part_data qny = spec->q * spec->dx[1] / spec->dt;
+
+	for (int i = 0; i < spec->main_vector.size; i++)
+	{
+		const t_part *part = &spec->main_vector.data[i];
+#if SHAPE_ORDER == 2
+		dep_current_s2(part->ix, part->iy, part->x, part->y, part->x + bench->dx[i],
+				part->y + bench->dy[i], qnx, qny, bench->qvz[i], &bench->current);
+#else
+		dep_current_s3(part->ix, part->iy, part->x, part->y, part->x + bench->dx[i],
+				part->y + bench->dy[i], qnx, qny, bench->qvz[i], &bench->current);
+#endif
+	}
+}
+#endif
+
+void bench_spec_advance(t_bench *bench)
+{
+	spec_advance(&bench->spec, &bench->emf, &bench->current, bench->limits_y);
+}
+
+void bench_merge(t_bench *bench)
+{
+	spec_merge_vectors(&bench->spec);
+}
+
+void bench_yee_b(t_bench *bench)
+{
+	yee_b(&bench->emf, bench->emf.dt / 2.0f);
+}
+
+void bench_yee_e(t_bench *bench)
+{
+	yee_e(&bench->emf, &bench->current, bench->emf.dt);
+}
+
+// Field solver with the current reset of the next step (separate memset or consumed by yee_e)
+void bench_yee_e_zero(t_bench *bench)
+{
+	yee_e(&bench->emf, &bench->current, bench->emf.dt);
+	current_zero(&bench->current);
+}
+
+void bench_yee_e_consume(t_bench *bench)
+{
+	yee_e_consume(&bench->emf, &bench->current, bench->emf.dt);
+}
+
+void bench_kernel_x(t_bench *bench)
+{
+	kernel_x(&bench->current, 0.25, 0.5);
+}
+
+void bench_kernel_y(t_bench *bench)
+{
+	kernel_y(&bench->current, 0.25, 0.5);
+}
+
+/*********************************************************************************************
+ Measurement
+ *********************************************************************************************/
+
+int compare_double(const void *a, const void *b)
+{
+	const double x = *(const double*) a;
+	const double y = *(const double*) b;
+	return (x > y) - (x < y);
+}
+
+// Compute the statistics of the samples (the sample vector is sorted in place)
+void bench_stats(double *samples, const int n, t_bench_stats *stats)
+{
+	qsort(samples, n, sizeof(double), compare_double);
+
+	stats->min = samples[0];
+	stats->median = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+
+	stats->mean = 0;
+	for (int i = 0; i < n; i++)
+		stats->mean += samples[i];
+	stats->mean /= n;
+
+	stats->stddev = 0;
+	for (int i = 0; i < n; i++)
+		stats->stddev += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+	stats->stddev = n > 1 ? sqrt(stats->stddev / (n - 1)) : 0;
+}
+
+// Run the kernel several times (after a warm-up run) and report the time per unit of work
+void bench_run(t_bench *bench, const char *kernel_name, const char *dist_name,
+		void (*kernel)(t_bench*), void (*reset)(t_bench*), const double work,
+		const char *unit, const int reps)
+{
+	double samples[reps];
+	t_bench_stats stats;
+
+	for (int r = -1; r < reps; r++)
+	{
+		if (reset) reset(bench);
+
+		uint64_t t0 = timer_ticks();
+		kernel(bench);
+		uint64_t t1 = timer_ticks();
+
+		if (r >= 0) samples[r] = 1.0e9 * timer_interval_seconds(t0, t1) / work;
+	}
+
+	bench_stats(samples, reps, &stats);
+	printf("%-18s %-14s %10.3f %10.3f %10.3f %10.3f  %s\n", kernel_name, dist_name, stats.min,
+			stats.median, stats.mean, stats.stddev, unit);
+}
+
+/*********************************************************************************************
+ Main
+ *********************************************************************************************/
+
+int main(int argc, const char *argv[])
+{
+	const int nx = argc > 1 ? atoi(argv[1]) : 512;
+	const int ppc = argc > 2 ? atoi(argv[2]) : 2;
+	const int reps = argc > 3 ? atoi(argv[3]) : 10;
+
+	if (nx <= 0 || ppc <= 0 || reps <= 0)
+	{
+		fprintf(stderr, "Usage: %s [grid size] [particles per cell (per direction)] [repetitions]\n",
+				argv[0]);
+		exit(1);
+	}
+
+	printf("Grid: %d x %d, particles per cell: %d x %d, repetitions: %d\n\n", nx, nx, ppc, ppc, reps);
+	printf("%-18s %-14s %10s %10s %10s %10s  %s\n", "kernel", "distribution", "min", "median",
+			"mean", "stddev", "unit");
+
+	t_bench bench;
+	const int n_dist = sizeof(distributions) / sizeof(distributions[0]);
+
+	for (int d = 0; d < n_dist; d++)
+	{
+		const char *name = distributions[d].name;
+		bench_new(&bench, nx, ppc, &distributions[d]);
+
+		const double np = bench.initial.size;
+		const double n_moving = (int) (np / (int) (1.0f / BENCH_MERGE_FRACTION));
+
+		bench_run(&bench, "interpolate_fld", name, bench_interpolate, NULL, np, "ns/part", reps);
+		bench_run(&bench, "dep_current_zamb", name, bench_dep_zamb, bench_reset, np, "ns/part", reps);
+		bench_run(&bench, "dep_current_esk", name, bench_dep_esk, bench_reset, np, "ns/part", reps);
+#if SHAPE_ORDER > 1
+		bench_run(&bench, "interpolate_shape", name, bench_interpolate_shape, NULL, np, "ns/part",
+				reps);
+		bench_run(&bench, "dep_current_shape", name, bench_dep_shape, bench_reset, np, "ns/part",
+				reps);
+#endif
+		bench_run(&bench, "spec_advance", name, bench_spec_advance, bench_reset, np, "ns/part", reps);
+		bench_run(&bench, "spec_merge_vectors", name, bench_merge, bench_reset_merge, n_moving,
+				"ns/moved part", reps);
+
+		// The grid kernels do not depend on the particle distribution
+		if (d == 0)
+		{
+			const double n_cells = (double) nx * nx;
+
+			bench_run(&bench, "yee_b", "grid", bench_yee_b, NULL, n_cells, "ns/cell", reps);
+			bench_run(&bench, "yee_e", "grid", bench_yee_e, NULL, n_cells, "ns/cell", reps);
+			bench_run(&bench, "yee_e+current_zero", "grid", bench_yee_e_zero, NULL, n_cells,
+					"ns/cell", reps);
+			bench_run(&bench, "yee_e_consume", "grid", bench_yee_e_consume, NULL, n_cells,
+					"ns/cell", reps);
+			bench_run(&bench, "kernel_x", "grid", bench_kernel_x, NULL, n_cells, "ns/cell", reps);
+			bench_run(&bench, "kernel_y", "grid", bench_kernel_y, NULL, n_cells, "ns/cell", reps);
+		}
+
+		bench_delete(&bench);
+	}
+
+	return 0;
+}
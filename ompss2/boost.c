@@ -0,0 +1,229 @@
+/*********************************************************************************************
+ ZPIC
+ boost.c
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#include "boost.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "zdf.h"
+#include "timer.h"
+#include "perf_counters.h"
+#include "task_trace.h"
+
+// Lorentz transformation of the fluid momentum (lab -> boosted frame)
+void boost_momentum(const t_boost *boost, const t_part_data u[3], t_part_data u_boost[3])
+{
+	const float beta = sqrtf(1.0f - 1.0f / (boost->gamma * boost->gamma));
+	const float g = sqrtf(1.0f + u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+
+	u_boost[0] = boost->gamma * (u[0] - beta * g);
+	u_boost[1] = u[1];
+	u_boost[2] = u[2];
+}
+
+/*********************************************************************************************
+ Lab frame diagnostics
+ *********************************************************************************************/
+
+void lab_diag_new(t_lab_diag *diag, const t_boost *boost, const int nx[2], const t_fld box[2],
+		const float dt, const char name[64])
+{
+	diag->n_snapshots = boost->n_snapshots;
+	diag->t_snapshot = boost->t_snapshot;
+	diag->dt_snapshot = boost->dt_snapshot;
+	diag->nx_lab = boost->nx_lab;
+	diag->x_lab[0] = boost->x_lab[0];
+	diag->x_lab[1] = boost->x_lab[1];
+
+	diag->gamma = boost->gamma;
+	diag->beta = sqrtf(1.0f - 1.0f / (boost->gamma * boost->gamma));
+	diag->origin = boost->origin;
+
+	for (int d = 0; d < 2; d++)
+	{
+		diag->nx[d] = nx[d];
+		diag->box[d] = box[d];
+		diag->dx[d] = box[d] / nx[d];
+	}
+	diag->dt = dt;
+
+	diag->row_size = diag->n_snapshots * LAB_DIAG_COMP * diag->nx_lab;
+	diag->buffer = calloc((size_t) nx[1] * diag->row_size, sizeof(float));
+	diag->prev = calloc((size_t) nx[1] * diag->n_snapshots * LAB_DIAG_COMP, sizeof(float));
+	diag->saved = calloc(diag->n_snapshots, sizeof(bool));
+	assert(diag->buffer && diag->prev && diag->saved);
+
+	snprintf(diag->path, sizeof(diag->path), "output/%s/lab", name);
+}
+
+void lab_diag_delete(t_lab_diag *diag)
+{
+	free(diag->buffer);
+	free(diag->prev);
+	free(diag->saved);
+	diag->buffer = NULL;
+	diag->prev = NULL;
+	diag->saved = NULL;
+}
+
+// Lab frame time of the snapshot s
+static inline float lab_diag_time(const t_lab_diag *diag, const int s)
+{
+	return diag->t_snapshot + s * diag->dt_snapshot;
+}
+
+// Lab frame position of the column k
+static inline float lab_diag_x(const t_lab_diag *diag, const int k)
+{
+	return diag->x_lab[0] + (k + 0.5f) * (diag->x_lab[1] - diag->x_lab[0]) / diag->nx_lab;
+}
+
+// Lab frame position of the snapshot s at the boosted frame time t
+static inline float lab_diag_event_x(const t_lab_diag *diag, const int s, const float t)
+{
+	return diag->origin + (lab_diag_time(diag, s) - t / diag->gamma) / diag->beta;
+}
+
+// Boosted frame position (in cells) of the snapshot s at the boosted frame time t
+static inline float lab_diag_event_x_boost(const t_lab_diag *diag, const int s, const float t)
+{
+	return (diag->origin + (lab_diag_time(diag, s) / diag->gamma - t) / diag->beta) / diag->dx[0];
+}
+
+// All the columns of the snapshot s were filled at the iteration iter (and it was not saved yet)
+bool lab_diag_complete(const t_lab_diag *diag, const int s, const int iter)
+{
+	return !diag->saved[s] && lab_diag_event_x(diag, s, iter * diag->dt) <= lab_diag_x(diag, 0);
+}
+
+static inline t_fld fld_comp(const t_vfld *f, const int c)
+{
+	return c == 0 ? f->x : (c == 1 ? f->y : f->z);
+}
+
+// Linear interpolation along x of the field component c (staggered by sx cells) in the position x
+static inline t_fld interp_x(const t_vfld *restrict F, const int c, const float sx, const float x)
+{
+	const int i = floorf(x - sx);
+	const float w = x - sx - i;
+
+	return (1.0f - w) * fld_comp(&F[i], c) + w * fld_comp(&F[i + 1], c);
+}
+
+// Sample the fields of each snapshot in the region rows, at the lab frame event of the boosted
+// frame time iter * dt (the events of consecutive iterations sweep the snapshot from right to
+// left). The columns between the events of the previous and current iterations are linearly
+// interpolated
+void lab_diag_update(t_lab_diag *diag, const t_emf *emf, const int limits_y[2], const int iter)
+{
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
+	const float t_boost = iter * diag->dt;
+	const float gamma = diag->gamma;
+	const float beta = diag->beta;
+	const int nrow = emf->nrow;
+	const int n = diag->nx_lab;
+	const float dx_lab = (diag->x_lab[1] - diag->x_lab[0]) / n;
+
+	for (int s = 0; s < diag->n_snapshots; s++)
+	{
+		const float x = lab_diag_event_x_boost(diag, s, t_boost);
+		if (x < 0 || x >= diag->nx[0]) continue;
+
+		// Columns between the previous event and the current one
+		const float x_lab = lab_diag_event_x(diag, s, t_boost);
+		const float x_lab_prev = lab_diag_event_x(diag, s, t_boost - diag->dt);
+		const float x_prev = lab_diag_event_x_boost(diag, s, t_boost - diag->dt);
+		const bool has_prev = iter > 1 && x_prev >= 0 && x_prev < diag->nx[0];
+
+		int k0 = ceilf((x_lab - diag->x_lab[0]) / dx_lab - 0.5f);
+		int k1 = ceilf((x_lab_prev - diag->x_lab[0]) / dx_lab - 0.5f);
+		if (k0 < 0) k0 = 0;
+		if (k1 > n) k1 = n;
+		if (!has_prev) k1 = k0;
+
+		for (int j = 0; j < limits_y[1] - limits_y[0]; j++)
+		{
+			const t_vfld *restrict E = emf->E + j * nrow;
+			const t_vfld *restrict B = emf->B + j * nrow;
+
+			const t_fld ex = interp_x(E, 0, 0.5f, x);
+			const t_fld ey = interp_x(E, 1, 0.0f, x);
+			const t_fld ez = interp_x(E, 2, 0.0f, x);
+			const t_fld bx = interp_x(B, 0, 0.0f, x);
+			const t_fld by = interp_x(B, 1, 0.5f, x);
+			const t_fld bz = interp_x(B, 2, 0.5f, x);
+
+			// Lorentz transformation to the lab frame
+			const t_fld f[LAB_DIAG_COMP] = { ex, gamma * (ey + beta * bz), gamma * (ez - beta * by),
+					bx, gamma * (by - beta * ez), gamma * (bz + beta * ey) };
+
+			float *restrict p = diag->buffer + (limits_y[0] + j) * diag->row_size
+					+ s * LAB_DIAG_COMP * n;
+			float *restrict prev = diag->prev + ((limits_y[0] + j) * diag->n_snapshots + s)
+					* LAB_DIAG_COMP;
+
+			for (int k = k0; k < k1; k++)
+			{
+				const float w = (lab_diag_x(diag, k) - x_lab) / (x_lab_prev - x_lab);
+				for (int c = 0; c < LAB_DIAG_COMP; c++)
+					p[c * n + k] = (1.0f - w) * f[c] + w * prev[c];
+			}
+
+			for (int c = 0; c < LAB_DIAG_COMP; c++)
+				prev[c] = f[c];
+		}
+	}
+
+	TASK_TRACE_END(TRACE_DIAGNOSTICS, emf->region_id, iter,
+			2 * emf->total_size * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_DIAGNOSTICS, emf->region_id, iter);
+	timer_phase_add(TIMER_DIAGNOSTICS, t0);
+}
+
+// Save the snapshot s in ZDF files (one per field component)
+void lab_diag_save(t_lab_diag *diag, const int s)
+{
+	const uint64_t t0 = timer_ticks();
+
+	const char *labels[] = {"E1", "E2", "E3", "B1", "B2", "B3"};
+	const int nx_lab = diag->nx_lab;
+	float *restrict buf = malloc(nx_lab * diag->nx[1] * sizeof(float));
+	assert(buf);
+
+	t_zdf_grid_axis axis[2];
+	axis[0] = (t_zdf_grid_axis ) { .min = diag->x_lab[0], .max = diag->x_lab[1], .label = "x_1",
+			.units = "c/\\omega_p" };
+	axis[1] = (t_zdf_grid_axis ) { .min = 0.0, .max = diag->box[1], .label = "x_2",
+			.units = "c/\\omega_p" };
+
+	t_zdf_iteration iteration = { .n = s, .t = lab_diag_time(diag, s), .time_units = "1/\\omega_p" };
+
+	for (int c = 0; c < LAB_DIAG_COMP; c++)
+	{
+		for (int j = 0; j < diag->nx[1]; j++)
+			memcpy(buf + j * nx_lab, diag->buffer + j * diag->row_size + (s * LAB_DIAG_COMP + c) * nx_lab,
+					nx_lab * sizeof(float));
+
+		t_zdf_grid_info info = { .ndims = 2, .label = (char*) labels[c],
+				.units = "m_e c \\omega_p e^{-1}", .axis = axis };
+		info.nx[0] = nx_lab;
+		info.nx[1] = diag->nx[1];
+
+		zdf_save_grid(buf, &info, &iteration, diag->path);
+	}
+
+	free(buf);
+	timer_phase_add(TIMER_DIAGNOSTICS, t0);
+}
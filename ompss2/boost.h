@@ -0,0 +1,96 @@
+/*********************************************************************************************
+ ZPIC
+ boost.h
+
+ Lorentz boosted frame: the simulation runs in a frame moving along +x with the Lorentz factor
+ gamma, where the plasma flows left (towards the laser) and enters the box through its right
+ edge. The grid, time step and tmax of the simulation are given in the boosted frame, while the
+ laser pulse, the density profile and the fluid momentum of the species are given in the lab
+ frame and transformed by sim_set_boost. Both frames coincide at the event (origin, t = 0).
+
+ The lab frame diagnostics are assembled in-situ: each snapshot (lab time T) is filled column by
+ column, as the boosted frame time reaches the time of each lab frame position.
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __BOOST__
+#define __BOOST__
+
+#include <stdbool.h>
+
+#include "zpic.h"
+#include "emf.h"
+#include "task_priority.h"
+
+typedef struct {
+	float gamma;	// Lorentz factor of the boosted frame (0 = lab frame)
+
+	// Lab frame position that stays in place at t = t' = 0 (e.g., the front of the laser). The
+	// distances to it are contracted in the boosted frame (the laser pulse is stretched)
+	float origin;
+
+	// Passes of the binomial filter (+ compensator) applied to the current along x and y, to
+	// mitigate the numerical Cherenkov instability of the drifting plasma (0 = no filter)
+	int filter[2];
+
+	// Lab frame snapshots of the fields: n_snapshots snapshots every dt_snapshot starting at
+	// t_snapshot (lab time), with nx_lab cells over [x_lab[0], x_lab[1]) along x (lab frame)
+	int n_snapshots;
+	float t_snapshot, dt_snapshot;
+	int nx_lab;
+	float x_lab[2];
+} t_boost;
+
+// Number of field components in the lab frame diagnostics (E and B)
+#define LAB_DIAG_COMP 6
+
+// Lab frame diagnostics (the buffer stores [row][snapshot][component][column], so each region
+// fills a contiguous part of it)
+typedef struct {
+	int n_snapshots;
+	float t_snapshot, dt_snapshot;
+	int nx_lab;
+	float x_lab[2];
+
+	float gamma, beta, origin;
+
+	// Boosted frame grid
+	int nx[2];
+	t_fld dx[2];
+	t_fld box[2];
+	float dt;
+
+	float *buffer;
+	int row_size;	// Values per row (all snapshots and components)
+
+	// Fields of each snapshot in the previous iteration ([row][snapshot][component])
+	float *prev;
+
+	bool *saved;
+
+	char path[128];
+} t_lab_diag;
+
+// Lorentz transformation of the fluid momentum (lab -> boosted frame)
+void boost_momentum(const t_boost *boost, const t_part_data u[3], t_part_data u_boost[3]);
+
+// Lab frame diagnostics
+void lab_diag_new(t_lab_diag *diag, const t_boost *boost, const int nx[2], const t_fld box[2],
+		const float dt, const char name[64]);
+void lab_diag_delete(t_lab_diag *diag);
+bool lab_diag_complete(const t_lab_diag *diag, const int s, const int iter);
+
+// CPU Tasks
+#pragma oss task in(emf->E_buf[0; emf->total_size]) in(emf->B_buf[0; emf->total_size]) \
+inout(diag->buffer[limits_y[0] * diag->row_size; (limits_y[1] - limits_y[0]) * diag->row_size]) \
+inout(diag->prev[limits_y[0] * diag->n_snapshots * LAB_DIAG_COMP; \
+		(limits_y[1] - limits_y[0]) * diag->n_snapshots * LAB_DIAG_COMP]) \
+label("Lab Diagnostics") priority(task_priority[TRACE_DIAGNOSTICS])
+void lab_diag_update(t_lab_diag *diag, const t_emf *emf, const int limits_y[2], const int iter);
+
+#pragma oss task in(diag->buffer[0; diag->nx[1] * diag->row_size]) label("Lab Diagnostics Save")
+void lab_diag_save(t_lab_diag *diag, const int s);
+
+#endif
@@ -16,16 +16,25 @@
 #include <string.h>
 
 #include "zdf.h"
+#include "timer.h"
+#include "perf_counters.h"
+#include "task_trace.h"
 
 /*********************************************************************************************
  Constructor / Destructor
  *********************************************************************************************/
 void current_new(t_current *current, int nx[], t_fld box[], float dt)
 {
-	int i;
+	// Number of guard cells for the deposition with the particle shape
+	const int gc[2][2] = { { SHAPE_GC_LOWER, SHAPE_GC_UPPER }, { SHAPE_GC_LOWER, SHAPE_GC_UPPER } };
+
+	current_new_gc(current, nx, gc, box, dt);
+}
 
-	// Number of guard cells for linear interpolation
-	int gc[2][2] = { { 1, 2 }, { 1, 2 } };
+// Same as current_new, with a given number of guard cells
+void current_new_gc(t_current *current, int nx[], const int gc[2][2], t_fld box[], float dt)
+{
+	int i;
 
 	// Allocate global array
 	size_t size;
@@ -64,6 +73,10 @@ void current_new(t_current *current, int nx[], t_fld box[], float dt)
 	current->dt = dt;
 
 	current->moving_window = 0;
+	for (i = 0; i < 2; i++)
+		current->absorbing[i][0] = current->absorbing[i][1] = false;
+
+	current->region_id = 0;
 }
 
 void current_delete(t_current *current)
@@ -75,12 +88,40 @@ void current_delete(t_current *current)
 // Set the current buffer to zero
 void current_zero(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
+	TASK_TRACE_BEGIN();
+
 	// zero fields
 	size_t size;
 	size = (current->gc[0][0] + current->nx[0] + current->gc[0][1])
 			* (current->gc[1][0] + current->nx[1] + current->gc[1][1]) * sizeof(t_vfld);
 	memset(current->J_buf, 0, size);
 
+	TASK_TRACE_END(TRACE_CURRENT_RESET, current->region_id, current->iter, size);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
+}
+
+// Set the guard cells outside the zone [i0, i1] x [j0, j1] to zero
+void current_clear_gc(t_current *current, const int i0, const int i1, const int j0, const int j1)
+{
+	const int nrow = current->nrow;
+	t_vfld *restrict const J = current->J;
+	const t_vfld zero = { 0 };
+
+	for (int j = -current->gc[1][0]; j < current->nx[1] + current->gc[1][1]; j++)
+	{
+		if (j < j0 || j > j1)
+		{
+			for (int i = -current->gc[0][0]; i < current->nx[0] + current->gc[0][1]; i++)
+				J[i + j * nrow] = zero;
+		} else
+		{
+			for (int i = -current->gc[0][0]; i < i0; i++)
+				J[i + j * nrow] = zero;
+			for (int i = i1 + 1; i < current->nx[0] + current->gc[0][1]; i++)
+				J[i + j * nrow] = zero;
+		}
+	}
 }
 
 // Set the overlap zone between adjacent regions (only the below zone)
@@ -97,6 +138,12 @@ void current_overlap_zone(t_current *current, t_current *current_below)
 // Each region is only responsible to do the reduction operation in its bottom edge
 void current_reduction_y(t_current *current)
 {
+	if (current->absorbing[1][0]) return;
+
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
 	const int nrow = current->nrow;
 	t_vfld *restrict const J = current->J;
 	t_vfld *restrict const J_overlap = current->J_below;
@@ -112,12 +159,21 @@ void current_reduction_y(t_current *current)
 			J_overlap[i + (j + current->gc[1][0]) * nrow] = J[i + j * nrow];
 		}
 	}
+
+	TASK_TRACE_END(TRACE_CURRENT_REDUCTION_Y, current->region_id, current->iter,
+			4 * current->overlap_zone * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_EXCHANGE, current->region_id, current->iter);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 // Current reduction between ghost cells in the x direction
 void current_reduction_x(t_current *current)
 {
-	if (current->moving_window) return;
+	if (current->moving_window || current->absorbing[0][0] || current->absorbing[0][1]) return;
+
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
 
 	const int nrow = current->nrow;
 	t_vfld *restrict const J = current->J;
@@ -135,12 +191,22 @@ void current_reduction_x(t_current *current)
 		}
 	}
 
-	current->iter++;
+	TASK_TRACE_END(TRACE_CURRENT_REDUCTION_X, current->region_id, current->iter,
+			4 * (current->gc[0][0] + current->gc[0][1])
+			* (current->gc[1][0] + current->nx[1] + current->gc[1][1]) * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_EXCHANGE, current->region_id, current->iter);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 // Update the ghost cells in the y direction (only the bottom edge)
 void current_gc_update_y(t_current *current)
 {
+	if (current->absorbing[1][0]) return;
+
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
 	const int nrow = current->nrow;
 	t_vfld *restrict const J = current->J;
 	t_vfld *restrict const J_overlap = current->J_below;
@@ -160,6 +226,11 @@ void current_gc_update_y(t_current *current)
 			J_overlap[i + (j + current->gc[1][0]) * nrow] = J[i + j * nrow];
 		}
 	}
+
+	TASK_TRACE_END(TRACE_CURRENT_UPDATE_GC, current->region_id, current->iter,
+			2 * current->overlap_zone * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_EXCHANGE, current->region_id, current->iter);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 /*********************************************************************************************
@@ -211,8 +282,8 @@ void kernel_x(t_current *const current, const t_fld sa, const t_fld sb)
 
 		}
 
-		// Update x boundaries unless we are using a moving window
-		if (!current->moving_window)
+		// Update x boundaries unless we are using a moving window (or absorbing boundaries)
+		if (!current->moving_window && !current->absorbing[0][0] && !current->absorbing[0][1])
 		{
 			for (i = -current->gc[0][0]; i < 0; i++)
 				J[idx + i] = J[idx + current->nx[0] + i];
@@ -270,6 +341,10 @@ void kernel_y(t_current *const current, const t_fld sa, const t_fld sb)
 // Then, pass a compensation filter (if applicable)
 void current_smooth_x(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
 	// filter kernel [sa, sb, sa]
 	t_fld sa, sb;
 
@@ -283,12 +358,21 @@ void current_smooth_x(t_current *current)
 		get_smooth_comp(current->smooth.xlevel, &sa, &sb);
 		kernel_x(current, sa, sb);
 	}
+
+	TASK_TRACE_END(TRACE_CURRENT_SMOOTH_X, current->region_id, current->iter,
+			2 * (current->smooth.xlevel + 1) * current->total_size * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_CURRENT_FILTER, current->region_id, current->iter);
+	timer_phase_add(TIMER_FILTER, t0);
 }
 
 // Apply a binomial filter to reduce noise (Y direction).
 // Or, apply a compensation filter (if applicable)
 void current_smooth_y(t_current *current, enum smooth_type type)
 {
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
 	// filter kernel [sa, sb, sa]
 	t_fld sa, sb;
 
@@ -304,6 +388,11 @@ void current_smooth_y(t_current *current, enum smooth_type type)
 		default:
 			break;
 	}
+
+	TASK_TRACE_END(TRACE_CURRENT_SMOOTH_Y, current->region_id, current->iter,
+			2 * current->total_size * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_CURRENT_FILTER, current->region_id, current->iter);
+	timer_phase_add(TIMER_FILTER, t0);
 }
 
 /*********************************************************************************************
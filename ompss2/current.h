@@ -15,6 +15,7 @@
 #include <stdbool.h>
 
 #include "zpic.h"
+#include "task_priority.h"
 
 enum smooth_type {
 	NONE, BINOMIAL, COMPENSATED
@@ -56,6 +57,13 @@ typedef struct {
 	// Moving window
 	bool moving_window;
 
+	// Edges of the region that are absorbing boundaries of the simulation box ([x/y][lower/upper]).
+	// The current deposited outside the box is not wrapped around
+	bool absorbing[2][2];
+
+	// Region that owns the current
+	int region_id;
+
 	// Pointer to the overlap zone (in the current buffer) in the region below
 	// overlap zone = ghost cells (DOWN) + ghost cells (UP from below region)
 	t_vfld *J_below;
@@ -64,8 +72,10 @@ typedef struct {
 
 // Setup
 void current_new(t_current *current, int nx[], t_fld box[], float dt);
+void current_new_gc(t_current *current, int nx[], const int gc[2][2], t_fld box[], float dt);
 void current_delete(t_current *current);
 void current_overlap_zone(t_current *current, t_current *upper_current);
+void current_clear_gc(t_current *current, const int i0, const int i1, const int j0, const int j1);
 
 // Report ZDF
 void current_reconstruct_global_buffer(t_current *current, float *global_buffer, const int offset,
@@ -74,26 +84,30 @@ void current_report(const float *restrict global_buffer, const int iter_num, con
 		const float box[2], const float dt, const char jc, const char path[128]);
 
 // CPU Tasks
-#pragma oss task out(current->J_buf[0; current->total_size]) label("Current Reset")
+#pragma oss task out(current->J_buf[0; current->total_size]) label("Current Reset") \
+priority(task_priority[TRACE_CURRENT_RESET])
 void current_zero(t_current *current);
 
 #pragma oss task inout(current->J_buf[0; current->overlap_zone]) \
 inout(current->J_below[-current->gc[0][0]; current->overlap_zone]) \
-label("Current Reduction Y")
+label("Current Reduction Y") priority(task_priority[TRACE_CURRENT_REDUCTION_Y])
 void current_reduction_y(t_current *current); // Each region only update the zone in the top edge
 
-#pragma oss task inout(current->J_buf[0; current->total_size]) label("Current Reduction X")
+#pragma oss task inout(current->J_buf[0; current->total_size]) label("Current Reduction X") \
+priority(task_priority[TRACE_CURRENT_REDUCTION_X])
 void current_reduction_x(t_current *current);
 
 #pragma oss task inout(current->J_buf[0; current->overlap_zone]) \
 inout(current->J_below[-current->gc[0][0]; current->overlap_zone]) \
-label("Current Update GC")
+label("Current Update GC") priority(task_priority[TRACE_CURRENT_UPDATE_GC])
 void current_gc_update_y(t_current *current); // Each region only update the zone in the top edge
 
-#pragma oss task inout(current->J_buf[0; current->total_size]) label("Current Smooth X")
+#pragma oss task inout(current->J_buf[0; current->total_size]) label("Current Smooth X") \
+priority(task_priority[TRACE_CURRENT_SMOOTH_X])
 void current_smooth_x(t_current *current);
 
-#pragma oss task inout(current->J_buf[0; current->total_size]) label("Current Smooth Y")
+#pragma oss task inout(current->J_buf[0; current->total_size]) label("Current Smooth Y") \
+priority(task_priority[TRACE_CURRENT_SMOOTH_Y])
 void current_smooth_y(t_current *current, enum smooth_type type);
 
 #endif
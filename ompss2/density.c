@@ -0,0 +1,163 @@
+/*********************************************************************************************
+ ZPIC
+ density.c
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#include <math.h>
+
+#include "density.h"
+
+/*********************************************************************************************
+ Profiles
+ *********************************************************************************************/
+
+// Position of the table value to interpolate (index and weight of the next value)
+static void density_table_coord(const float pos, const float box, const int nx, int *k, int *k1,
+		float *w)
+{
+	float u = pos / box * nx - 0.5f;
+
+	if (u < 0.0f) u = 0.0f;
+	if (u > nx - 1) u = nx - 1;
+
+	*k = (int) u;
+	*k1 = *k < nx - 1 ? *k + 1 : *k;
+	*w = u - *k;
+}
+
+// Density profile (relative to the reference density) in the cells [i0, i1) of the row j.
+// Each loop is specialized for one profile type, so it can be vectorized
+void density_eval_row(const t_density *density, const int j, const int i0, const int i1,
+		const float dx[2], const int n_move, float *restrict profile)
+{
+	const int size = i1 - i0;
+
+	// Lorentz contraction of the lab frame profile (boosted frame)
+	const float gamma = density->gamma > 1.0f ? density->gamma : 1.0f;
+	const float origin = density->gamma > 1.0f ? density->origin : 0.0f;
+
+	// Position of the cell centers in the lab frame (the x position includes the moving window
+	// shift or the plasma flow of the boosted frame)
+	const float x0 = origin + gamma * ((i0 + 0.5f + n_move) * dx[0] - origin);
+	const float dx_lab = gamma * dx[0];
+	const float y = (j + 0.5f) * dx[1];
+
+	switch (density->type)
+	{
+		case STEP:
+		{
+			// Get edge position normalized to cell size;
+			const int start = (origin + (density->start - origin) / gamma) / dx[0] - n_move;
+
+			for (int i = 0; i < size; i++)
+				profile[i] = i0 + i >= start;
+			break;
+		}
+
+		case SLAB:
+		{
+			// Get edge position normalized to cell size;
+			const int start = (origin + (density->start - origin) / gamma) / dx[0] - n_move;
+			const int end = (origin + (density->end - origin) / gamma) / dx[0] - n_move;
+
+			for (int i = 0; i < size; i++)
+				profile[i] = i0 + i >= start && i0 + i < end;
+			break;
+		}
+
+		case RAMP:
+		{
+			const float start = density->start;
+			const float end = density->end;
+			const float slope = end > start ? (density->ramp[1] - density->ramp[0]) / (end - start) : 0;
+
+			for (int i = 0; i < size; i++)
+			{
+				const float x = x0 + i * dx_lab;
+				float n = x < end ? density->ramp[0] + slope * (x - start) : density->ramp[1];
+				profile[i] = x < start ? 0.0f : n;
+			}
+			break;
+		}
+
+		case GAUSS:
+		{
+			const float cx = density->center[0];
+			const float ax = density->sigma[0] > 0 ? 0.5f / (density->sigma[0] * density->sigma[0]) : 0;
+			const float ay = density->sigma[1] > 0 ? 0.5f / (density->sigma[1] * density->sigma[1]) : 0;
+			const float ny = expf(-ay * (y - density->center[1]) * (y - density->center[1]));
+
+			for (int i = 0; i < size; i++)
+			{
+				const float x = x0 + i * dx_lab;
+				profile[i] = ny * expf(-ax * (x - cx) * (x - cx));
+			}
+			break;
+		}
+
+		case CHANNEL:
+		{
+			const float r = density->radius > 0 ? (y - density->axis) / density->radius : 0;
+			const float n = 1.0f + density->depth * r * r;
+			const float start = density->start;
+
+			for (int i = 0; i < size; i++)
+				profile[i] = x0 + i * dx_lab < start ? 0.0f : n;
+			break;
+		}
+
+		case TABLE:
+		{
+			const int tnx = density->table_nx[0];
+			const int tny = density->table_nx[1] > 1 ? density->table_nx[1] : 1;
+			int ky = 0, ky1 = 0;
+			float wy = 0;
+
+			if (tny > 1)
+				density_table_coord(y, density->table_box[1], tny, &ky, &ky1, &wy);
+
+			const float *restrict row0 = density->table + ky * tnx;
+			const float *restrict row1 = density->table + ky1 * tnx;
+
+			for (int i = 0; i < size; i++)
+			{
+				int kx, kx1;
+				float wx;
+				density_table_coord(x0 + i * dx_lab, density->table_box[0], tnx, &kx, &kx1, &wx);
+
+				const float n0 = (1.0f - wx) * row0[kx] + wx * row0[kx1];
+				const float n1 = (1.0f - wx) * row1[kx] + wx * row1[kx1];
+				profile[i] = (1.0f - wy) * n0 + wy * n1;
+			}
+			break;
+		}
+
+		default:    // Uniform density
+			for (int i = 0; i < size; i++)
+				profile[i] = 1.0f;
+	}
+}
+
+// Number of particles in each cell of a row (npc particles for a relative density of 1). The
+// fractional part is carried along the row, so the total matches the integral of the profile.
+// Returns the total number of particles in the row
+int density_np_row(const float *restrict profile, const int size, const int npc,
+		int *restrict np_cell)
+{
+	double acc = 0;
+	int total = 0;
+
+	for (int i = 0; i < size; i++)
+	{
+		if (profile[i] > 0) acc += (double) npc * profile[i];
+
+		const int next = (int) (acc + 0.5);
+		np_cell[i] = next - total;
+		total = next;
+	}
+
+	return total;
+}
@@ -0,0 +1,55 @@
+/*********************************************************************************************
+ ZPIC
+ density.h
+
+ Density profiles of the particle species. The profile is evaluated once per cell and sets the
+ number of particles injected in the cell (the charge of the particles is not changed).
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __DENSITY__
+#define __DENSITY__
+
+enum density_type {
+	UNIFORM, STEP, SLAB, RAMP, GAUSS, CHANNEL, TABLE
+};
+
+// All the positions are in simulation units. The profile is relative to n (1.0 = ppc particles
+// per cell) and is evaluated in the center of each cell, except for STEP and SLAB, which
+// include the cells after start (and before end)
+typedef struct {
+	float n;				// reference density (defaults to 1.0, multiplies density profile)
+	enum density_type type;		// Density profile type
+	float start, end;		// Position of the plasma start/end, in simulation units
+
+	// RAMP: 0 before start, linear from ramp[0] (start) to ramp[1] (end), ramp[1] after end
+	float ramp[2];
+
+	// GAUSS: exp(-(x - center)^2 / (2 sigma^2)) in each direction (sigma = 0: uniform)
+	float center[2];
+	float sigma[2];
+
+	// CHANNEL: 0 before start, 1 + depth * ((y - axis) / radius)^2 after start
+	float axis, depth, radius;
+
+	// TABLE: table_nx[0] x table_nx[1] values (x is the fastest index) in the cell centers of a
+	// regular grid over [0, table_box[0]] x [0, table_box[1]], bilinear interpolation and
+	// nearest value outside the grid. 1D profiles (along x) have table_nx[1] = 1
+	const float *table;
+	int table_nx[2];
+	float table_box[2];
+
+	// Boosted frame (set by sim_set_boost): the profile above is given in the lab frame and it is
+	// contracted along x by gamma around the position origin (gamma = 0: lab frame)
+	float gamma, origin;
+
+} t_density;
+
+void density_eval_row(const t_density *density, const int j, const int i0, const int i1,
+		const float dx[2], const int n_move, float *restrict profile);
+int density_np_row(const float *restrict profile, const int size, const int npc,
+		int *restrict np_cell);
+
+#endif
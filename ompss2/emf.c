@@ -18,6 +18,8 @@
 #include "emf.h"
 #include "zdf.h"
 #include "timer.h"
+#include "perf_counters.h"
+#include "task_trace.h"
 
 /*********************************************************************************************
  Constructor / Destructor
@@ -26,8 +28,8 @@ void emf_new(t_emf *emf, int nx[], t_fld box[], const float dt)
 {
 	int i;
 
-	// Number of guard cells for linear interpolation
-	int gc[2][2] = { { 1, 2 }, { 1, 2 } };
+	// Number of guard cells for the interpolation with the particle shape
+	int gc[2][2] = { { SHAPE_GC_LOWER, SHAPE_GC_UPPER }, { SHAPE_GC_LOWER, SHAPE_GC_UPPER } };
 
 	// Allocate global arrays
 	size_t size;
@@ -77,6 +79,16 @@ void emf_new(t_emf *emf, int nx[], t_fld box[], const float dt)
 	// Reset moving window information
 	emf->moving_window = false;
 	emf->n_move = 0;
+
+	// Periodic boundaries
+	for (i = 0; i < 2; i++)
+		emf->absorbing[i][0] = emf->absorbing[i][1] = false;
+	emf->pml = NULL;
+
+	emf->n_antennas = 0;
+	emf->antennas = NULL;
+
+	emf->region_id = 0;
 }
 
 // Set the overlap zone between regions (below zone only)
@@ -84,6 +96,31 @@ void emf_overlap_zone(t_emf *emf, t_emf *below)
 {
 	emf->B_below = below->B + (below->nx[1] - below->gc[1][0]) * below->nrow;
 	emf->E_below = below->E + (below->nx[1] - below->gc[1][0]) * below->nrow;
+
+	// The convolution terms are exchanged like the fields (if both regions have PML cells)
+	if (emf->pml)
+	{
+		if (below->pml)
+		{
+			emf->pml->psi_B_below = below->pml->psi_B + (below->nx[1] - below->gc[1][0]) * below->nrow;
+			emf->pml->psi_E_below = below->pml->psi_E + (below->nx[1] - below->gc[1][0]) * below->nrow;
+		} else
+		{
+			emf->pml->psi_B_below = NULL;
+			emf->pml->psi_E_below = NULL;
+		}
+	}
+}
+
+static void emf_pml_delete(t_emf *emf)
+{
+	if (!emf->pml) return;
+
+	free(emf->pml->coef_buf);
+	free(emf->pml->psi_E_buf);
+	free(emf->pml->psi_B_buf);
+	free(emf->pml);
+	emf->pml = NULL;
 }
 
 void emf_delete(t_emf *emf)
@@ -93,13 +130,136 @@ void emf_delete(t_emf *emf)
 
 	emf->E_buf = NULL;
 	emf->B_buf = NULL;
+
+	emf_pml_delete(emf);
+
+	free(emf->antennas);
+	emf->antennas = NULL;
+	emf->n_antennas = 0;
+}
+
+/*********************************************************************************************
+ Boundaries
+ *********************************************************************************************/
+
+// Coefficients of the PML convolution terms at the position pos (in cells) along a direction
+// with n cells. The conductivity grows with the cube of the depth inside the layer and the
+// frequency shift (CFS) decreases linearly, so the static fields are also damped
+static t_pml_coef pml_coef(const float pos, const int n, const bool lower, const bool upper,
+		const int size, const float sigma_max, const float dt)
+{
+	float depth = 0;
+
+	if (lower && pos < size) depth = size - pos;
+	if (upper && pos > n - size) depth = pos - (n - size);
+	if (depth > size) depth = size;
+
+	const float d = depth / size;
+	const float sigma = sigma_max * d * d * d;
+	const float alpha = PML_ALPHA_MAX * (1.0f - d);
+
+	t_pml_coef coef = {.b = 1.0f, .a = 0.0f};
+	if (sigma > 0)
+	{
+		coef.b = expf(-(sigma + alpha) * dt);
+		coef.a = sigma / (sigma + alpha) * (coef.b - 1.0f);
+	}
+
+	return coef;
+}
+
+// Set the boundary conditions of the region fields. offset_y is the first row of the region
+// and global_ny the number of rows of the simulation box
+void emf_set_boundaries(t_emf *emf, const t_boundary *boundary, const int offset_y,
+		const int global_ny)
+{
+	bool pml_edge[2][2];
+	for (int d = 0; d < 2; d++)
+		for (int e = 0; e < 2; e++)
+			pml_edge[d][e] = boundary->type[d][e] == BOUNDARY_PML;
+
+	// The y edges only belong to the first and last region
+	emf->absorbing[0][0] = pml_edge[0][0];
+	emf->absorbing[0][1] = pml_edge[0][1];
+	emf->absorbing[1][0] = pml_edge[1][0] && offset_y == 0;
+	emf->absorbing[1][1] = pml_edge[1][1] && offset_y + emf->nx[1] == global_ny;
+
+	emf_pml_delete(emf);
+
+	const int size = boundary->pml_size;
+	const int nrow = emf->nrow;
+	const int ncol = emf->gc[1][0] + emf->nx[1] + emf->gc[1][1];
+
+	t_pml *pml = malloc(sizeof(t_pml));
+	assert(pml);
+	pml->coef_buf = malloc(2 * (nrow + ncol) * sizeof(t_pml_coef));
+	assert(pml->coef_buf);
+
+	pml->coef_E[0] = pml->coef_buf + emf->gc[0][0];
+	pml->coef_B[0] = pml->coef_buf + nrow + emf->gc[0][0];
+	pml->coef_E[1] = pml->coef_buf + 2 * nrow + emf->gc[1][0];
+	pml->coef_B[1] = pml->coef_buf + 2 * nrow + ncol + emf->gc[1][0];
+
+	// sigma_max = -(m + 1) ln(R) / (2 L), with a cubic profile (m = 3) and c = 1
+	float sigma_max[2];
+	for (int d = 0; d < 2; d++)
+		sigma_max[d] = -4.0f * logf(boundary->pml_reflection) / (2.0f * size * emf->dx[d]);
+
+	// The derivatives used to advance E are centered in the cell edges and the ones used to
+	// advance B are centered in the cell (E and B are staggered)
+	for (int i = -emf->gc[0][0]; i < emf->nx[0] + emf->gc[0][1]; i++)
+	{
+		pml->coef_E[0][i] = pml_coef(i, emf->nx[0], pml_edge[0][0], pml_edge[0][1], size,
+				sigma_max[0], emf->dt);
+		pml->coef_B[0][i] = pml_coef(i + 0.5f, emf->nx[0], pml_edge[0][0], pml_edge[0][1], size,
+				sigma_max[0], emf->dt / 2);
+	}
+
+	bool has_pml = pml_edge[0][0] || pml_edge[0][1];
+	for (int j = -emf->gc[1][0]; j < emf->nx[1] + emf->gc[1][1]; j++)
+	{
+		pml->coef_E[1][j] = pml_coef(offset_y + j, global_ny, pml_edge[1][0], pml_edge[1][1],
+				size, sigma_max[1], emf->dt);
+		pml->coef_B[1][j] = pml_coef(offset_y + j + 0.5f, global_ny, pml_edge[1][0],
+				pml_edge[1][1], size, sigma_max[1], emf->dt / 2);
+
+		if (pml->coef_E[1][j].a != 0 || pml->coef_B[1][j].a != 0) has_pml = true;
+	}
+
+	if (!has_pml)
+	{
+		free(pml->coef_buf);
+		free(pml);
+		return;
+	}
+
+	pml->x_lower_end = pml_edge[0][0] ? size : -emf->gc[0][0];
+	pml->x_upper_begin = pml_edge[0][1] ? emf->nx[0] - size : emf->nx[0] + emf->gc[0][1];
+
+	pml->psi_E_buf = calloc(emf->total_size, sizeof(t_pml_psi));
+	pml->psi_B_buf = calloc(emf->total_size, sizeof(t_pml_psi));
+	assert(pml->psi_E_buf && pml->psi_B_buf);
+
+	pml->psi_E = pml->psi_E_buf + emf->gc[0][0] + emf->gc[1][0] * nrow;
+	pml->psi_B = pml->psi_B_buf + emf->gc[0][0] + emf->gc[1][0] * nrow;
+	pml->psi_E_below = NULL;
+	pml->psi_B_below = NULL;
+
+	emf->pml = pml;
+}
+
+// Check if the row j crosses a y layer
+static inline bool pml_row(const t_pml *pml, const int j)
+{
+	return pml->coef_E[1][j].a != 0 || pml->coef_B[1][j].a != 0;
 }
 
 /*********************************************************************************************
  Laser Pulses
  *********************************************************************************************/
 
-t_fld gauss_phase(const t_emf_laser *const laser, const t_fld z, const t_fld r)
+// Gaussian beam at the position z and time t (the beam shape only depends on z)
+t_fld gauss_phase(const t_emf_laser *const laser, const t_fld z, const t_fld t, const t_fld r)
 {
 	t_fld z0 = laser->omega0 * (laser->W0 * laser->W0) / 2;
 	t_fld rho2 = r * r;
@@ -108,7 +268,7 @@ t_fld gauss_phase(const t_emf_laser *const laser, const t_fld z, const t_fld r)
 	t_fld gouy_shift = atan2(z, z0);
 
 	return sqrt(sqrt(rWl2)) * exp(-rho2 * rWl2 / (laser->W0 * laser->W0))
-			* cos(laser->omega0 * (z + curv) - gouy_shift);
+			* cos(laser->omega0 * (z - t + curv) - gouy_shift);
 }
 
 t_fld lon_env(const t_emf_laser *const laser, const t_fld z)
@@ -140,6 +300,14 @@ t_fld lon_env(const t_emf_laser *const laser, const t_fld z)
 	return 0.0;
 }
 
+// Lab frame event (position and time) of the position x of the boosted frame at t' = 0
+static inline void laser_event(const t_fld x, const t_fld gamma, const t_fld beta,
+		const t_fld origin, t_fld *z, t_fld *t)
+{
+	*z = origin + gamma * (x - origin);
+	*t = gamma * beta * (x - origin);
+}
+
 void div_corr_x(t_emf *emf)
 {
 	int i, j;
@@ -166,9 +334,9 @@ void div_corr_x(t_emf *emf)
 	}
 }
 
-void emf_add_laser(t_emf *const emf, t_emf_laser *laser, int offset_y)
+// Validate the laser parameters (the fwhm parameter overrides the rise/flat/fall parameters)
+void emf_laser_validate(t_emf_laser *laser)
 {
-	// Validate laser parameters
 	if (laser->fwhm != 0)
 	{
 		if (laser->fwhm <= 0)
@@ -199,11 +367,27 @@ void emf_add_laser(t_emf *const emf, t_emf_laser *laser, int offset_y)
 		fprintf(stderr, "Invalid laser FALL, must be > 0, aborting.\n");
 		exit(-1);
 	}
+}
+
+void emf_add_laser(t_emf *const emf, t_emf_laser *laser, int offset_y)
+{
+	emf_add_laser_boosted(emf, laser, offset_y, 1.0f, 0.0f);
+}
+
+// Add a laser pulse defined in the lab frame to the fields of a frame moving along x with the
+// Lorentz factor gamma. Both frames coincide at the event (origin, t = 0), so each position x' of
+// the boosted frame at t' = 0 is the lab frame event (origin + gamma (x' - origin),
+// gamma beta (x' - origin)), where the laser is evaluated. The field amplitude is multiplied by
+// gamma (1 - beta) (plane wave transformation)
+void emf_add_laser_boosted(t_emf *const emf, t_emf_laser *laser, int offset_y, const float gamma,
+		const float origin)
+{
+	emf_laser_validate(laser);
 
 	// Launch laser
 	int i, j, nrow;
 
-	t_fld r_center, z, z_2, r, r_2;
+	t_fld r_center, z, z_2, t, t_2, r, r_2;
 	t_fld amp, lenv, lenv_2, k;
 	t_fld dx, dy;
 	t_fld cos_pol, sin_pol;
@@ -215,8 +399,10 @@ void emf_add_laser(t_emf *const emf, t_emf_laser *laser, int offset_y)
 	dx = emf->dx[0];
 	dy = emf->dx[1];
 
+	const t_fld beta = sqrtf(1.0f - 1.0f / (gamma * gamma));
+
 	r_center = laser->axis;
-	amp = laser->omega0 * laser->a0;
+	amp = laser->omega0 * laser->a0 * gamma * (1.0f - beta);
 
 	cos_pol = cos(laser->polarization);
 	sin_pol = sin(laser->polarization);
@@ -228,21 +414,21 @@ void emf_add_laser(t_emf *const emf, t_emf_laser *laser, int offset_y)
 
 			for (i = 0; i < emf->nx[0]; i++)
 			{
-				z = i * dx;
-				z_2 = z + dx / 2;
+				laser_event(i * dx, gamma, beta, origin, &z, &t);
+				laser_event(i * dx + dx / 2, gamma, beta, origin, &z_2, &t_2);
 
-				lenv = amp * lon_env(laser, z);
-				lenv_2 = amp * lon_env(laser, z_2);
+				lenv = amp * lon_env(laser, z - t);
+				lenv_2 = amp * lon_env(laser, z_2 - t_2);
 
 				for (j = 0; j < emf->nx[1]; j++)
 				{
 					// E[i + j*nrow].x += 0.0
-					E[i + j * nrow].y += +lenv * cos(k * z) * cos_pol;
-					E[i + j * nrow].z += +lenv * cos(k * z) * sin_pol;
+					E[i + j * nrow].y += +lenv * cos(k * (z - t)) * cos_pol;
+					E[i + j * nrow].z += +lenv * cos(k * (z - t)) * sin_pol;
 
 					// E[i + j*nrow].x += 0.0
-					B[i + j * nrow].y += -lenv_2 * cos(k * z_2) * sin_pol;
-					B[i + j * nrow].z += +lenv_2 * cos(k * z_2) * cos_pol;
+					B[i + j * nrow].y += -lenv_2 * cos(k * (z_2 - t_2)) * sin_pol;
+					B[i + j * nrow].z += +lenv_2 * cos(k * (z_2 - t_2)) * cos_pol;
 				}
 			}
 			break;
@@ -251,11 +437,11 @@ void emf_add_laser(t_emf *const emf, t_emf_laser *laser, int offset_y)
 
 			for (i = 0; i < emf->nx[0]; i++)
 			{
-				z = i * dx;
-				z_2 = z + dx / 2;
+				laser_event(i * dx, gamma, beta, origin, &z, &t);
+				laser_event(i * dx + dx / 2, gamma, beta, origin, &z_2, &t_2);
 
-				lenv = amp * lon_env(laser, z);
-				lenv_2 = amp * lon_env(laser, z_2);
+				lenv = amp * lon_env(laser, z - t);
+				lenv_2 = amp * lon_env(laser, z_2 - t_2);
 
 				for (j = 0; j < emf->nx[1]; j++)
 				{
@@ -263,12 +449,12 @@ void emf_add_laser(t_emf *const emf, t_emf_laser *laser, int offset_y)
 					r_2 = r + dy / 2;
 
 					// E[i + j*nrow].x += 0.0
-					E[i + j * nrow].y += +lenv * gauss_phase(laser, z, r_2) * cos_pol;
-					E[i + j * nrow].z += +lenv * gauss_phase(laser, z, r) * sin_pol;
+					E[i + j * nrow].y += +lenv * gauss_phase(laser, z, t, r_2) * cos_pol;
+					E[i + j * nrow].z += +lenv * gauss_phase(laser, z, t, r) * sin_pol;
 
 					// B[i + j*nrow].x += 0.0
-					B[i + j * nrow].y += -lenv_2 * gauss_phase(laser, z_2, r) * sin_pol;
-					B[i + j * nrow].z += +lenv_2 * gauss_phase(laser, z_2, r_2) * cos_pol;
+					B[i + j * nrow].y += -lenv_2 * gauss_phase(laser, z_2, t_2, r) * sin_pol;
+					B[i + j * nrow].z += +lenv_2 * gauss_phase(laser, z_2, t_2, r_2) * cos_pol;
 
 				}
 			}
@@ -278,6 +464,107 @@ void emf_add_laser(t_emf *const emf, t_emf_laser *laser, int offset_y)
 	}
 }
 
+/*********************************************************************************************
+ Laser Antennas
+ *********************************************************************************************/
+
+// Add a laser antenna in the plane x (lab frame). The laser is emitted as it is defined in
+// emf_add_laser, but only when it crosses the plane, so the pulse does not need to fit in the box
+void emf_add_antenna(t_emf *const emf, t_emf_laser *laser, const float x, const int offset_y)
+{
+	emf_laser_validate(laser);
+
+	emf->antennas = realloc(emf->antennas, (emf->n_antennas + 1) * sizeof(t_emf_antenna));
+	assert(emf->antennas);
+
+	emf->antennas[emf->n_antennas] = (t_emf_antenna) {.laser = *laser, .x = x,
+			.offset_y = offset_y};
+	emf->n_antennas++;
+}
+
+// Field of the laser at the position z (lab frame) and time t, for the transverse position r
+static inline t_fld antenna_field(const t_emf_laser *const laser, const t_fld z, const t_fld t,
+		const t_fld r)
+{
+	const t_fld lenv = laser->omega0 * laser->a0 * lon_env(laser, z - t);
+	if (lenv == 0) return 0;
+
+	if (laser->type == GAUSSIAN) return lenv * gauss_phase(laser, z, t, r);
+	else return lenv * cos(laser->omega0 * (z - t));
+}
+
+// Column of the antenna in the current position of the (moving) window (-1 if the antenna is
+// outside the box)
+static inline int antenna_cell(const t_emf *emf, const t_emf_antenna *antenna)
+{
+	const int i = lroundf(antenna->x / emf->dx[0]) - emf->n_move;
+	return (i >= 0 && i < emf->nx[0]) ? i : -1;
+}
+
+// The antennas are total field / scattered field boundaries: the laser fields are added to the
+// curl of the fields in both sides of the plane. The E update of the plane (x_a) receives the B
+// of the laser in x_a - dx / 2 (electric current sheet) and the B update of the cell behind it
+// receives the E of the laser in x_a (magnetic current sheet), so the laser is emitted forward
+// (+x). The laser fields are the analytic solution, which does not follow the numerical
+// dispersion of the grid, so a small part leaks backwards (about 1e-4 of the amplitude in
+// vacuum). This is the E update at the time t
+static void antenna_e(t_emf *emf, const float t, const float dt)
+{
+	const int nrow = emf->nrow;
+	const t_fld dt_dx = dt / emf->dx[0];
+	const t_fld dy = emf->dx[1];
+	t_vfld *restrict E = emf->E;
+
+	for (int k = 0; k < emf->n_antennas; k++)
+	{
+		const t_emf_antenna *antenna = &emf->antennas[k];
+		const t_emf_laser *laser = &antenna->laser;
+		const int i = antenna_cell(emf, antenna);
+		if (i < 0) continue;
+
+		const t_fld z = (i + emf->n_move - 0.5f) * emf->dx[0];
+		const t_fld cos_pol = cos(laser->polarization);
+		const t_fld sin_pol = sin(laser->polarization);
+
+		for (int j = -emf->gc[1][0]; j < emf->nx[1] + emf->gc[1][1]; j++)
+		{
+			const t_fld r = (j + antenna->offset_y) * dy - laser->axis;
+
+			E[i + j * nrow].y += dt_dx * antenna_field(laser, z, t, r + dy / 2) * cos_pol;
+			E[i + j * nrow].z += dt_dx * antenna_field(laser, z, t, r) * sin_pol;
+		}
+	}
+}
+
+// B update of the antennas at the time t (see antenna_e)
+static void antenna_b(t_emf *emf, const float t, const float dt)
+{
+	const int nrow = emf->nrow;
+	const t_fld dt_dx = dt / emf->dx[0];
+	const t_fld dy = emf->dx[1];
+	t_vfld *restrict B = emf->B;
+
+	for (int k = 0; k < emf->n_antennas; k++)
+	{
+		const t_emf_antenna *antenna = &emf->antennas[k];
+		const t_emf_laser *laser = &antenna->laser;
+		const int i = antenna_cell(emf, antenna);
+		if (i < 0) continue;
+
+		const t_fld z = (i + emf->n_move) * emf->dx[0];
+		const t_fld cos_pol = cos(laser->polarization);
+		const t_fld sin_pol = sin(laser->polarization);
+
+		for (int j = -emf->gc[1][0]; j < emf->nx[1] + emf->gc[1][1]; j++)
+		{
+			const t_fld r = (j + antenna->offset_y) * dy - laser->axis;
+
+			B[i - 1 + j * nrow].y -= dt_dx * antenna_field(laser, z, t, r) * sin_pol;
+			B[i - 1 + j * nrow].z += dt_dx * antenna_field(laser, z, t, r + dy / 2) * cos_pol;
+		}
+	}
+}
+
 /*********************************************************************************************
  Diagnostics
  *********************************************************************************************/
@@ -483,6 +770,135 @@ void yee_e(t_emf *emf, const t_current *current, const float dt)
 	}
 }
 
+// Same as yee_e, but each current cell is cleared after being used. The current is not needed
+// after the field solver, so it is ready for the next time step without a separate memset
+void yee_e_consume(t_emf *emf, t_current *current, const float dt)
+{
+	// these must not be unsigned because we access negative cell indexes
+	int i, j;
+	t_fld dt_dx, dt_dy;
+
+	dt_dx = dt / emf->dx[0];
+	dt_dy = dt / emf->dx[1];
+
+	t_vfld *const restrict E = emf->E;
+	const t_vfld *const restrict B = emf->B;
+	t_vfld *const restrict J = current->J;
+
+	const int nrow_e = emf->nrow;
+	const int nrow_j = current->nrow;
+	const t_vfld zero = { 0 };
+
+	for (j = 0; j <= emf->nx[1] + 1; j++)
+	{
+		for (i = 0; i <= emf->nx[0] + 1; i++)
+		{
+			const t_vfld Jc = J[i + j * nrow_j];
+			J[i + j * nrow_j] = zero;
+
+			E[i + j * nrow_e].x += (+dt_dy * (B[i + j * nrow_e].z - B[i + (j - 1) * nrow_e].z))
+					- dt * Jc.x;
+
+			E[i + j * nrow_e].y += (-dt_dx * (B[i + j * nrow_e].z - B[(i - 1) + j * nrow_e].z))
+					- dt * Jc.y;
+
+			E[i + j * nrow_e].z += (+dt_dx * (B[i + j * nrow_e].y - B[(i - 1) + j * nrow_e].y)
+					- dt_dy * (B[i + j * nrow_e].x - B[i + (j - 1) * nrow_e].x))
+					- dt * Jc.z;
+		}
+	}
+
+	// The remaining guard cells are not used by the field solver
+	current_clear_gc(current, 0, emf->nx[0] + 1, 0, emf->nx[1] + 1);
+}
+
+// Convolution terms of the PML in the cells [i0, i1) of the row j (after advancing B)
+static void pml_b_row(t_emf *emf, const int j, const int i0, const int i1, const float dt)
+{
+	const t_pml *const pml = emf->pml;
+	const int nrow = emf->nrow;
+	const t_fld rdx = 1.0f / emf->dx[0];
+	const t_fld rdy = 1.0f / emf->dx[1];
+	const t_pml_coef cy = pml->coef_B[1][j];
+	const t_pml_coef *const restrict cx = pml->coef_B[0];
+
+	t_vfld *const restrict B = emf->B + j * nrow;
+	const t_vfld *const restrict E = emf->E + j * nrow;
+	t_pml_psi *const restrict psi = pml->psi_B + j * nrow;
+
+	for (int i = i0; i < i1; i++)
+	{
+		psi[i].yx = cx[i].b * psi[i].yx + cx[i].a * rdx * (E[i + 1].z - E[i].z);
+		psi[i].zx = cx[i].b * psi[i].zx + cx[i].a * rdx * (E[i + 1].y - E[i].y);
+		psi[i].xy = cy.b * psi[i].xy + cy.a * rdy * (E[i + nrow].z - E[i].z);
+		psi[i].zy = cy.b * psi[i].zy + cy.a * rdy * (E[i + nrow].x - E[i].x);
+
+		B[i].x -= dt * psi[i].xy;
+		B[i].y += dt * psi[i].yx;
+		B[i].z += dt * (psi[i].zy - psi[i].zx);
+	}
+}
+
+// Convolution terms of the PML in the cells [i0, i1) of the row j (after advancing E)
+static void pml_e_row(t_emf *emf, const int j, const int i0, const int i1, const float dt)
+{
+	const t_pml *const pml = emf->pml;
+	const int nrow = emf->nrow;
+	const t_fld rdx = 1.0f / emf->dx[0];
+	const t_fld rdy = 1.0f / emf->dx[1];
+	const t_pml_coef cy = pml->coef_E[1][j];
+	const t_pml_coef *const restrict cx = pml->coef_E[0];
+
+	t_vfld *const restrict E = emf->E + j * nrow;
+	const t_vfld *const restrict B = emf->B + j * nrow;
+	t_pml_psi *const restrict psi = pml->psi_E + j * nrow;
+
+	for (int i = i0; i < i1; i++)
+	{
+		psi[i].yx = cx[i].b * psi[i].yx + cx[i].a * rdx * (B[i].z - B[i - 1].z);
+		psi[i].zx = cx[i].b * psi[i].zx + cx[i].a * rdx * (B[i].y - B[i - 1].y);
+		psi[i].xy = cy.b * psi[i].xy + cy.a * rdy * (B[i].z - B[i - nrow].z);
+		psi[i].zy = cy.b * psi[i].zy + cy.a * rdy * (B[i].x - B[i - nrow].x);
+
+		E[i].x += dt * psi[i].xy;
+		E[i].y -= dt * psi[i].yx;
+		E[i].z += dt * (psi[i].zx - psi[i].zy);
+	}
+}
+
+// Convolutional PML (stretched coordinates with kappa = 1 and alpha = 0): the derivatives
+// of yee_b / yee_e inside the layers are corrected with the convolution terms. Only the cells
+// inside the layers are visited (same range as the Yee solver)
+static void pml_b(t_emf *emf, const float dt)
+{
+	const t_pml *const pml = emf->pml;
+
+	for (int j = -1; j <= emf->nx[1]; j++)
+	{
+		if (pml_row(pml, j)) pml_b_row(emf, j, -1, emf->nx[0] + 1, dt);
+		else
+		{
+			pml_b_row(emf, j, -1, pml->x_lower_end, dt);
+			pml_b_row(emf, j, pml->x_upper_begin, emf->nx[0] + 1, dt);
+		}
+	}
+}
+
+static void pml_e(t_emf *emf, const float dt)
+{
+	const t_pml *const pml = emf->pml;
+
+	for (int j = 0; j <= emf->nx[1] + 1; j++)
+	{
+		if (pml_row(pml, j)) pml_e_row(emf, j, 0, emf->nx[0] + 2, dt);
+		else
+		{
+			pml_e_row(emf, j, 0, pml->x_lower_end, dt);
+			pml_e_row(emf, j, pml->x_upper_begin, emf->nx[0] + 2, dt);
+		}
+	}
+}
+
 // Update the ghost cells in the X direction
 void emf_update_gc_x(t_emf *emf)
 {
@@ -492,8 +908,28 @@ void emf_update_gc_x(t_emf *emf)
 	t_vfld *const restrict E = emf->E;
 	t_vfld *const restrict B = emf->B;
 
+	// Absorbing boundaries: the fields outside the box are zero
+	if (emf->absorbing[0][0] || emf->absorbing[0][1])
+	{
+		const t_vfld zero_fld = { 0., 0., 0. };
+
+		for (j = -emf->gc[1][0]; j < emf->nx[1] + emf->gc[1][1]; j++)
+		{
+			if (emf->absorbing[0][0]) for (i = -emf->gc[0][0]; i < 0; i++)
+			{
+				E[i + j * nrow] = zero_fld;
+				B[i + j * nrow] = zero_fld;
+			}
+
+			if (emf->absorbing[0][1]) for (i = 0; i < emf->gc[0][1]; i++)
+			{
+				E[emf->nx[0] + i + j * nrow] = zero_fld;
+				B[emf->nx[0] + i + j * nrow] = zero_fld;
+			}
+		}
+
 	// For moving window don't update x boundaries
-	if (!emf->moving_window)
+	} else if (!emf->moving_window)
 	{
 		// x
 		for (j = -emf->gc[1][0]; j < emf->nx[1] + emf->gc[1][1]; j++)
@@ -524,13 +960,35 @@ void emf_update_gc_x(t_emf *emf)
 			}
 
 		}
+
+		// Convolution terms of the y layers
+		if (emf->pml)
+		{
+			t_pml_psi *const restrict psi_E = emf->pml->psi_E;
+			t_pml_psi *const restrict psi_B = emf->pml->psi_B;
+
+			for (j = -emf->gc[1][0]; j < emf->nx[1] + emf->gc[1][1]; j++)
+			{
+				for (i = -emf->gc[0][0]; i < 0; i++)
+				{
+					psi_E[i + j * nrow] = psi_E[emf->nx[0] + i + j * nrow];
+					psi_B[i + j * nrow] = psi_B[emf->nx[0] + i + j * nrow];
+				}
+
+				for (i = 0; i < emf->gc[0][1]; i++)
+				{
+					psi_E[emf->nx[0] + i + j * nrow] = psi_E[i + j * nrow];
+					psi_B[emf->nx[0] + i + j * nrow] = psi_B[i + j * nrow];
+				}
+			}
+		}
 	}
 }
 
-// Update ghost cells in the below overlap zone (Y direction)
-void emf_update_gc_y(t_emf *emf)
+// Exchange the ghost cells with the region below (Y direction). In the first region, the
+// lower edge may be an absorbing boundary: the fields outside the box are set to zero
+static void emf_exchange_gc_y(t_emf *emf)
 {
-//	uint64_t t0 = timer_ticks();
 	int i, j;
 	const int nrow = emf->nrow;
 
@@ -539,6 +997,29 @@ void emf_update_gc_y(t_emf *emf)
 	t_vfld *const restrict E_overlap = emf->E_below;
 	t_vfld *const restrict B_overlap = emf->B_below;
 
+	if (emf->absorbing[1][0])
+	{
+		const t_vfld zero_fld = { 0., 0., 0. };
+
+		// Lower guard cells of this region and upper guard cells of the last region
+		for (i = -emf->gc[0][0]; i < emf->nx[0] + emf->gc[0][1]; i++)
+		{
+			for (j = -emf->gc[1][0]; j < 0; j++)
+			{
+				B[i + j * nrow] = zero_fld;
+				E[i + j * nrow] = zero_fld;
+			}
+
+			for (j = 0; j < emf->gc[1][1]; j++)
+			{
+				B_overlap[i + (j + emf->gc[1][0]) * nrow] = zero_fld;
+				E_overlap[i + (j + emf->gc[1][0]) * nrow] = zero_fld;
+			}
+		}
+
+		return;
+	}
+
 	// y
 	for (i = -emf->gc[0][0]; i < emf->nx[0] + emf->gc[0][1]; i++)
 	{
@@ -555,37 +1036,50 @@ void emf_update_gc_y(t_emf *emf)
 		}
 	}
 
-	// Cannot be used with the PGI compiler
-	//#pragma oss atomic
-	//_emf_time += timer_interval_seconds(t0, timer_ticks());
+	// Convolution terms of the PML (the E/B dependencies also cover them)
+	if (emf->pml && emf->pml->psi_E_below)
+	{
+		t_pml_psi *const restrict psi_E = emf->pml->psi_E;
+		t_pml_psi *const restrict psi_B = emf->pml->psi_B;
+		t_pml_psi *const restrict psi_E_overlap = emf->pml->psi_E_below;
+		t_pml_psi *const restrict psi_B_overlap = emf->pml->psi_B_below;
+
+		for (i = -emf->gc[0][0]; i < emf->nx[0] + emf->gc[0][1]; i++)
+		{
+			for (j = -emf->gc[1][0]; j < 0; j++)
+			{
+				psi_B[i + j * nrow] = psi_B_overlap[i + (j + emf->gc[1][0]) * nrow];
+				psi_E[i + j * nrow] = psi_E_overlap[i + (j + emf->gc[1][0]) * nrow];
+			}
+
+			for (j = 0; j < emf->gc[1][1]; j++)
+			{
+				psi_B_overlap[i + (j + emf->gc[1][0]) * nrow] = psi_B[i + j * nrow];
+				psi_E_overlap[i + (j + emf->gc[1][0]) * nrow] = psi_E[i + j * nrow];
+			}
+		}
+	}
 }
 
-void emf_update_gc_y_serial(t_emf *emf)
+// Update ghost cells in the below overlap zone (Y direction)
+void emf_update_gc_y(t_emf *emf)
 {
-//	uint64_t t0 = timer_ticks();
-	int i, j;
-	const int nrow = emf->nrow;
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
 
-	t_vfld *const restrict E = emf->E;
-	t_vfld *const restrict B = emf->B;
-	t_vfld *const restrict E_overlap = emf->E_below;
-	t_vfld *const restrict B_overlap = emf->B_below;
+	emf_exchange_gc_y(emf);
 
-	// y
-	for (i = -emf->gc[0][0]; i < emf->nx[0] + emf->gc[0][1]; i++)
-	{
-		for (j = -emf->gc[1][0]; j < 0; j++)
-		{
-			B[i + j * nrow] = B_overlap[i + (j + emf->gc[1][0]) * nrow];
-			E[i + j * nrow] = E_overlap[i + (j + emf->gc[1][0]) * nrow];
-		}
+	TASK_TRACE_END(TRACE_EMF_UPDATE_GC, emf->region_id, emf->iter - 1,
+			8 * emf->overlap * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_EXCHANGE, emf->region_id, emf->iter - 1);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
+}
 
-		for (j = 0; j < emf->gc[1][1]; j++)
-		{
-			B_overlap[i + (j + emf->gc[1][0]) * nrow] = B[i + j * nrow];
-			E_overlap[i + (j + emf->gc[1][0]) * nrow] = E[i + j * nrow];
-		}
-	}
+void emf_update_gc_y_serial(t_emf *emf)
+{
+//	uint64_t t0 = timer_ticks();
+	emf_exchange_gc_y(emf);
 }
 
 // Move the simulation window
@@ -617,27 +1111,90 @@ void emf_move_window(t_emf *emf)
 			}
 		}
 
+		// The convolution terms of the y layers move with the fields
+		if (emf->pml)
+		{
+			t_pml_psi *const restrict psi_E = emf->pml->psi_E;
+			t_pml_psi *const restrict psi_B = emf->pml->psi_B;
+			const t_pml_psi zero_psi = { 0 };
+
+			for (j = 0; j < emf->nx[1]; j++)
+			{
+				for (i = -emf->gc[0][0]; i < emf->nx[0] - 1; i++)
+				{
+					psi_E[i + j * nrow] = psi_E[i + j * nrow + 1];
+					psi_B[i + j * nrow] = psi_B[i + j * nrow + 1];
+				}
+
+				for (i = emf->nx[0] - 1; i < emf->nx[0] + emf->gc[0][1]; i++)
+				{
+					psi_E[i + j * nrow] = zero_psi;
+					psi_B[i + j * nrow] = zero_psi;
+				}
+			}
+		}
+
 		// Increase moving window counter
 		emf->n_move++;
 	}
 }
 
 // Perform the local integration of the fields (and post processing)
-void emf_advance(t_emf *emf, const t_current *current)
+void emf_advance(t_emf *emf, t_current *current, const bool clear_current)
 {
+	uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
 	const float dt = emf->dt;
+	const float t = emf->iter * dt;
 
 	// Advance EM field using Yee algorithm modified for having E and B time centered
-	yee_b(emf, dt / 2.0f);
-	yee_e(emf, current, dt);
-	yee_b(emf, dt / 2.0f);
+	if (emf->pml)
+	{
+		yee_b(emf, dt / 2.0f);
+		pml_b(emf, dt / 2.0f);
+		antenna_b(emf, t, dt / 2.0f);
+		if (clear_current) yee_e_consume(emf, current, dt);
+		else yee_e(emf, current, dt);
+		pml_e(emf, dt);
+		antenna_e(emf, t + dt / 2.0f, dt);
+		yee_b(emf, dt / 2.0f);
+		pml_b(emf, dt / 2.0f);
+		antenna_b(emf, t + dt, dt / 2.0f);
+	} else
+	{
+		yee_b(emf, dt / 2.0f);
+		antenna_b(emf, t, dt / 2.0f);
+		if (clear_current) yee_e_consume(emf, current, dt);
+		else yee_e(emf, current, dt);
+		antenna_e(emf, t + dt / 2.0f, dt);
+		yee_b(emf, dt / 2.0f);
+		antenna_b(emf, t + dt, dt / 2.0f);
+	}
+
+	timer_phase_add(TIMER_SOLVE, t0);
 
+	t0 = timer_ticks();
 	emf_update_gc_x(emf);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 
 	// Advance internal iteration number
 	emf->iter += 1;
 
+	// The current is no longer used in this time step
+	current->iter++;
+
 	// Move simulation window if needed
-	if (emf->moving_window) emf_move_window(emf);
+	if (emf->moving_window)
+	{
+		t0 = timer_ticks();
+		emf_move_window(emf);
+		timer_phase_add(TIMER_SOLVE, t0);
+	}
+
+	TASK_TRACE_END(TRACE_EMF_ADVANCE, emf->region_id, emf->iter - 1,
+			5 * emf->total_size * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_EMF_ADVANCE, emf->region_id, emf->iter - 1);
 }
 
@@ -15,11 +15,91 @@
 #include "zpic.h"
 
 #include "current.h"
+#include "task_priority.h"
+
+// Maximum frequency shift of the PML (complex frequency shifted PML), normalized to the plasma
+// frequency. It avoids the late time growth of the static fields inside the layers
+#define PML_ALPHA_MAX 0.2f
 
 enum emf_diag {
 	EFLD, BFLD
 };
 
+enum boundary_type {
+	BOUNDARY_PERIODIC, BOUNDARY_PML
+};
+
+// Boundary conditions of the simulation box, for each edge ([x/y][lower/upper]). Periodic
+// boundaries must be set in both edges of the same direction. The fields are absorbed by a
+// perfectly matched layer (PML) inside the box and the particles crossing a PML edge are removed
+typedef struct {
+	enum boundary_type type[2][2];
+	int pml_size;			// Thickness of the PML, in cells (defaults to 16)
+	float pml_reflection;	// Theoretical reflection at normal incidence (defaults to 1e-6)
+} t_boundary;
+
+// Convolution terms of the PML, for each field component and derivative direction
+// (e.g. zx = d/dx term of the z component)
+typedef struct {
+	t_fld xy, yx, zx, zy;
+} t_pml_psi;
+
+// Update of the convolution terms: psi = b * psi + a * derivative
+typedef struct {
+	t_fld b, a;
+} t_pml_coef;
+
+typedef struct {
+
+	// Cells of the x layers in this region: [-gc, x_lower_end) and [x_upper_begin, nx + gc).
+	// The y layers cover entire rows
+	int x_lower_end, x_upper_begin;
+
+	// Coefficients in the E and B positions along x and y (a = 0 outside the layers). B uses
+	// dt / 2, since it is advanced in two half steps
+	t_pml_coef *coef_E[2], *coef_B[2];
+	t_pml_coef *coef_buf;
+
+	// Convolution terms (same layout as the E/B buffers)
+	t_pml_psi *psi_E_buf, *psi_B_buf;
+	t_pml_psi *psi_E, *psi_B;
+
+	// Pointer to the overlap zone in the region below (NULL if it has no PML)
+	t_pml_psi *psi_E_below, *psi_B_below;
+
+} t_pml;
+
+enum emf_laser_type {
+	PLANE, GAUSSIAN
+};
+
+typedef struct {
+
+	enum emf_laser_type type;		// Laser pulse type
+
+	float start;	// Front edge of the laser pulse, in simulation units
+	float fwhm;		// FWHM of the laser pulse duration, in simulation units
+	float rise, flat, fall;    // Rise, flat and fall time of the laser pulse, in simulation units
+
+	float a0;		// Normalized peak vector potential of the pulse
+	float omega0;    // Laser frequency, normalized to the plasma frequency
+
+	float polarization;
+
+	float W0;		// Gaussian beam waist, in simulation units
+	float focus;	// Focal plane position, in simulation units
+	float axis;     // Position of optical axis, in simulation units
+
+} t_emf_laser;
+
+// Laser antenna: emits the laser pulse (defined as in emf_add_laser) through the plane of
+// constant x (fixed in the lab frame). The pulse crosses the plane when x > start - t
+typedef struct {
+	t_emf_laser laser;
+	float x;		// Position of the antenna, in simulation units
+	int offset_y;	// First row of the region (global)
+} t_emf_antenna;
+
 typedef struct {
 
 	t_vfld *E;
@@ -48,41 +128,40 @@ typedef struct {
 	bool moving_window;
 	int n_move;
 
+	// Region that owns the fields
+	int region_id;
+
 	// Pointer to the overlap zone (in the E/B buffer) in the region above
 	t_vfld *B_below, *E_below;
 
-} t_emf;
-
-enum emf_laser_type {
-	PLANE, GAUSSIAN
-};
+	// Edges of the region that are absorbing boundaries of the simulation box ([x/y][lower/upper])
+	bool absorbing[2][2];
 
-typedef struct {
+	// Perfectly matched layers (NULL if the region has no PML cells)
+	t_pml *pml;
 
-	enum emf_laser_type type;		// Laser pulse type
+	// Laser antennas
+	int n_antennas;
+	t_emf_antenna *antennas;
 
-	float start;	// Front edge of the laser pulse, in simulation units
-	float fwhm;		// FWHM of the laser pulse duration, in simulation units
-	float rise, flat, fall;    // Rise, flat and fall time of the laser pulse, in simulation units
-
-	float a0;		// Normalized peak vector potential of the pulse
-	float omega0;    // Laser frequency, normalized to the plasma frequency
-
-	float polarization;
-
-	float W0;		// Gaussian beam waist, in simulation units
-	float focus;	// Focal plane position, in simulation units
-	float axis;     // Position of optical axis, in simulation units
-
-} t_emf_laser;
+} t_emf;
 
 // Setup
 void emf_new(t_emf *emf, int nx[], t_fld box[], const float dt);
 void emf_delete(t_emf *emf);
 void emf_overlap_zone(t_emf *emf, t_emf *upper);
+void emf_set_boundaries(t_emf *emf, const t_boundary *boundary, const int offset_y,
+		const int global_ny);
+void emf_laser_validate(t_emf_laser *laser);
 void emf_add_laser(t_emf *const emf, t_emf_laser *laser, int offset_y);
+void emf_add_laser_boosted(t_emf *const emf, t_emf_laser *laser, int offset_y, const float gamma,
+		const float origin);
+void emf_add_antenna(t_emf *const emf, t_emf_laser *laser, const float x, const int offset_y);
 void div_corr_x(t_emf *emf);
 
+// Longitudinal envelope of the laser pulse (also used by the laser envelope model)
+t_fld lon_env(const t_emf_laser *const laser, const t_fld z);
+
 // General Report
 double emf_time(void);
 double emf_get_energy(t_emf *emf);
@@ -93,18 +172,22 @@ void emf_reconstruct_global_buffer(const t_emf *emf, float *global_buffer, const
 void emf_report(const float *restrict global_buffer, const float box[2], const int true_nx[2],
 		const int iter, const float dt, const char field, const char fc, const char path[128]);
 
+// Field solver (also used by the fine grid of the mesh refinement)
+void yee_b(t_emf *emf, const float dt);
+void yee_e(t_emf *emf, const t_current *current, const float dt);
+
 // CPU Tasks
-#pragma oss task in(current->J_buf[0; current->total_size]) \
+#pragma oss task inout(current->J_buf[0; current->total_size]) \
 inout(emf->E_buf[0; emf->total_size]) \
 inout(emf->B_buf[0; emf->total_size]) \
-label("EMF Advance")
-void emf_advance(t_emf *emf, const t_current *current);
+label("EMF Advance") priority(task_priority[TRACE_EMF_ADVANCE])
+void emf_advance(t_emf *emf, t_current *current, const bool clear_current);
 
 #pragma oss task inout(emf->B_buf[0; emf->overlap]) \
 inout(emf->B_below[-emf->gc[0][0]; emf->overlap]) \
 inout(emf->E_buf[0; emf->overlap]) \
 inout(emf->E_below[-emf->gc[0][0]; emf->overlap]) \
-label("EMF Update GC")
+label("EMF Update GC") priority(task_priority[TRACE_EMF_UPDATE_GC])
 void emf_update_gc_y(t_emf *emf); // Each region is update the ghost cells in the top edge
 
 void emf_update_gc_y_serial(t_emf *emf);
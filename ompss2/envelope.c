@@ -0,0 +1,464 @@
+/*********************************************************************************************
+ ZPIC
+ envelope.c
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#include "envelope.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "zdf.h"
+#include "timer.h"
+#include "perf_counters.h"
+#include "task_trace.h"
+
+/*********************************************************************************************
+ Constructor / Destructor
+ *********************************************************************************************/
+void envelope_new(t_envelope *env, const int nx[2], const t_fld box[2], const float dt,
+		const float k0)
+{
+	// Number of guard cells for linear interpolation (the gradient of |A|^2 needs one more
+	// node in each direction, see envelope_interpolate)
+	const int gc[2][2] = { { 1, 2 }, { 1, 2 } };
+
+	for (int i = 0; i < 2; i++)
+	{
+		env->nx[i] = nx[i];
+		env->gc[i][0] = gc[i][0];
+		env->gc[i][1] = gc[i][1];
+		env->box[i] = box[i];
+		env->dx[i] = box[i] / nx[i];
+	}
+	env->nrow = gc[0][0] + nx[0] + gc[0][1];
+	env->total_size = env->nrow * (gc[1][0] + nx[1] + gc[1][1]);
+	env->overlap = env->nrow * (gc[1][0] + gc[1][1]);
+
+	env->A_buf = calloc(env->total_size, sizeof(t_cfld));
+	env->A_old_buf = calloc(env->total_size, sizeof(t_cfld));
+	env->a2_buf = calloc(env->total_size, sizeof(t_fld));
+	env->chi_buf = calloc(env->total_size, sizeof(t_fld));
+	env->row_buf = malloc(2 * env->nrow * sizeof(t_cfld));
+	assert(env->A_buf && env->A_old_buf && env->a2_buf && env->chi_buf && env->row_buf);
+
+	// Make the buffers point to cell [0][0]
+	const int offset = gc[0][0] + gc[1][0] * env->nrow;
+	env->A = env->A_buf + offset;
+	env->A_old = env->A_old_buf + offset;
+	env->a2 = env->a2_buf + offset;
+	env->chi = env->chi_buf + offset;
+
+	env->k0 = k0;
+	env->dt = dt;
+	env->iter = 0;
+
+	env->moving_window = false;
+	env->n_move = 0;
+
+	for (int i = 0; i < 2; i++)
+		env->absorbing[i][0] = env->absorbing[i][1] = false;
+
+	env->region_id = 0;
+}
+
+void envelope_delete(t_envelope *env)
+{
+	free(env->A_buf);
+	free(env->A_old_buf);
+	free(env->a2_buf);
+	free(env->chi_buf);
+	free(env->row_buf);
+
+	env->A_buf = NULL;
+	env->A_old_buf = NULL;
+	env->a2_buf = NULL;
+	env->chi_buf = NULL;
+	env->row_buf = NULL;
+}
+
+// Set the overlap zone between regions (below zone only)
+void envelope_overlap_zone(t_envelope *env, t_envelope *below)
+{
+	const int offset = (below->nx[1] - below->gc[1][0]) * below->nrow;
+
+	env->A_below = below->A + offset;
+	env->a2_below = below->a2 + offset;
+	env->chi_below = below->chi + offset;
+}
+
+/*********************************************************************************************
+ Guard cells
+ *********************************************************************************************/
+
+// Update the guard cells of A in the x direction (periodic or zero outside the box). With a
+// moving window, the guard cells are set by envelope_move_window
+static void envelope_update_gc_x(t_envelope *env)
+{
+	const int nrow = env->nrow;
+	t_cfld *const restrict A = env->A;
+
+	if (env->absorbing[0][0] || env->absorbing[0][1])
+	{
+		for (int j = -env->gc[1][0]; j < env->nx[1] + env->gc[1][1]; j++)
+		{
+			if (env->absorbing[0][0]) for (int i = -env->gc[0][0]; i < 0; i++)
+				A[i + j * nrow] = 0;
+
+			if (env->absorbing[0][1]) for (int i = 0; i < env->gc[0][1]; i++)
+				A[env->nx[0] + i + j * nrow] = 0;
+		}
+
+	} else if (!env->moving_window)
+	{
+		for (int j = -env->gc[1][0]; j < env->nx[1] + env->gc[1][1]; j++)
+		{
+			for (int i = -env->gc[0][0]; i < 0; i++)
+				A[i + j * nrow] = A[env->nx[0] + i + j * nrow];
+
+			for (int i = 0; i < env->gc[0][1]; i++)
+				A[env->nx[0] + i + j * nrow] = A[i + j * nrow];
+		}
+	}
+}
+
+// |A|^2 in the rows of the region (including the x guard cells)
+static void envelope_update_a2(t_envelope *env)
+{
+	const int nrow = env->nrow;
+	const t_cfld *const restrict A = env->A;
+	t_fld *const restrict a2 = env->a2;
+
+	for (int j = 0; j < env->nx[1]; j++)
+		for (int i = -env->gc[0][0]; i < env->nx[0] + env->gc[0][1]; i++)
+		{
+			const t_cfld a = A[i + j * nrow];
+			a2[i + j * nrow] = crealf(a) * crealf(a) + cimagf(a) * cimagf(a);
+		}
+}
+
+// Exchange the ghost cells of A and |A|^2 with the region below (Y direction). In the first
+// region, the lower edge may be an absorbing boundary: the envelope outside the box is zero
+static void envelope_exchange_gc_y(t_envelope *env)
+{
+	const int nrow = env->nrow;
+
+	t_cfld *const restrict A = env->A;
+	t_fld *const restrict a2 = env->a2;
+	t_cfld *const restrict A_overlap = env->A_below;
+	t_fld *const restrict a2_overlap = env->a2_below;
+
+	if (env->absorbing[1][0])
+	{
+		// Lower guard cells of this region and upper guard cells of the last region
+		for (int i = -env->gc[0][0]; i < env->nx[0] + env->gc[0][1]; i++)
+		{
+			for (int j = -env->gc[1][0]; j < 0; j++)
+			{
+				A[i + j * nrow] = 0;
+				a2[i + j * nrow] = 0;
+			}
+
+			for (int j = 0; j < env->gc[1][1]; j++)
+			{
+				A_overlap[i + (j + env->gc[1][0]) * nrow] = 0;
+				a2_overlap[i + (j + env->gc[1][0]) * nrow] = 0;
+			}
+		}
+
+		return;
+	}
+
+	for (int i = -env->gc[0][0]; i < env->nx[0] + env->gc[0][1]; i++)
+	{
+		for (int j = -env->gc[1][0]; j < 0; j++)
+		{
+			A[i + j * nrow] = A_overlap[i + (j + env->gc[1][0]) * nrow];
+			a2[i + j * nrow] = a2_overlap[i + (j + env->gc[1][0]) * nrow];
+		}
+
+		for (int j = 0; j < env->gc[1][1]; j++)
+		{
+			A_overlap[i + (j + env->gc[1][0]) * nrow] = A[i + j * nrow];
+			a2_overlap[i + (j + env->gc[1][0]) * nrow] = a2[i + j * nrow];
+		}
+	}
+}
+
+// Update ghost cells in the below overlap zone (Y direction)
+void envelope_update_gc_y(t_envelope *env)
+{
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
+	envelope_exchange_gc_y(env);
+
+	TASK_TRACE_END(TRACE_ENVELOPE_UPDATE_GC, env->region_id, env->iter - 1,
+			4 * env->overlap * (sizeof(t_cfld) + sizeof(t_fld)));
+	PERF_COUNTERS_END(PERF_EXCHANGE, env->region_id, env->iter - 1);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
+}
+
+void envelope_update_gc_y_serial(t_envelope *env)
+{
+	envelope_exchange_gc_y(env);
+}
+
+// Each region is only responsible to do the reduction operation of the susceptibility in its
+// bottom edge
+void envelope_reduction_y(t_envelope *env)
+{
+	if (env->absorbing[1][0]) return;
+
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
+	const int nrow = env->nrow;
+	t_fld *restrict const chi = env->chi;
+	t_fld *restrict const chi_overlap = env->chi_below;
+
+	for (int j = -env->gc[1][0]; j < env->gc[1][1]; j++)
+	{
+		for (int i = -env->gc[0][0]; i < env->nx[0] + env->gc[0][1]; i++)
+		{
+			chi[i + j * nrow] += chi_overlap[i + (j + env->gc[1][0]) * nrow];
+			chi_overlap[i + (j + env->gc[1][0]) * nrow] = chi[i + j * nrow];
+		}
+	}
+
+	TASK_TRACE_END(TRACE_ENVELOPE_REDUCTION_Y, env->region_id, env->iter,
+			4 * env->overlap * sizeof(t_fld));
+	PERF_COUNTERS_END(PERF_EXCHANGE, env->region_id, env->iter);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
+}
+
+// Susceptibility reduction between ghost cells in the x direction (periodic boundaries only)
+static void envelope_reduction_x(t_envelope *env)
+{
+	if (env->moving_window || env->absorbing[0][0] || env->absorbing[0][1]) return;
+
+	const int nrow = env->nrow;
+	t_fld *restrict const chi = env->chi;
+	t_fld *restrict const chi_overlap = &env->chi[env->nx[0]];
+
+	for (int j = -env->gc[1][0]; j < env->nx[1] + env->gc[1][1]; j++)
+	{
+		for (int i = -env->gc[0][0]; i < env->gc[0][1]; i++)
+		{
+			chi[i + j * nrow] += chi_overlap[i + j * nrow];
+			chi_overlap[i + j * nrow] = chi[i + j * nrow];
+		}
+	}
+}
+
+/*********************************************************************************************
+ Laser Pulses
+ *********************************************************************************************/
+
+// Complex transverse profile of the gaussian beam at the position z (the same beam as
+// gauss_phase, emf.c, without the carrier)
+static t_cfld gauss_profile(const t_emf_laser *const laser, const t_fld z, const t_fld r)
+{
+	t_fld z0 = laser->omega0 * (laser->W0 * laser->W0) / 2;
+	t_fld rho2 = r * r;
+	t_fld curv = rho2 * z / (z0 * z0 + z * z);
+	t_fld rWl2 = (z0 * z0) / (z0 * z0 + z * z);
+	t_fld gouy_shift = atan2(z, z0);
+
+	return sqrtf(sqrtf(rWl2)) * expf(-rho2 * rWl2 / (laser->W0 * laser->W0))
+			* cexpf(I * (laser->omega0 * curv - gouy_shift));
+}
+
+// Add a laser pulse to the envelope at t = 0 and t = -dt (the laser frequency must be the
+// wavenumber of the envelope). The polarization is ignored (linear polarization)
+void envelope_add_laser(t_envelope *env, t_emf_laser *laser, const int offset_y)
+{
+	emf_laser_validate(laser);
+
+	const int nrow = env->nrow;
+	const t_fld dx = env->dx[0];
+	const t_fld dy = env->dx[1];
+
+	t_cfld *restrict A = env->A;
+	t_cfld *restrict A_old = env->A_old;
+
+	for (int j = 0; j < env->nx[1]; j++)
+	{
+		const t_fld r = (j + offset_y) * dy - laser->axis;
+
+		for (int i = 0; i < env->nx[0]; i++)
+		{
+			const t_fld z = i * dx;
+			const t_cfld profile = laser->type == GAUSSIAN ? gauss_profile(laser, z, r) : 1.0f;
+
+			A[i + j * nrow] += laser->a0 * lon_env(laser, z) * profile;
+			A_old[i + j * nrow] += laser->a0 * lon_env(laser, z + env->dt) * profile;
+		}
+	}
+
+	envelope_update_gc_x(env);
+	envelope_update_a2(env);
+}
+
+/*********************************************************************************************
+ Envelope solver
+ *********************************************************************************************/
+
+// Advance the envelope with the explicit scheme (centered differences in space and time)
+//   (1 - i k0 dt) A+ = dt^2 (laplacian(A) + 2 i k0 dA/dx - chi A) + 2 A - (1 + i k0 dt) A-
+// which is stable for the Courant condition of the field solver. The rows are updated in place
+// (A- is replaced by A), using a copy of the previous and the current rows of A
+static void envelope_solve(t_envelope *env)
+{
+	const int nrow = env->nrow;
+	const int gc = env->gc[0][0];
+	const float dt = env->dt;
+	const float k0 = env->k0;
+
+	const t_fld dt2_dx2 = (dt * dt) / (env->dx[0] * env->dx[0]);
+	const t_fld dt2_dy2 = (dt * dt) / (env->dx[1] * env->dx[1]);
+	const t_fld dt2 = dt * dt;
+	const t_cfld c_dx = I * k0 * dt * dt / env->dx[0];
+	const t_cfld c_old = 1.0f + I * k0 * dt;
+	const t_cfld c_new = 1.0f / (1.0f - I * k0 * dt);
+
+	t_cfld *restrict A = env->A;
+	t_cfld *restrict A_old = env->A_old;
+	const t_fld *restrict chi = env->chi;
+
+	t_cfld *restrict prev = env->row_buf;
+	t_cfld *restrict row = env->row_buf + nrow;
+	memcpy(prev, A - nrow - gc, nrow * sizeof(t_cfld));
+
+	for (int j = 0; j < env->nx[1]; j++)
+	{
+		memcpy(row, A + j * nrow - gc, nrow * sizeof(t_cfld));
+
+		const t_cfld *restrict r = row + gc;
+		const t_cfld *restrict down = prev + gc;
+		const t_cfld *restrict up = A + (j + 1) * nrow;
+
+		for (int i = 0; i < env->nx[0]; i++)
+		{
+			const t_cfld lap = dt2_dx2 * (r[i + 1] - 2.0f * r[i] + r[i - 1])
+					+ dt2_dy2 * (up[i] - 2.0f * r[i] + down[i]);
+
+			A[i + j * nrow] = c_new * (lap + c_dx * (r[i + 1] - r[i - 1])
+					- dt2 * chi[i + j * nrow] * r[i] + 2.0f * r[i] - c_old * A_old[i + j * nrow]);
+			A_old[i + j * nrow] = r[i];
+		}
+
+		t_cfld *tmp = prev;
+		prev = row;
+		row = tmp;
+	}
+}
+
+// Move the simulation window
+static void envelope_move_window(t_envelope *env)
+{
+	if ((env->iter * env->dt) > env->dx[0] * (env->n_move + 1))
+	{
+		const int nrow = env->nrow;
+		t_cfld *const restrict A = env->A;
+		t_cfld *const restrict A_old = env->A_old;
+
+		// Shift data left 1 cell and zero rightmost cells
+		for (int j = 0; j < env->nx[1]; j++)
+		{
+			for (int i = -env->gc[0][0]; i < env->nx[0] - 1; i++)
+			{
+				A[i + j * nrow] = A[i + j * nrow + 1];
+				A_old[i + j * nrow] = A_old[i + j * nrow + 1];
+			}
+
+			for (int i = env->nx[0] - 1; i < env->nx[0] + env->gc[0][1]; i++)
+			{
+				A[i + j * nrow] = 0;
+				A_old[i + j * nrow] = 0;
+			}
+		}
+
+		// Increase moving window counter
+		env->n_move++;
+	}
+}
+
+// Advance the envelope with the susceptibility of the current time step (and clear it)
+void envelope_advance(t_envelope *env)
+{
+	uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
+	envelope_reduction_x(env);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
+
+	t0 = timer_ticks();
+	envelope_solve(env);
+	memset(env->chi_buf, 0, env->total_size * sizeof(t_fld));
+	timer_phase_add(TIMER_SOLVE, t0);
+
+	t0 = timer_ticks();
+	envelope_update_gc_x(env);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
+
+	// Advance internal iteration number
+	env->iter += 1;
+
+	t0 = timer_ticks();
+	if (env->moving_window) envelope_move_window(env);
+	envelope_update_a2(env);
+	timer_phase_add(TIMER_SOLVE, t0);
+
+	TASK_TRACE_END(TRACE_ENVELOPE_ADVANCE, env->region_id, env->iter - 1,
+			4 * env->total_size * (sizeof(t_cfld) + sizeof(t_fld)));
+	PERF_COUNTERS_END(PERF_ENVELOPE_ADVANCE, env->region_id, env->iter - 1);
+}
+
+/*********************************************************************************************
+ Diagnostics
+ *********************************************************************************************/
+
+// Reconstruct |A| in the simulation grid from all regions
+void envelope_reconstruct_global_buffer(const t_envelope *env, float *global_buffer,
+		const int offset)
+{
+	const t_cfld *restrict A = env->A;
+	float *restrict p = global_buffer + offset * env->nx[0];
+
+	for (int j = 0; j < env->nx[1]; j++)
+	{
+		for (int i = 0; i < env->nx[0]; i++)
+			p[i] = cabsf(A[i]);
+
+		p += env->nx[0];
+		A += env->nrow;
+	}
+}
+
+// Save the reconstructed buffer in a ZDF file
+void envelope_report(const float *restrict global_buffer, const float box[2], const int true_nx[2],
+		const int iter, const float dt, const char path[128])
+{
+	t_zdf_grid_axis axis[2];
+	axis[0] = (t_zdf_grid_axis ) { .min = 0.0, .max = box[0], .label = "x_1", .units = "c/\\omega_p" };
+	axis[1] = (t_zdf_grid_axis ) { .min = 0.0, .max = box[1], .label = "x_2", .units = "c/\\omega_p" };
+
+	t_zdf_grid_info info = { .ndims = 2, .label = "a", .units = "m_e c e^{-1}", .axis = axis };
+
+	info.nx[0] = true_nx[0];
+	info.nx[1] = true_nx[1];
+
+	t_zdf_iteration iteration = { .n = iter, .t = iter * dt, .time_units = "1/\\omega_p" };
+
+	zdf_save_grid(global_buffer, &info, &iteration, path);
+}
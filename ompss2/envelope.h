@@ -0,0 +1,159 @@
+/*********************************************************************************************
+ ZPIC
+ envelope.h
+
+ Laser envelope model: the laser is described by the complex envelope A of its vector potential,
+ a = Re[A exp(i k0 (x - t))], so the grid only has to resolve the envelope and the plasma
+ wavelength (not the laser wavelength). The envelope follows the (non-paraxial) equation
+
+   laplacian(A) + 2 i k0 (dA/dx + dA/dt) - d2A/dt2 = chi A
+
+ where chi = sum (q^2 / m) n / gamma is the susceptibility of the plasma, deposited by the
+ particles. The particles feel the ponderomotive force of the laser, - (q/m)^2 grad(|A|^2) /
+ (4 gamma), where gamma = sqrt(1 + u^2 + (q/m)^2 |A|^2 / 2) includes the quiver motion. The
+ fields of the plasma (e.g., the wake) are still solved by the Yee solver.
+
+ The envelope is stored in the nodes of the grid (the same positions as the charge density) and
+ it is split in regions like the fields.
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __ENVELOPE__
+#define __ENVELOPE__
+
+#include <stdbool.h>
+#include <complex.h>
+
+#include "zpic.h"
+#include "emf.h"
+#include "task_priority.h"
+
+typedef float complex t_cfld;
+
+typedef struct {
+
+	// Envelope at t_n and t_n-1, |A|^2 at t_n and the susceptibility (deposited at t_n)
+	t_cfld *A, *A_old;
+	t_fld *a2, *chi;
+
+	t_cfld *A_buf, *A_old_buf;
+	t_fld *a2_buf, *chi_buf;
+
+	// Copy of the rows j - 1 and j of A (the envelope is updated in place)
+	t_cfld *row_buf;
+
+	// Laser wavenumber (laser frequency), normalized to the plasma frequency
+	float k0;
+
+	// Simulation box info
+	int nx[2];
+	int nrow;
+	int gc[2][2];
+	t_fld box[2];
+	t_fld dx[2];
+
+	int total_size; // Total size of the buffers
+	int overlap; // Size of the overlap
+
+	// Time step
+	float dt;
+
+	// Iteration number
+	int iter;
+
+	// Moving window
+	bool moving_window;
+	int n_move;
+
+	// Edges of the region that are absorbing boundaries of the simulation box ([x/y][lower/upper]).
+	// The envelope is zero outside the box
+	bool absorbing[2][2];
+
+	// Region that owns the envelope
+	int region_id;
+
+	// Pointer to the overlap zone in the region below
+	t_cfld *A_below;
+	t_fld *a2_below, *chi_below;
+
+} t_envelope;
+
+// Setup
+void envelope_new(t_envelope *env, const int nx[2], const t_fld box[2], const float dt,
+		const float k0);
+void envelope_delete(t_envelope *env);
+void envelope_overlap_zone(t_envelope *env, t_envelope *below);
+void envelope_add_laser(t_envelope *env, t_emf_laser *laser, const int offset_y);
+void envelope_update_gc_y_serial(t_envelope *env);
+
+// ZDF Report (|A|)
+void envelope_reconstruct_global_buffer(const t_envelope *env, float *global_buffer,
+		const int offset);
+void envelope_report(const float *restrict global_buffer, const float box[2], const int true_nx[2],
+		const int iter, const float dt, const char path[128]);
+
+// CPU Tasks
+#pragma oss task inout(env->chi_buf[0; env->overlap]) \
+inout(env->chi_below[-env->gc[0][0]; env->overlap]) \
+label("Envelope Reduction Y") priority(task_priority[TRACE_ENVELOPE_REDUCTION_Y])
+void envelope_reduction_y(t_envelope *env); // Each region only update the zone in the top edge
+
+#pragma oss task inout(env->A_buf[0; env->total_size]) inout(env->A_old_buf[0; env->total_size]) \
+inout(env->a2_buf[0; env->total_size]) inout(env->chi_buf[0; env->total_size]) \
+label("Envelope Advance") priority(task_priority[TRACE_ENVELOPE_ADVANCE])
+void envelope_advance(t_envelope *env);
+
+#pragma oss task inout(env->A_buf[0; env->overlap]) \
+inout(env->A_below[-env->gc[0][0]; env->overlap]) \
+inout(env->a2_buf[0; env->overlap]) \
+inout(env->a2_below[-env->gc[0][0]; env->overlap]) \
+label("Envelope Update GC") priority(task_priority[TRACE_ENVELOPE_UPDATE_GC])
+void envelope_update_gc_y(t_envelope *env); // Each region is update the ghost cells in the top edge
+
+/*********************************************************************************************
+ Particles
+ *********************************************************************************************/
+
+// Interpolate |A|^2 and its gradient (centered differences in the nodes) at the particle position
+// (cell i, j of the region and position x, y inside the cell)
+static inline void envelope_interpolate(const t_envelope *restrict env, const int i, const int j,
+		const t_fld x, const t_fld y, t_fld *a2, t_fld *grad_x, t_fld *grad_y)
+{
+	const int nrow = env->nrow;
+	const t_fld *restrict p = env->a2 + i + j * nrow;
+	const t_fld wx[2] = { 1.0f - x, x };
+	const t_fld wy[2] = { 1.0f - y, y };
+
+	t_fld f = 0, gx = 0, gy = 0;
+	for (int b = 0; b < 2; b++)
+		for (int a = 0; a < 2; a++)
+		{
+			const t_fld *restrict node = p + a + b * nrow;
+			const t_fld w = wx[a] * wy[b];
+
+			f += w * node[0];
+			gx += w * (node[1] - node[-1]);
+			gy += w * (node[nrow] - node[-nrow]);
+		}
+
+	*a2 = f;
+	*grad_x = gx * 0.5f / env->dx[0];
+	*grad_y = gy * 0.5f / env->dx[1];
+}
+
+// Deposit the susceptibility of the particle (q^2 / (m gamma), in charge density units)
+static inline void envelope_deposit_chi(t_envelope *restrict env, const int i, const int j,
+		const t_fld x, const t_fld y, const t_fld chi)
+{
+	const int nrow = env->nrow;
+	t_fld *restrict p = env->chi + i + j * nrow;
+
+	p[0] += (1.0f - x) * (1.0f - y) * chi;
+	p[1] += x * (1.0f - y) * chi;
+	p[nrow] += (1.0f - x) * y * chi;
+	p[nrow + 1] += x * y * chi;
+}
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * ZPIC - em2d
+ *
+ * Laser Wakefield Acceleration (full PIC reference of the laser envelope deck)
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "../simulation.h"
+
+void sim_init(t_simulation *sim, int n_regions)
+{
+
+	// Time step
+	float dt = 0.0125;
+	float tmax = 20.001;
+
+	// Simulation box
+	int nx[2] = {1000, 128};
+	float box[2] = {20.0, 25.6};
+
+	// Diagnostic frequency
+	int ndump = 1600;
+
+	// Initialize particles
+	const int n_species = 1;
+
+	// Use 4x2 particles per cell
+	int ppc[] = {4, 2};
+
+	// Density profile
+	t_density density = {.type = STEP, .start = 20.0};
+
+	t_species *species = (t_species*) malloc(n_species * sizeof(t_species));
+	spec_new(&species[0], "electrons", -1.0, ppc, NULL, NULL, nx, box, dt, &density);
+
+	// Initialize Simulation data
+	sim_new(sim, nx, box, dt, tmax, ndump, species, n_species, "lwfa-1000-1M-1600-128", n_regions);
+
+	// Add laser pulse (this must come after sim_new)
+	t_emf_laser laser = {.type = GAUSSIAN, .start = 17.0, .fwhm = 2.0, .a0 = 1.5, .omega0 = 10.0, .W0 = 4.0,
+			.focus = 20.0, .axis = 12.8, .polarization = M_PI_2};
+	sim_add_laser(sim, &laser);
+
+	// Set moving window (this must come after sim_new)
+	sim_set_moving_window(sim);
+
+	// Set current smoothing (this must come after sim_new)
+	t_smooth smooth = {.xtype = COMPENSATED, .xlevel = 4};
+	sim_set_smooth(sim, &smooth);
+
+	free(species);
+}
+
+void sim_report(t_simulation *sim)
+{
+	sim_report_energy(sim);
+
+	// Longitudinal (wake) and transverse electric field
+	sim_report_grid_zdf(sim, REPORT_EFLD, 0);
+	sim_report_grid_zdf(sim, REPORT_EFLD, 1);
+
+	// Charge density
+	sim_report_spec_zdf(sim, 0, CHARGE, NULL, NULL);
+}
@@ -0,0 +1,72 @@
+/**
+ * ZPIC - em2d
+ *
+ * Laser Wakefield Acceleration in a Lorentz boosted frame (gamma = 3)
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "../simulation.h"
+
+void sim_init(t_simulation *sim, int n_regions)
+{
+
+	// Time step (boosted frame)
+	float dt = 0.08;
+	float tmax = 30.0;
+
+	// Simulation box (boosted frame)
+	int nx[2] = {512, 128};
+	float box[2] = {51.2, 25.6};
+
+	// Diagnostic frequency
+	int ndump = 125;
+
+	// Initialize particles (the ions neutralize the plasma that flows into the box)
+	const int n_species = 2;
+
+	// Use 2x2 particles per cell
+	int ppc[] = {2, 2};
+
+	// Density profile (lab frame)
+	t_density density = {.type = STEP, .start = 31.0};
+
+	t_species *species = (t_species*) malloc(n_species * sizeof(t_species));
+	spec_new(&species[0], "electrons", -1.0, ppc, NULL, NULL, nx, box, dt, &density);
+	spec_new(&species[1], "ions", +1836.0, ppc, NULL, NULL, nx, box, dt, &density);
+
+	// Initialize Simulation data
+	sim_new(sim, nx, box, dt, tmax, ndump, species, n_species, "lwfa-boost-512-512K-375-128",
+			n_regions);
+
+	// Absorbing boundaries along x (this must come after sim_new)
+	t_boundary boundary = {.type = {{BOUNDARY_PML, BOUNDARY_PML},
+			{BOUNDARY_PERIODIC, BOUNDARY_PERIODIC}}};
+	sim_set_boundaries(sim, &boundary);
+
+	// Boosted frame (after sim_set_boundaries and before sim_add_laser). The front of the laser is
+	// the origin, and the wake is saved in the lab frame at t = 30 (laser front at x = 60)
+	t_boost boost = {.gamma = 3.0, .origin = 30.0, .filter = {4, 0}, .n_snapshots = 1,
+			.t_snapshot = 30.0, .dt_snapshot = 0.0, .nx_lab = 480, .x_lab = {52.0, 61.6}};
+	sim_set_boost(sim, &boost);
+
+	// Add laser pulse (lab frame)
+	t_emf_laser laser = {.type = GAUSSIAN, .start = 30.0, .fwhm = 2.0, .a0 = 2.0, .omega0 = 10.0, .W0 = 4.0,
+			.focus = 31.0, .axis = 12.8, .polarization = M_PI_2};
+	sim_add_laser(sim, &laser);
+
+	free(species);
+}
+
+void sim_report(t_simulation *sim)
+{
+	sim_report_energy(sim);
+
+	// Longitudinal (wake) and laser electric field (boosted frame)
+	sim_report_grid_zdf(sim, REPORT_EFLD, 0);
+	sim_report_grid_zdf(sim, REPORT_EFLD, 2);
+
+	// Electron charge density
+	sim_report_spec_zdf(sim, 0, CHARGE, NULL, NULL);
+}
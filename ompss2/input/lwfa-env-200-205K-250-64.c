@@ -0,0 +1,70 @@
+/**
+ * ZPIC - em2d
+ *
+ * Laser Wakefield Acceleration with a laser envelope
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "../simulation.h"
+
+void sim_init(t_simulation *sim, int n_regions)
+{
+
+	// Time step
+	float dt = 0.08;
+	float tmax = 20.001;
+
+	// Simulation box
+	int nx[2] = {200, 64};
+	float box[2] = {20.0, 25.6};
+
+	// Diagnostic frequency
+	int ndump = 250;
+
+	// Initialize particles
+	const int n_species = 1;
+
+	// Use 4x4 particles per cell
+	int ppc[] = {4, 4};
+
+	// Density profile
+	t_density density = {.type = STEP, .start = 20.0};
+
+	t_species *species = (t_species*) malloc(n_species * sizeof(t_species));
+	spec_new(&species[0], "electrons", -1.0, ppc, NULL, NULL, nx, box, dt, &density);
+
+	// Initialize Simulation data
+	sim_new(sim, nx, box, dt, tmax, ndump, species, n_species, "lwfa-env-200-205K-250-64", n_regions);
+
+	// Add laser envelope (this must come after sim_new). The grid only resolves the pulse length,
+	// the spot and the plasma wavelength (5x/2x coarser than lwfa-1000-1M-1600-128)
+	t_emf_laser laser = {.type = GAUSSIAN, .start = 17.0, .fwhm = 2.0, .a0 = 1.5, .omega0 = 10.0, .W0 = 4.0,
+			.focus = 20.0, .axis = 12.8, .polarization = M_PI_2};
+	sim_add_laser_envelope(sim, &laser);
+
+	// Set moving window (this must come after sim_new)
+	sim_set_moving_window(sim);
+
+	// Set current smoothing (this must come after sim_new)
+	t_smooth smooth = {.xtype = COMPENSATED, .xlevel = 4};
+	sim_set_smooth(sim, &smooth);
+
+	free(species);
+}
+
+void sim_report(t_simulation *sim)
+{
+	sim_report_energy(sim);
+
+	// Longitudinal (wake) and transverse electric field
+	sim_report_grid_zdf(sim, REPORT_EFLD, 0);
+	sim_report_grid_zdf(sim, REPORT_EFLD, 1);
+
+	// Amplitude of the laser envelope
+	sim_report_grid_zdf(sim, REPORT_ENVELOPE, 0);
+
+	// Charge density
+	sim_report_spec_zdf(sim, 0, CHARGE, NULL, NULL);
+}
@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "zpic.h"
 #include "simulation.h"
@@ -29,23 +30,31 @@
 #include "current.h"
 #include "particles.h"
 #include "timer.h"
+#include "autotune.h"
+#include "perf_counters.h"
+#include "task_trace.h"
 
 // Simulation parameters (naming scheme : <type>-<number of particles>-<grid size x>-<grid size y>.c)
 // #include "input/lwfa-4000-16M-2000-512.c"
 //#include "input/lwfa-2000-4M-2000-256.c"
+#ifdef INPUT
+#include INPUT
+#else
 #include "input/weibel-500-4M-512-512.c"
+#endif
 
-int main(int argc, const char *argv[])
+static int run_simulation(int argc, const char *argv[])
 {
 	if(argc != 2)
 	{
-		fprintf(stderr, "Please specify the number of regions");
+		fprintf(stderr, "Please specify the number of regions (or \"auto\")");
 		exit(1);
 	}
 
 	// Initialize simulation
 	t_simulation sim;
-	sim_init(&sim, atoi(argv[1]));
+	if (!strcmp(argv[1], "auto")) autotune_regions(&sim);
+	else sim_init(&sim, atoi(argv[1]));
 
 	// Run simulation
 	int n;
@@ -66,13 +75,27 @@ int main(int argc, const char *argv[])
 		if (report(n, sim.ndump))
 		{
 			#pragma oss taskwait
+#ifdef ENABLE_OPENMP_TASKS
+			#pragma omp taskwait
+#endif
+			sim_merge_particles(&sim);
+
+			const uint64_t t_diag = timer_ticks();
+			PERF_COUNTERS_BEGIN();
+			TASK_TRACE_BEGIN();
 			sim_report(&sim);
+			TASK_TRACE_END(TRACE_DIAGNOSTICS, TRACE_GLOBAL, n, 0);
+			PERF_COUNTERS_END(PERF_DIAGNOSTICS, PERF_GLOBAL, n);
+			timer_phase_add(TIMER_DIAGNOSTICS, t_diag);
 		}
 #endif
 		sim_iter(&sim);
 	}
 
 	#pragma oss taskwait
+#ifdef ENABLE_OPENMP_TASKS
+	#pragma omp taskwait
+#endif
 
 	t1 = timer_ticks();
 
@@ -88,3 +111,18 @@ int main(int argc, const char *argv[])
 
 	return 0;
 }
+
+int main(int argc, const char *argv[])
+{
+#ifdef ENABLE_OPENMP_TASKS
+	// The OpenMP tasks are created by one thread of the parallel region (in OmpSs-2, the main
+	// function is already a task)
+	int ret;
+	#pragma omp parallel
+	#pragma omp single
+	ret = run_simulation(argc, argv);
+	return ret;
+#else
+	return run_simulation(argc, argv);
+#endif
+}
@@ -0,0 +1,282 @@
+/*********************************************************************************************
+ ZPIC
+ omp_tasks.h
+
+ OpenMP version of the OmpSs-2 tasks, for compilers without OmpSs-2 support (GCC, Clang). Each
+ task function is replaced by a wrapper that creates an OpenMP task with the same dependencies
+ and priority. Only included by the files that create the tasks, when compiled with
+ -DENABLE_OPENMP_TASKS (make openmp).
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __OMP_TASKS__
+#define __OMP_TASKS__
+
+#include <omp.h>
+
+#include "simulation.h"
+
+// Number of threads executing the tasks (the tasks are created inside the parallel region)
+#define nanos6_get_num_cpus() omp_get_num_threads()
+
+// The OpenMP runtimes match the dependencies by the address of the first element (the length
+// of the array sections is ignored), so each buffer is represented by the addresses of its parts:
+// the start of the buffer (the ghost cells shared with the region below), the start of the
+// ghost cells shared with the region above (equal to *_below[-gc[0][0]] in the region above) and,
+// for the fields and current of the regions, the start of the interior rows in between (see
+// spec_advance_interior). The tasks that touch the whole buffer depend on all of them
+#define BOTTOM(buf) (buf)[0]
+#define INTERIOR(buf, obj) (buf)[((obj)->gc[1][0] + (obj)->gc[1][1]) * (obj)->nrow]
+#define TOP(buf, obj) (buf)[(obj)->nx[1] * (obj)->nrow]
+#define BELOW(ptr, obj) (ptr)[-(obj)->gc[0][0]]
+
+/*********************************************************************************************
+ Current
+ *********************************************************************************************/
+
+static inline void omp_current_zero(t_current *current)
+{
+	#pragma omp task depend(out: BOTTOM(current->J_buf), INTERIOR(current->J_buf, current)) \
+		depend(out: TOP(current->J_buf, current)) \
+		priority(task_priority[TRACE_CURRENT_RESET])
+	current_zero(current);
+}
+
+static inline void omp_current_reduction_y(t_current *current)
+{
+	#pragma omp task depend(inout: BOTTOM(current->J_buf), BELOW(current->J_below, current)) \
+		priority(task_priority[TRACE_CURRENT_REDUCTION_Y])
+	current_reduction_y(current);
+}
+
+static inline void omp_current_reduction_x(t_current *current)
+{
+	#pragma omp task depend(inout: BOTTOM(current->J_buf), INTERIOR(current->J_buf, current)) \
+		depend(inout: TOP(current->J_buf, current)) \
+		priority(task_priority[TRACE_CURRENT_REDUCTION_X])
+	current_reduction_x(current);
+}
+
+static inline void omp_current_gc_update_y(t_current *current)
+{
+	#pragma omp task depend(inout: BOTTOM(current->J_buf), BELOW(current->J_below, current)) \
+		priority(task_priority[TRACE_CURRENT_UPDATE_GC])
+	current_gc_update_y(current);
+}
+
+static inline void omp_current_smooth_x(t_current *current)
+{
+	#pragma omp task depend(inout: BOTTOM(current->J_buf), INTERIOR(current->J_buf, current)) \
+		depend(inout: TOP(current->J_buf, current)) \
+		priority(task_priority[TRACE_CURRENT_SMOOTH_X])
+	current_smooth_x(current);
+}
+
+static inline void omp_current_smooth_y(t_current *current, enum smooth_type type)
+{
+	#pragma omp task depend(inout: BOTTOM(current->J_buf), INTERIOR(current->J_buf, current)) \
+		depend(inout: TOP(current->J_buf, current)) \
+		priority(task_priority[TRACE_CURRENT_SMOOTH_Y])
+	current_smooth_y(current, type);
+}
+
+#define current_zero omp_current_zero
+#define current_reduction_y omp_current_reduction_y
+#define current_reduction_x omp_current_reduction_x
+#define current_gc_update_y omp_current_gc_update_y
+#define current_smooth_x omp_current_smooth_x
+#define current_smooth_y omp_current_smooth_y
+
+/*********************************************************************************************
+ EMF
+ *********************************************************************************************/
+
+static inline void omp_emf_advance(t_emf *emf, t_current *current, const bool clear_current)
+{
+	#pragma omp task depend(inout: BOTTOM(current->J_buf), INTERIOR(current->J_buf, current)) \
+		depend(inout: TOP(current->J_buf, current)) \
+		depend(inout: BOTTOM(emf->E_buf), INTERIOR(emf->E_buf, emf), TOP(emf->E_buf, emf)) \
+		depend(inout: BOTTOM(emf->B_buf), INTERIOR(emf->B_buf, emf), TOP(emf->B_buf, emf)) \
+		priority(task_priority[TRACE_EMF_ADVANCE])
+	emf_advance(emf, current, clear_current);
+}
+
+static inline void omp_emf_update_gc_y(t_emf *emf)
+{
+	#pragma omp task depend(inout: BOTTOM(emf->E_buf), BELOW(emf->E_below, emf)) \
+		depend(inout: BOTTOM(emf->B_buf), BELOW(emf->B_below, emf)) \
+		priority(task_priority[TRACE_EMF_UPDATE_GC])
+	emf_update_gc_y(emf);
+}
+
+#define emf_advance omp_emf_advance
+#define emf_update_gc_y omp_emf_update_gc_y
+
+/*********************************************************************************************
+ Laser envelope
+ *********************************************************************************************/
+
+static inline void omp_envelope_reduction_y(t_envelope *env)
+{
+	#pragma omp task depend(inout: BOTTOM(env->chi_buf), BELOW(env->chi_below, env)) \
+		priority(task_priority[TRACE_ENVELOPE_REDUCTION_Y])
+	envelope_reduction_y(env);
+}
+
+static inline void omp_envelope_advance(t_envelope *env)
+{
+	#pragma omp task depend(inout: BOTTOM(env->A_buf), TOP(env->A_buf, env)) \
+		depend(inout: BOTTOM(env->A_old_buf), BOTTOM(env->a2_buf), TOP(env->a2_buf, env)) \
+		depend(inout: BOTTOM(env->chi_buf), TOP(env->chi_buf, env)) \
+		priority(task_priority[TRACE_ENVELOPE_ADVANCE])
+	envelope_advance(env);
+}
+
+static inline void omp_envelope_update_gc_y(t_envelope *env)
+{
+	#pragma omp task depend(inout: BOTTOM(env->A_buf), BELOW(env->A_below, env)) \
+		depend(inout: BOTTOM(env->a2_buf), BELOW(env->a2_below, env)) \
+		priority(task_priority[TRACE_ENVELOPE_UPDATE_GC])
+	envelope_update_gc_y(env);
+}
+
+#define envelope_reduction_y omp_envelope_reduction_y
+#define envelope_advance omp_envelope_advance
+#define envelope_update_gc_y omp_envelope_update_gc_y
+
+/*********************************************************************************************
+ Particles
+ *********************************************************************************************/
+
+static inline void omp_spec_advance(t_species *spec, const t_emf *emf, t_current *current,
+		const int limits_y[2])
+{
+	#pragma omp task depend(in: BOTTOM(emf->E_buf), INTERIOR(emf->E_buf, emf), TOP(emf->E_buf, emf)) \
+		depend(in: BOTTOM(emf->B_buf), INTERIOR(emf->B_buf, emf), TOP(emf->B_buf, emf)) \
+		depend(inout: spec->main_vector, BOTTOM(current->J_buf), INTERIOR(current->J_buf, current)) \
+		depend(inout: TOP(current->J_buf, current)) \
+		priority(task_priority[TRACE_SPEC_ADVANCE])
+	spec_advance(spec, emf, current, limits_y);
+}
+
+static inline void omp_spec_advance_interior(t_species *spec, const t_emf *emf,
+		t_current *current, const int limits_y[2])
+{
+	#pragma omp task depend(in: INTERIOR(emf->E_buf, emf), INTERIOR(emf->B_buf, emf)) \
+		depend(inout: spec->main_vector, INTERIOR(current->J_buf, current)) \
+		priority(task_priority[TRACE_SPEC_ADVANCE])
+	spec_advance_interior(spec, emf, current, limits_y);
+}
+
+static inline void omp_spec_advance_band(t_species *spec, const t_emf *emf, t_current *current,
+		const int limits_y[2])
+{
+	#pragma omp task depend(in: BOTTOM(emf->E_buf), INTERIOR(emf->E_buf, emf), TOP(emf->E_buf, emf)) \
+		depend(in: BOTTOM(emf->B_buf), INTERIOR(emf->B_buf, emf), TOP(emf->B_buf, emf)) \
+		depend(inout: spec->main_vector, BOTTOM(current->J_buf), INTERIOR(current->J_buf, current)) \
+		depend(inout: TOP(current->J_buf, current)) \
+		priority(task_priority[TRACE_SPEC_ADVANCE_BAND])
+	spec_advance_band(spec, emf, current, limits_y);
+}
+
+static inline void omp_spec_advance_refined(t_species *spec, const t_emf *emf, t_current *current,
+		t_patch *patch, const int limits_y[2])
+{
+	#pragma omp task depend(in: BOTTOM(emf->E_buf), INTERIOR(emf->E_buf, emf), TOP(emf->E_buf, emf)) \
+		depend(in: BOTTOM(emf->B_buf), INTERIOR(emf->B_buf, emf), TOP(emf->B_buf, emf)) \
+		depend(in: BOTTOM(patch->emf.E_buf), TOP(patch->emf.E_buf, &patch->emf)) \
+		depend(in: BOTTOM(patch->emf.B_buf), TOP(patch->emf.B_buf, &patch->emf)) \
+		depend(inout: spec->main_vector, BOTTOM(current->J_buf), INTERIOR(current->J_buf, current)) \
+		depend(inout: TOP(current->J_buf, current)) \
+		depend(inout: BOTTOM(patch->current.J_buf), TOP(patch->current.J_buf, &patch->current)) \
+		priority(task_priority[TRACE_SPEC_ADVANCE])
+	spec_advance_refined(spec, emf, current, patch, limits_y);
+}
+
+static inline void omp_spec_advance_envelope(t_species *spec, const t_emf *emf,
+		t_current *current, t_envelope *envelope, const int limits_y[2])
+{
+	#pragma omp task depend(in: BOTTOM(emf->E_buf), INTERIOR(emf->E_buf, emf), TOP(emf->E_buf, emf)) \
+		depend(in: BOTTOM(emf->B_buf), INTERIOR(emf->B_buf, emf), TOP(emf->B_buf, emf)) \
+		depend(in: BOTTOM(envelope->a2_buf), TOP(envelope->a2_buf, envelope)) \
+		depend(inout: spec->main_vector, BOTTOM(current->J_buf), INTERIOR(current->J_buf, current)) \
+		depend(inout: TOP(current->J_buf, current)) \
+		depend(inout: BOTTOM(envelope->chi_buf), TOP(envelope->chi_buf, envelope)) \
+		priority(task_priority[TRACE_SPEC_ADVANCE])
+	spec_advance_envelope(spec, emf, current, envelope, limits_y);
+}
+
+static inline void omp_spec_merge_vectors(t_species *spec)
+{
+	#pragma omp task depend(inout: spec->main_vector) priority(task_priority[TRACE_SPEC_MERGE])
+	spec_merge_vectors(spec);
+}
+
+#define spec_advance omp_spec_advance
+#define spec_advance_interior omp_spec_advance_interior
+#define spec_advance_band omp_spec_advance_band
+#define spec_advance_refined omp_spec_advance_refined
+#define spec_advance_envelope omp_spec_advance_envelope
+#define spec_merge_vectors omp_spec_merge_vectors
+
+/*********************************************************************************************
+ Mesh refinement, lab frame diagnostics and regions
+ *********************************************************************************************/
+
+static inline void omp_patch_advance(t_patch *patch, t_emf *coarse, const int substep)
+{
+	#pragma omp task depend(inout: BOTTOM(patch->emf.E_buf), TOP(patch->emf.E_buf, &patch->emf)) \
+		depend(inout: BOTTOM(patch->emf.B_buf), TOP(patch->emf.B_buf, &patch->emf)) \
+		depend(in: BOTTOM(patch->current.J_buf), TOP(patch->current.J_buf, &patch->current)) \
+		depend(inout: BOTTOM(coarse->E_buf), INTERIOR(coarse->E_buf, coarse), TOP(coarse->E_buf, coarse)) \
+		depend(inout: BOTTOM(coarse->B_buf), INTERIOR(coarse->B_buf, coarse), TOP(coarse->B_buf, coarse)) \
+		depend(in: BOTTOM(patch->E_old_buf), BOTTOM(patch->B_old_buf)) \
+		depend(inout: BOTTOM(patch->coarse_emf.E_buf), BOTTOM(patch->coarse_emf.B_buf)) \
+		depend(inout: BOTTOM(patch->coarse_current.J_buf)) \
+		priority(task_priority[TRACE_PATCH_ADVANCE])
+	patch_advance(patch, coarse, substep);
+}
+
+static inline void omp_patch_update_coarse(t_patch *patch, const t_emf *coarse)
+{
+	#pragma omp task depend(inout: BOTTOM(patch->emf.E_buf), TOP(patch->emf.E_buf, &patch->emf)) \
+		depend(inout: BOTTOM(patch->emf.B_buf), TOP(patch->emf.B_buf, &patch->emf)) \
+		depend(in: BOTTOM(coarse->E_buf), INTERIOR(coarse->E_buf, coarse), TOP(coarse->E_buf, coarse)) \
+		depend(in: BOTTOM(coarse->B_buf), INTERIOR(coarse->B_buf, coarse), TOP(coarse->B_buf, coarse)) \
+		depend(out: BOTTOM(patch->E_old_buf), BOTTOM(patch->B_old_buf)) \
+		priority(task_priority[TRACE_PATCH_ADVANCE])
+	patch_update_coarse(patch, coarse);
+}
+
+// The snapshot is saved after the updates of all the regions: the updates only read the
+// diagnostic object (and write disjoint parts of the buffer), while the save modifies it
+static inline void omp_lab_diag_update(t_lab_diag *diag, const t_emf *emf, const int limits_y[2],
+		const int iter)
+{
+	#pragma omp task depend(in: BOTTOM(emf->E_buf), INTERIOR(emf->E_buf, emf), TOP(emf->E_buf, emf)) \
+		depend(in: BOTTOM(emf->B_buf), INTERIOR(emf->B_buf, emf), TOP(emf->B_buf, emf), *diag) \
+		priority(task_priority[TRACE_DIAGNOSTICS])
+	lab_diag_update(diag, emf, limits_y, iter);
+}
+
+static inline void omp_lab_diag_save(t_lab_diag *diag, const int s)
+{
+	#pragma omp task depend(inout: *diag)
+	lab_diag_save(diag, s);
+}
+
+static inline void omp_region_load_particles(t_region *region)
+{
+	#pragma omp task depend(inout: *region)
+	region_load_particles(region);
+}
+
+#define patch_advance omp_patch_advance
+#define patch_update_coarse omp_patch_update_coarse
+#define lab_diag_update omp_lab_diag_update
+#define lab_diag_save omp_lab_diag_save
+#define region_load_particles omp_region_load_particles
+
+#endif
@@ -22,6 +22,8 @@
 
 #include "zdf.h"
 #include "timer.h"
+#include "perf_counters.h"
+#include "task_trace.h"
 
 /*********************************************************************************************
  Vector Handling
@@ -47,37 +49,111 @@ void realloc_vector(void **restrict ptr, const int old_size, const int new_size,
 	}
 }
 
-// Add the incoming particles to the main buffer
-void spec_merge_vectors(t_species *spec)
+/*********************************************************************************************
+ Particle queues
+ *********************************************************************************************/
+
+void part_queue_new(t_part_queue *queue, const int size_max)
 {
-	int i = 0, j, k;
-	int size = spec->main_vector.size;
+	for (int k = 0; k < PART_QUEUE_SIZE; k++)
+	{
+		queue->buffer[k].size_max = size_max;
+		queue->buffer[k].data = malloc(size_max * sizeof(t_part));
+		queue->buffer[k].size = 0;
+		queue->step[k] = 0;
+	}
+
+	queue->head = 0;
+	queue->tail = 0;
+}
+
+void part_queue_delete(t_part_queue *queue)
+{
+	for (int k = 0; k < PART_QUEUE_SIZE; k++)
+	{
+		free(queue->buffer[k].data);
+		queue->buffer[k].size = -1;
+	}
+}
+
+// Empty buffer at the tail of the queue, to be filled by the producer
+t_part_vector *part_queue_stage(t_part_queue *queue)
+{
+	const unsigned int tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
 
-	//Loop through all the 2 temp buffers
-	for (k = 0; k < 2; k++)
+	if (tail - __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == PART_QUEUE_SIZE)
 	{
-		int size_temp = spec->incoming_part[k].size;
+		printf("Error: the queue of particles between regions is full. Exiting...\n");
+		exit(1);
+	}
 
-		// Check if buffer is large enough and if not reallocate
-		if (spec->main_vector.size + size_temp > spec->main_vector.size_max)
-		{
-			spec->main_vector.size_max = ((spec->main_vector.size_max + size_temp) / 1024 + 1) * 1024;
-			realloc_vector(&spec->main_vector.data, spec->main_vector.size, spec->main_vector.size_max, sizeof(t_part));
-		}
+	t_part_vector *buffer = &queue->buffer[tail % PART_QUEUE_SIZE];
+	buffer->size = 0;
+	return buffer;
+}
+
+// Make the buffer at the tail of the queue visible to the consumer
+void part_queue_publish(t_part_queue *queue, const int step)
+{
+	const unsigned int tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+
+	queue->step[tail % PART_QUEUE_SIZE] = step;
+	__atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+// Move the particles sent by the neighbours up to the current time step of the species (the
+// buffers of a neighbour that is already in the next time step are left in the queue) to the main
+// buffer. The particles replace the invalid ones in [*i, size) and then are added to the end
+static void spec_receive_particles(t_species *spec, int *i, const int size)
+{
+	for (int k = 0; k < 2; k++)
+	{
+		t_part_queue *queue = &spec->incoming_part[k];
+		unsigned int head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+		const unsigned int tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
 
-		//Loop through all elements on the buffer, copying to the main_vector particle buffer (if applicable)
-		for (j = 0; j < size_temp; j++)
+		for (; head != tail && queue->step[head % PART_QUEUE_SIZE] <= spec->iter; head++)
 		{
-			while (i < size && !spec->main_vector.data[i].invalid) i++;   //Checks if a particle can be safely deleted
-			if (i < size) spec->main_vector.data[i] = spec->incoming_part[k].data[j];
-			else
+			const t_part_vector *incoming = &queue->buffer[head % PART_QUEUE_SIZE];
+			int size_temp = incoming->size;
+
+			// Check if buffer is large enough and if not reallocate
+			if (spec->main_vector.size + size_temp > spec->main_vector.size_max)
 			{
-				spec->main_vector.size++;
-				spec->main_vector.data[i] = spec->incoming_part[k].data[j];
-				i++;
+				spec->main_vector.size_max = ((spec->main_vector.size_max + size_temp) / 1024 + 1) * 1024;
+				realloc_vector(&spec->main_vector.data, spec->main_vector.size, spec->main_vector.size_max, sizeof(t_part));
+			}
+
+			//Loop through all elements on the buffer, copying to the main_vector particle buffer (if applicable)
+			for (int j = 0; j < size_temp; j++)
+			{
+				while (*i < size && !spec->main_vector.data[*i].invalid) (*i)++;   //Checks if a particle can be safely deleted
+				if (*i < size) spec->main_vector.data[*i] = incoming->data[j];
+				else
+				{
+					spec->main_vector.size++;
+					spec->main_vector.data[*i] = incoming->data[j];
+					(*i)++;
+				}
 			}
 		}
+
+		// Return the buffers to the producer
+		__atomic_store_n(&queue->head, head, __ATOMIC_RELEASE);
 	}
+}
+
+// Add the incoming particles to the main buffer
+void spec_merge_vectors(t_species *spec)
+{
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
+	int i = 0;
+	int size = spec->main_vector.size;
+
+	spec_receive_particles(spec, &i, size);
 
 	if (i < size)
 	{
@@ -89,10 +165,10 @@ void spec_merge_vectors(t_species *spec)
 		}
 	}
 
-	//Clean the temp buffer
-	for (k = 0; k < 2; k++)
-		spec->incoming_part[k].size = 0;
-
+	TASK_TRACE_END(TRACE_SPEC_MERGE, spec->region_id, spec->iter - 1,
+			2 * spec->main_vector.size * sizeof(t_part));
+	PERF_COUNTERS_END(PERF_MERGE, spec->region_id, spec->iter - 1);
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 // Add particle to the outgoing buffer
@@ -124,20 +200,89 @@ void spec_set_u(t_part_vector *vector, const int start, const int end, const t_p
 	}
 }
 
-// Set the initial position of the particles
+// Quiet start: set the momentum of the injected particles (in the order of spec_set_x) without
+// the random number generator. The thermal momenta of the particles of each cell are the points
+// of the Halton sequence (bases 2, 3, 5 and 7, normal distribution with the Box-Muller method),
+// shifted (modulo 1) by a hash of the cell index so the cells do not share the same set. The
+// particles 2n and 2n + 1 of the cell take +u and -u, so the fluid momentum of the cell is exact.
+// The momenta only depend on the cell (in the whole simulation space), so they do not depend on
+// the number of regions
+void spec_set_u_quiet(t_part_vector *vector, const int start, const int end,
+		const t_part_data ufl[3], const t_part_data uth[3], const int n_move)
+{
+	const uint32_t base[4] = {2, 3, 5, 7};
+
+	int i = start;
+	while (i < end)
+	{
+		const int ix = vector->data[i].ix;
+		const int iy = vector->data[i].iy;
+
+		// Particles of the cell
+		int np = 1;
+		while (i + np < end && vector->data[i + np].ix == ix && vector->data[i + np].iy == iy)
+			np++;
+
+		// Shift of the sequence in the cell (position of the cell in the simulation space)
+		double shift[4];
+		uint32_t key = rand_hash((uint32_t) (ix + n_move)) ^ (uint32_t) iy;
+		for (int d = 0; d < 4; d++)
+		{
+			key = rand_hash(key + d);
+			shift[d] = (key + 0.5) / 4294967296.0;
+		}
+
+		for (int k = 0; k < np; k++)
+		{
+			// Mirrored pairs of neighbour particles (with an odd number of particles, the last one
+			// is not mirrored)
+			const int n = k / 2;
+			const double sign = (k % 2) ? -1.0 : 1.0;
+
+			double u[4];
+			for (int d = 0; d < 4; d++)
+			{
+				u[d] = rand_radical_inverse(n, base[d]) + shift[d];
+				u[d] -= floor(u[d]);
+			}
+
+			const double r0 = sqrt(-2.0 * log(1.0 - u[0]));
+			const double r1 = sqrt(-2.0 * log(1.0 - u[2]));
+
+			t_part *part = &vector->data[i + k];
+			part->ux = ufl[0] + sign * uth[0] * r0 * cos(2 * M_PI * u[1]);
+			part->uy = ufl[1] + sign * uth[1] * r0 * sin(2 * M_PI * u[1]);
+			part->uz = ufl[2] + sign * uth[2] * r1 * cos(2 * M_PI * u[3]);
+		}
+
+		i += np;
+	}
+}
+
+// Use the quiet start for the species (must be called before sim_new)
+void spec_set_quiet_start(t_species *spec)
+{
+	spec->quiet = true;
+}
+
+// Set the initial position of the particles. The density profile is evaluated once per cell and
+// gives the number of particles in the cell. A cell with the reference number of particles
+// (ppc[0] x ppc[1]) uses a regular grid, otherwise the particles follow the R2 quasi-random
+// sequence (low discrepancy, deterministic)
 void spec_set_x(t_part_vector *vector, const int range[][2], const int ppc[2],
 		const t_density *part_density, const t_part_data dx[2], const int n_move)
 {
-	float *poscell;
-	int start, end;
+	const int npc = ppc[0] * ppc[1];
+	const int row_size = range[0][1] - range[0][0];
+	const int n_rows = range[1][1] - range[1][0];
+
+	if (row_size <= 0 || n_rows <= 0) return;
 
 	// Calculate particle positions inside the cell
-	const int npc = ppc[0] * ppc[1];
+	t_part_data *restrict poscell = malloc(2 * npc * sizeof(t_part_data));
 	t_part_data const dpcx = 1.0f / ppc[0];
 	t_part_data const dpcy = 1.0f / ppc[1];
 
-	poscell = malloc(2 * npc * sizeof(t_part_data));
-
 	int ip = 0;
 	for (int j = 0; j < ppc[1]; j++)
 	{
@@ -149,46 +294,54 @@ void spec_set_x(t_part_vector *vector, const int range[][2], const int ppc[2],
 		}
 	}
 
-	// Set position of particles in the specified grid range according to the density profile
-	switch (part_density->type)
-	{
-		case STEP:    // Step like density profile
-
-			// Get edge position normalized to cell size;
-			start = part_density->start / dx[0] - n_move;
-			if(range[0][0] > start) start = range[0][0];
+	// Number of particles in each cell (according to the density profile)
+	float *restrict profile = malloc(row_size * sizeof(float));
+	int *restrict np_cell = malloc(row_size * n_rows * sizeof(int));
+	int np_inj = 0;
 
-			end = range[0][1];
-			break;
-
-		case SLAB:    // Slab like density profile
-			// Get edge position normalized to cell size;
-			start = part_density->start / dx[0] - n_move;
-			end = part_density->end / dx[0] - n_move;
-
-			if(start < range[0][0]) start = range[0][0];
-			if(end > range[0][1]) end = range[0][1];
-			break;
-
-		default:    // Uniform density
-			start = range[0][0];
-			end = range[0][1];
+	for (int j = 0; j < n_rows; j++)
+	{
+		density_eval_row(part_density, range[1][0] + j, range[0][0], range[0][1], dx, n_move,
+				profile);
+		np_inj += density_np_row(profile, row_size, npc, &np_cell[j * row_size]);
+	}
 
+	// Check if buffer is large enough and if not reallocate
+	if (vector->size + np_inj > vector->size_max)
+	{
+		vector->size_max = ((vector->size_max + np_inj) / 1024 + 1) * 1024;
+		if(!vector->data) vector->data = malloc(vector->size_max * sizeof(t_part));
+		else realloc_vector(&vector->data, vector->size, vector->size_max, sizeof(t_part));
 	}
 
-	ip = vector->size;
+	// R2 sequence
+	const double alpha[2] = {0.7548776662466927, 0.5698402909980532};
 
 	// Set the particles position and cell index
-	for (int j = range[1][0]; j < range[1][1]; j++)
+	ip = vector->size;
+	for (int j = 0; j < n_rows; j++)
 	{
-		for (int i = start; i < end; i++)
+		for (int i = 0; i < row_size; i++)
 		{
-			for (int k = 0; k < npc; k++)
+			const int np = np_cell[i + j * row_size];
+
+			for (int k = 0; k < np; k++)
 			{
-				vector->data[ip].ix = i;
-				vector->data[ip].iy = j;
-				vector->data[ip].x = poscell[2 * k];
-				vector->data[ip].y = poscell[2 * k + 1];
+				vector->data[ip].ix = range[0][0] + i;
+				vector->data[ip].iy = range[1][0] + j;
+
+				if (np == npc)
+				{
+					vector->data[ip].x = poscell[2 * k];
+					vector->data[ip].y = poscell[2 * k + 1];
+				} else
+				{
+					const double x = 0.5 + alpha[0] * k;
+					const double y = 0.5 + alpha[1] * k;
+					vector->data[ip].x = x - floor(x);
+					vector->data[ip].y = y - floor(y);
+				}
+
 				vector->data[ip].invalid = false;
 				ip++;
 			}
@@ -196,32 +349,25 @@ void spec_set_x(t_part_vector *vector, const int range[][2], const int ppc[2],
 	}
 
 	vector->size = ip;
+
+	free(np_cell);
+	free(profile);
 	free(poscell);
 }
 
 // Inject the particles in the simulation
 void spec_inject_particles(t_part_vector *part_vector, const int range[][2], const int ppc[2],
 		const t_density *part_density, const t_part_data dx[2], const int n_move,
-		const t_part_data ufl[3], const t_part_data uth[3])
+		const t_part_data ufl[3], const t_part_data uth[3], const bool quiet)
 {
 	int start = part_vector->size;
 
-	// Get maximum number of particles to inject
-	int np_inj = (range[0][1] - range[0][0]) * (range[1][1] - range[1][0]) * ppc[0] * ppc[1];
-
-	// Check if buffer is large enough and if not reallocate
-	if (start + np_inj > part_vector->size_max)
-	{
-		part_vector->size_max = ((part_vector->size_max + np_inj) / 1024 + 1) * 1024;
-		if(!part_vector->data) part_vector->data = malloc(part_vector->size_max * sizeof(t_part));
-		else realloc_vector(&part_vector->data, part_vector->size, part_vector->size_max, sizeof(t_part));
-	}
-
-	// Set particle positions
+	// Set particle positions (the buffer is enlarged if needed)
 	spec_set_x(part_vector, range, ppc, part_density, dx, n_move);
 
 	// Set momentum of injected particles
-	spec_set_u(part_vector, start, part_vector->size, ufl, uth);
+	if (quiet) spec_set_u_quiet(part_vector, start, part_vector->size, ufl, uth, n_move);
+	else spec_set_u(part_vector, start, part_vector->size, ufl, uth);
 }
 
 // Constructor
@@ -255,13 +401,14 @@ void spec_new(t_species *spec, char name[], const t_part_data m_q, const int ppc
 	spec->main_vector.data = NULL;
 	spec->main_vector.size = 0;
 
-	// Initialize temp buffer
+	// Initialize the queues of incoming particles
 	for (int i = 0; i < 2; i++)
-	{
-		spec->incoming_part[i].size_max = spec->nx[0] / 4;
-		spec->incoming_part[i].data = malloc(spec->incoming_part[i].size_max * sizeof(t_part));
-		spec->incoming_part[i].size = 0;
-	}
+		part_queue_new(&spec->incoming_part[i], spec->nx[0] / 4);
+
+	// Initialize the band particles (see spec_advance_interior)
+	spec->band_part = NULL;
+	spec->n_band = 0;
+	spec->band_max = 0;
 
 	// Initialize density profile
 	if (density)
@@ -303,9 +450,22 @@ void spec_new(t_species *spec, char name[], const t_part_data m_q, const int ppc
 
 	spec->npush = 0.0;
 
+	// Random thermal momentum
+	spec->quiet = false;
+
 	// Reset moving window information
 	spec->moving_window = false;
 	spec->n_move = 0;
+
+	// No plasma flow (lab frame)
+	spec->flow = 0;
+	spec->n_inject = 0;
+
+	// Periodic boundaries
+	for (int i = 0; i < 2; i++)
+		spec->absorbing[i][0] = spec->absorbing[i][1] = false;
+
+	spec->region_id = 0;
 }
 
 void spec_delete(t_species *spec)
@@ -314,10 +474,9 @@ void spec_delete(t_species *spec)
 	spec->main_vector.size = -1;
 
 	for(int i = 0; i < 2; i++)
-	{
-		free(spec->incoming_part[i].data);
-		spec->incoming_part[i].size = -1;
-	}
+		part_queue_delete(&spec->incoming_part[i]);
+
+	free(spec->band_part);
 }
 
 /*********************************************************************************************
@@ -571,6 +730,198 @@ void dep_current_zamb(int ix, int iy, int di, int dj, float x0, float y0, float
 	}
 }
 
+/*********************************************************************************************
+ Higher order particle shapes
+ *********************************************************************************************/
+
+// Largest integer not greater than x, for x > -8 (the positions are always close to the cell of
+// the particle, so the conversion truncates a positive value instead of calling floorf)
+static inline int shape_floor(const t_fld x)
+{
+	return (int) (x + 8.0f) - 8;
+}
+
+// Weights of the B-spline of the given order (1 - linear, 2 - quadratic, 3 - cubic) for the
+// position x (in cells, relative to the cell of the particle). The weights of the order + 1
+// nodes are stored in w and the index of the first node is returned
+static inline int shape_weights(const t_fld x, const int order, t_fld *restrict w)
+{
+	switch (order)
+	{
+		case 2:
+		{
+			const int c = shape_floor(x + 0.5f);
+			const t_fld d = x - c;
+
+			w[0] = 0.5f * (0.5f - d) * (0.5f - d);
+			w[1] = 0.75f - d * d;
+			w[2] = 0.5f * (0.5f + d) * (0.5f + d);
+			return c - 1;
+		}
+		case 3:
+		{
+			const int c = shape_floor(x);
+			const t_fld d = x - c;
+			const t_fld d2 = d * d;
+			const t_fld d3 = d2 * d;
+
+			w[0] = (1.0f - d) * (1.0f - d) * (1.0f - d) * (1.0f / 6.0f);
+			w[1] = (4.0f - 6.0f * d2 + 3.0f * d3) * (1.0f / 6.0f);
+			w[2] = (1.0f + 3.0f * d + 3.0f * d2 - 3.0f * d3) * (1.0f / 6.0f);
+			w[3] = d3 * (1.0f / 6.0f);
+			return c - 1;
+		}
+		default:
+		{
+			const int c = shape_floor(x);
+
+			w[0] = 1.0f - (x - c);
+			w[1] = x - c;
+			return c;
+		}
+	}
+}
+
+// EM fields interpolation with the shape of the given order. The components in the nodes (i)
+// use the weights of the position x and the components in the middle of the cells (i + 1/2) the
+// weights of x - 1/2 (see interpolate_fld for the position of each component)
+static inline void interpolate_fld_shape(const t_vfld *restrict const E,
+		const t_vfld *restrict const B, const int nrow, const t_part *restrict const part,
+		t_vfld *restrict const Ep, t_vfld *restrict const Bp, const int offset, const int order)
+{
+	t_fld wx[4], wy[4], wxh[4], wyh[4];
+
+	const int i = part->ix + shape_weights(part->x, order, wx);
+	const int j = part->iy - offset + shape_weights(part->y, order, wy);
+	const int ih = part->ix + shape_weights(part->x - 0.5f, order, wxh);
+	const int jh = part->iy - offset + shape_weights(part->y - 0.5f, order, wyh);
+
+	t_vfld e = { 0 }, b = { 0 };
+
+	for (int m = 0; m <= order; m++)
+	{
+		for (int k = 0; k <= order; k++)
+		{
+			e.x += E[ih + k + (j + m) * nrow].x * wxh[k] * wy[m];
+			e.y += E[i + k + (jh + m) * nrow].y * wx[k] * wyh[m];
+			e.z += E[i + k + (j + m) * nrow].z * wx[k] * wy[m];
+
+			b.x += B[i + k + (jh + m) * nrow].x * wx[k] * wyh[m];
+			b.y += B[ih + k + (j + m) * nrow].y * wxh[k] * wy[m];
+			b.z += B[ih + k + (jh + m) * nrow].z * wxh[k] * wyh[m];
+		}
+	}
+
+	*Ep = e;
+	*Bp = b;
+}
+
+// Current deposition with the shape of the given order (Esirkepov method). The particle moves
+// from (x0, y0) to (x1, y1), both relative to the cell (ix, iy). The shapes at the start and end
+// of the trajectory are placed in a common window of order + 2 nodes
+static inline void dep_current_shape(const int ix, const int iy, const t_fld x0, const t_fld y0,
+		const t_fld x1, const t_fld y1, const t_part_data qnx, const t_part_data qny,
+		const t_part_data qvz, t_current *current, const int order)
+{
+	const int n = order + 2;
+	t_fld w0x[4], w0y[4], w1x[4], w1y[4];
+	t_fld S0x[5] = { 0 }, S0y[5] = { 0 }, DSx[5] = { 0 }, DSy[5] = { 0 };
+
+	const int s0x = shape_weights(x0, order, w0x);
+	const int s0y = shape_weights(y0, order, w0y);
+	const int s1x = shape_weights(x1, order, w1x);
+	const int s1y = shape_weights(y1, order, w1y);
+
+	// First node of the window
+	const int bx = s0x < s1x ? s0x : s1x;
+	const int by = s0y < s1y ? s0y : s1y;
+
+	for (int k = 0; k <= order; k++)
+	{
+		S0x[s0x - bx + k] = w0x[k];
+		S0y[s0y - by + k] = w0y[k];
+	}
+
+	for (int k = 0; k <= order; k++)
+	{
+		DSx[s1x - bx + k] += w1x[k];
+		DSy[s1y - by + k] += w1y[k];
+	}
+
+	for (int k = 0; k < n; k++)
+	{
+		DSx[k] -= S0x[k];
+		DSy[k] -= S0y[k];
+	}
+
+	const int nrow = current->nrow;
+	t_vfld *restrict const J = current->J + (ix + bx) + (iy + by) * nrow;
+
+	// jx
+	for (int j = 0; j < n; j++)
+	{
+		const t_fld wy = S0y[j] + 0.5f * DSy[j];
+		t_fld c = 0;
+
+		for (int i = 0; i < n; i++)
+		{
+			c -= qnx * DSx[i] * wy;
+			J[i + j * nrow].x += c;
+		}
+	}
+
+	// jy
+	for (int i = 0; i < n; i++)
+	{
+		const t_fld wx = S0x[i] + 0.5f * DSx[i];
+		t_fld c = 0;
+
+		for (int j = 0; j < n; j++)
+		{
+			c -= qny * DSy[j] * wx;
+			J[i + j * nrow].y += c;
+		}
+	}
+
+	// jz
+	for (int j = 0; j < n; j++)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			J[i + j * nrow].z += qvz * (S0x[i] * S0y[j] + 0.5f * DSx[i] * S0y[j]
+					+ 0.5f * S0x[i] * DSy[j] + DSx[i] * DSy[j] * (1.0f / 3.0f));
+		}
+	}
+}
+
+// Kernels of each shape order (the order is a compile time constant in each one)
+#define SHAPE_KERNELS(N) \
+void interpolate_fld_s##N(const t_vfld *restrict const E, const t_vfld *restrict const B, \
+		const int nrow, const t_part *restrict const part, t_vfld *restrict const Ep, \
+		t_vfld *restrict const Bp, const int offset) \
+{ \
+	interpolate_fld_shape(E, B, nrow, part, Ep, Bp, offset, N); \
+} \
+\
+void dep_current_s##N(const int ix, const int iy, const t_fld x0, const t_fld y0, \
+		const t_fld x1, const t_fld y1, const t_part_data qnx, const t_part_data qny, \
+		const t_part_data qvz, t_current *current) \
+{ \
+	dep_current_shape(ix, iy, x0, y0, x1, y1, qnx, qny, qvz, current, N); \
+}
+
+SHAPE_KERNELS(2)
+SHAPE_KERNELS(3)
+
+// Kernels of the particle shape selected at compile time (the linear shape uses interpolate_fld
+// and dep_current_zamb)
+#if SHAPE_ORDER == 2
+#define INTERPOLATE_FLD_SHAPE interpolate_fld_s2
+#define DEP_CURRENT_SHAPE dep_current_s2
+#elif SHAPE_ORDER == 3
+#define INTERPOLATE_FLD_SHAPE interpolate_fld_s3
+#define DEP_CURRENT_SHAPE dep_current_s3
+#endif
 
 /*********************************************************************************************
  Particle advance
@@ -617,11 +968,209 @@ void interpolate_fld(const t_vfld *restrict const E, const t_vfld *restrict cons
 
 }
 
-// Particle advance
-void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const int limits_y[2])
+// Interpolate the fine fields of the patch at the particle position
+static void patch_interpolate_fld(const t_patch *restrict patch, const t_part *restrict part,
+		t_vfld *restrict Ep, t_vfld *restrict Bp)
+{
+	const int r = patch->ratio;
+	const float x = part->x * r;
+	const float y = part->y * r;
+
+	int cx = x;
+	int cy = y;
+	if (cx > r - 1) cx = r - 1;
+	if (cy > r - 1) cy = r - 1;
+
+	t_part fine;
+	fine.ix = (part->ix - patch->origin[0]) * r + cx;
+	fine.iy = (part->iy - patch->origin[1]) * r + cy;
+	fine.x = x - cx;
+	fine.y = y - cy;
+
+	interpolate_fld(patch->emf.E, patch->emf.B, patch->emf.nrow, &fine, Ep, Bp, 0);
+}
+
+// Deposit the current of the particle in the fine grid of the patch. The trajectory is split in
+// ratio segments (shorter than a fine cell), each one taking 1 / ratio of the time step. The
+// charge of the particle is ratio^2 larger in the fine grid (the cell is ratio^2 smaller)
+static void dep_current_patch(const t_part *restrict part, const float dx, const float dy,
+		const t_part_data qnx, const t_part_data qny, const t_part_data qvz, t_patch *patch)
+{
+	const int r = patch->ratio;
+	const int ix0 = (part->ix - patch->origin[0]) * r;
+	const int iy0 = (part->iy - patch->origin[1]) * r;
+
+	for (int k = 0; k < r; k++)
+	{
+		// Segment start, in fine cells
+		float x0 = part->x * r + k * dx;
+		float y0 = part->y * r + k * dy;
+
+		int cx = floorf(x0);
+		int cy = floorf(y0);
+		x0 -= cx;
+		y0 -= cy;
+
+		if (x0 >= 1.0f)
+		{
+			x0 -= 1.0f;
+			cx++;
+		}
+
+		if (y0 >= 1.0f)
+		{
+			y0 -= 1.0f;
+			cy++;
+		}
+
+		const int di = LTRIM(x0 + dx);
+		const int dj = LTRIM(y0 + dy);
+
+		dep_current_zamb(ix0 + cx, iy0 + cy, di, dj, x0, y0, dx, dy, qnx * r, qny * r, qvz * r,
+				&patch->current);
+	}
+}
+
+// Boundary conditions of the particles after the push (transfer the particles between regions
+// and move the simulation window, if applicable)
+static void spec_boundaries(t_species *spec, const int limits_y[2])
 {
 	const int nx0 = spec->nx[0];
 	const int nx1 = spec->nx[1];
+
+	// Buffers of the particles leaving the region
+	t_part_vector *outgoing[2];
+	for (int k = 0; k < 2; k++)
+		outgoing[k] = part_queue_stage(spec->outgoing_part[k]);
+
+	for(int i = 0; i < spec->main_vector.size; i++)
+	{
+		int iy = spec->main_vector.data[i].iy;
+
+		// First shift particle left (if applicable), then check for particles leaving the simulation space
+		if (spec->moving_window)
+		{
+			if ((spec->iter * spec->dt) > (spec->dx[0] * (spec->n_move + 1)))
+				spec->main_vector.data[i].ix--;
+
+			if ((spec->main_vector.data[i].ix < 0) || (spec->main_vector.data[i].ix >= nx0))
+			{
+				spec->main_vector.data[i].invalid = true;
+				continue;
+			}
+		} else
+		{
+			// Periodic (or absorbing) boundaries for X axis
+			if (spec->main_vector.data[i].ix < 0)
+			{
+				if (spec->absorbing[0][0])
+				{
+					spec->main_vector.data[i].invalid = true;
+					continue;
+				}
+				spec->main_vector.data[i].ix += nx0;
+			} else if (spec->main_vector.data[i].ix >= nx0)
+			{
+				if (spec->absorbing[0][1])
+				{
+					spec->main_vector.data[i].invalid = true;
+					continue;
+				}
+				spec->main_vector.data[i].ix -= nx0;
+			}
+		}
+
+		// Periodic (or absorbing) boundaries for Y axis
+		if (spec->main_vector.data[i].iy < 0)
+		{
+			if (spec->absorbing[1][0])
+			{
+				spec->main_vector.data[i].invalid = true;
+				continue;
+			}
+			spec->main_vector.data[i].iy += nx1;
+		} else if (spec->main_vector.data[i].iy >= nx1)
+		{
+			if (spec->absorbing[1][1])
+			{
+				spec->main_vector.data[i].invalid = true;
+				continue;
+			}
+			spec->main_vector.data[i].iy -= nx1;
+		}
+
+		//Verify if the particle is still in the correct region. If not send the particle to the correct one
+		if (iy < limits_y[0]) // Particles going to the region below
+		{
+			spec_add_to_outgoing_vector(outgoing[0], spec->main_vector.data[i]);
+			spec->main_vector.data[i].invalid = true; // Mark the particle as invalid
+
+		} else if (iy >= limits_y[1]) // Particles going to the region above
+		{
+			spec_add_to_outgoing_vector(outgoing[1], spec->main_vector.data[i]);
+			spec->main_vector.data[i].invalid = true; // Mark the particle as invalid
+		}
+	}
+
+	for (int k = 0; k < 2; k++)
+		if (outgoing[k]->size > 0) part_queue_publish(spec->outgoing_part[k], spec->iter);
+
+	if (spec->moving_window && (spec->iter * spec->dt) > (spec->dx[0] * (spec->n_move + 1)))
+	{
+		// Increase moving window counter
+		spec->n_move++;
+
+		// Inject particles in the right edge of the simulation box
+		const int range[][2] = {{spec->nx[0] - 1, spec->nx[0]}, {limits_y[0], limits_y[1]}};
+		spec_inject_particles(&spec->main_vector, range, spec->ppc, &spec->density,
+				spec->dx, spec->n_move, spec->ufl, spec->uth, spec->quiet);
+	}
+
+	// Boosted frame: inject a new column of plasma each time the plasma flows one cell
+	if (spec->flow > 0 && (spec->iter * spec->dt * spec->flow) > (spec->dx[0] * (spec->n_inject + 1)))
+	{
+		spec->n_inject++;
+
+		const int start = spec->main_vector.size;
+		const int range[][2] = {{spec->nx[0] - 1, spec->nx[0]}, {limits_y[0], limits_y[1]}};
+		spec_inject_particles(&spec->main_vector, range, spec->ppc, &spec->density,
+				spec->dx, spec->n_inject, spec->ufl, spec->uth, spec->quiet);
+
+		// The plasma already flowed a fraction of a cell past the column, so the new particles
+		// are moved left by the same distance as the rest of the plasma (below one cell)
+		const t_part_data shift = (spec->iter * spec->dt * spec->flow) / spec->dx[0]
+				- spec->n_inject;
+
+		for (int i = start; i < spec->main_vector.size; i++)
+		{
+			t_part *restrict part = &spec->main_vector.data[i];
+			part->x -= shift;
+			if (part->x < 0)
+			{
+				part->x += 1.0f;
+				part->ix--;
+			}
+		}
+	}
+}
+
+// Particles pushed by spec_push
+enum push_part {
+	PUSH_ALL,
+	PUSH_INTERIOR,   // Only the particles far from the edges of the region
+	PUSH_BAND        // The particles left by PUSH_INTERIOR
+};
+
+// Particle advance (with a fine patch, the particles inside it are pushed with the fine fields
+// and also deposit current in the fine grid). With a laser envelope, the particles also feel the
+// ponderomotive force of the laser and deposit their susceptibility (see envelope.h)
+static void spec_push(t_species *spec, const t_emf *emf, t_current *current, t_patch *patch,
+		t_envelope *envelope, const int limits_y[2], const enum push_part part)
+{
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
 	const t_part_data tem = 0.5 * spec->dt / spec->m_q;
 	const t_part_data dt_dx = spec->dt / spec->dx[0];
 	const t_part_data dt_dy = spec->dt / spec->dx[1];
@@ -630,14 +1179,48 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const i
 	const t_part_data qnx = spec->q * spec->dx[0] / spec->dt;
 	const t_part_data qny = spec->q * spec->dx[1] / spec->dt;
 
-	spec->npush += spec->main_vector.size;
+	// Auxiliary values for the laser envelope: (q/m)^2 / 2, ponderomotive impulse in half time
+	// step (without the gradient and gamma) and susceptibility (without gamma)
+	const t_part_data pond_a2 = 0.5f / (spec->m_q * spec->m_q);
+	const t_part_data pond_dt = 0.125f * spec->dt / (spec->m_q * spec->m_q);
+	const t_part_data q_chi = spec->q / spec->m_q;
+
+	// The stencils of the particles in the rows [band, nx - band) of the region do not reach the
+	// rows exchanged with the neighbouring regions
+	const int band = emf->gc[1][0] + emf->gc[1][1];
+
+	// Particles that the neighbours sent after the merge of the previous time step
+	if (part != PUSH_BAND)
+	{
+		int i = spec->main_vector.size;
+		spec_receive_particles(spec, &i, spec->main_vector.size);
+	}
 
-	// Advance internal iteration number
-	spec->iter += 1;
+	if (part == PUSH_INTERIOR)
+	{
+		if (spec->band_max < spec->main_vector.size)
+		{
+			free(spec->band_part);
+			spec->band_max = spec->main_vector.size_max;
+			spec->band_part = malloc(spec->band_max * sizeof(int));
+		}
+		spec->n_band = 0;
+	}
+
+	if (part != PUSH_BAND)
+	{
+		spec->npush += spec->main_vector.size;
+
+		// Advance internal iteration number
+		spec->iter += 1;
+	}
 
 	// Advance particles
-	for (int i = 0; i < spec->main_vector.size; i++)
+	const int n_push = part == PUSH_BAND ? spec->n_band : spec->main_vector.size;
+	for (int k = 0; k < n_push; k++)
 	{
+		const int i = part == PUSH_BAND ? spec->band_part[k] : k;
+
 		t_vfld Ep, Bp;
 		t_part_data utx, uty, utz;
 		t_part_data ux, uy, uz, rg;
@@ -645,25 +1228,67 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const i
 		t_part_data gtem, otsq;
 		t_part_data qvz;
 		t_part_data x1, y1;
+		t_part_data a2 = 0, fpx = 0, fpy = 0;
 
 		int di, dj;
 		float dx, dy;
 
+		if (part == PUSH_INTERIOR)
+		{
+			const int iy = spec->main_vector.data[i].iy - limits_y[0];
+			if (iy < band || iy >= emf->nx[1] - band)
+			{
+				spec->band_part[spec->n_band++] = i;
+				continue;
+			}
+		}
+
 		// Load particle momenta
 		ux = spec->main_vector.data[i].ux;
 		uy = spec->main_vector.data[i].uy;
 		uz = spec->main_vector.data[i].uz;
 
 		// Interpolate fields
-		interpolate_fld(emf->E, emf->B, emf->nrow, &spec->main_vector.data[i], &Ep, &Bp, limits_y[0]);
+		if (patch && patch_gather_zone(patch, spec->main_vector.data[i].ix,
+				spec->main_vector.data[i].iy))
+			patch_interpolate_fld(patch, &spec->main_vector.data[i], &Ep, &Bp);
+		else
+		{
+#if SHAPE_ORDER == 1
+			interpolate_fld(emf->E, emf->B, emf->nrow, &spec->main_vector.data[i], &Ep, &Bp,
+					limits_y[0]);
+#else
+			INTERPOLATE_FLD_SHAPE(emf->E, emf->B, emf->nrow, &spec->main_vector.data[i], &Ep, &Bp,
+					limits_y[0]);
+#endif
+		}
+
+		// Ponderomotive force of the laser envelope, with the gamma of the quiver motion at t_n
+		// (a2 = (q/m)^2 |A|^2 / 2)
+		if (envelope)
+		{
+			const t_part *restrict part = &spec->main_vector.data[i];
+			t_fld grad_x, grad_y;
+
+			envelope_interpolate(envelope, part->ix, part->iy - limits_y[0], part->x, part->y, &a2,
+					&grad_x, &grad_y);
+			a2 *= pond_a2;
+
+			const t_part_data g = sqrtf(1.0f + ux * ux + uy * uy + uz * uz + a2);
+			fpx = -pond_dt * grad_x / g;
+			fpy = -pond_dt * grad_y / g;
+
+			envelope_deposit_chi(envelope, part->ix, part->iy - limits_y[0], part->x, part->y,
+					q_chi / g);
+		}
 
 		// Advance u using Boris scheme
 		Ep.x *= tem;
 		Ep.y *= tem;
 		Ep.z *= tem;
 
-		utx = ux + Ep.x;
-		uty = uy + Ep.y;
+		utx = ux + Ep.x + fpx;
+		uty = uy + Ep.y + fpy;
 		utz = uz + Ep.z;
 
 		// Get time centered energy
@@ -672,7 +1297,7 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const i
 		spec->energy += utsq / (gamma + 1);
 
 		// Perform first half of the rotation
-		gtem = tem / sqrtf(1.0f + utx * utx + uty * uty + utz * utz);
+		gtem = tem / sqrtf(1.0f + utx * utx + uty * uty + utz * utz + a2);
 
 		Bp.x *= gtem;
 		Bp.y *= gtem;
@@ -694,8 +1319,8 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const i
 		utz += ux * Bp.y - uy * Bp.x;
 
 		// Perform second half of electric field acceleration
-		ux = utx + Ep.x;
-		uy = uty + Ep.y;
+		ux = utx + Ep.x + fpx;
+		uy = uty + Ep.y + fpy;
 		uz = utz + Ep.z;
 
 		// Store new momenta
@@ -704,7 +1329,7 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const i
 		spec->main_vector.data[i].uz = uz;
 
 		// push particle
-		rg = 1.0f / sqrtf(1.0f + ux * ux + uy * uy + uz * uz);
+		rg = 1.0f / sqrtf(1.0f + ux * ux + uy * uy + uz * uz + a2);
 
 		dx = dt_dx * rg * ux;
 		dy = dt_dy * rg * uy;
@@ -720,9 +1345,20 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const i
 
 		qvz = spec->q * uz * rg;
 
+#if SHAPE_ORDER == 1
 		dep_current_zamb(spec->main_vector.data[i].ix, spec->main_vector.data[i].iy - limits_y[0],
 				di, dj, spec->main_vector.data[i].x, spec->main_vector.data[i].y, dx, dy, qnx, qny,
 				qvz, current);
+#else
+		DEP_CURRENT_SHAPE(spec->main_vector.data[i].ix, spec->main_vector.data[i].iy - limits_y[0],
+				spec->main_vector.data[i].x, spec->main_vector.data[i].y,
+				spec->main_vector.data[i].x + dx, spec->main_vector.data[i].y + dy, qnx, qny, qvz,
+				current);
+#endif
+
+		if (patch && patch_deposit_zone(patch, spec->main_vector.data[i].ix,
+				spec->main_vector.data[i].iy))
+			dep_current_patch(&spec->main_vector.data[i], dx, dy, qnx, qny, qvz, patch);
 
 		// Store results
 		spec->main_vector.data[i].x = x1;
@@ -731,57 +1367,41 @@ void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const i
 		spec->main_vector.data[i].iy += dj;
 	}
 
-	// Particle post processing (Transfer particles between regions and move the simulation
-	// window, if applicable)
-	for(int i = 0; i < spec->main_vector.size; i++)
-	{
-		int iy = spec->main_vector.data[i].iy;
-
-		// First shift particle left (if applicable), then check for particles leaving the simulation space
-		if (spec->moving_window)
-		{
-			if ((spec->iter * spec->dt) > (spec->dx[0] * (spec->n_move + 1)))
-				spec->main_vector.data[i].ix--;
+	// The boundaries are applied after all the particles are pushed
+	if (part != PUSH_INTERIOR) spec_boundaries(spec, limits_y);
 
-			if ((spec->main_vector.data[i].ix < 0) || (spec->main_vector.data[i].ix >= nx0))
-			{
-				spec->main_vector.data[i].invalid = true;
-				continue;
-			}
-		} else
-		{
-			// Periodic boundaries for X axis
-			if (spec->main_vector.data[i].ix < 0) spec->main_vector.data[i].ix += nx0;
-			else if (spec->main_vector.data[i].ix >= nx0) spec->main_vector.data[i].ix -= nx0;
-		}
+	TASK_TRACE_END(part == PUSH_BAND ? TRACE_SPEC_ADVANCE_BAND : TRACE_SPEC_ADVANCE,
+			spec->region_id, spec->iter - 1, 2 * spec->main_vector.size * sizeof(t_part));
+	PERF_COUNTERS_END(PERF_SPEC_ADVANCE, spec->region_id, spec->iter - 1);
+	timer_phase_add(TIMER_PUSH, t0);
+}
 
-		// Periodic boudaries for Y axis
-		if (spec->main_vector.data[i].iy < 0) spec->main_vector.data[i].iy += nx1;
-		else if (spec->main_vector.data[i].iy >= nx1) spec->main_vector.data[i].iy -= nx1;
+void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const int limits_y[2])
+{
+	spec_push(spec, emf, current, NULL, NULL, limits_y, PUSH_ALL);
+}
 
-		//Verify if the particle is still in the correct region. If not send the particle to the correct one
-		if (iy < limits_y[0]) // Particles going to the region below
-		{
-			spec_add_to_outgoing_vector(spec->outgoing_part[0], spec->main_vector.data[i]);
-			spec->main_vector.data[i].invalid = true; // Mark the particle as invalid
+void spec_advance_interior(t_species *spec, const t_emf *emf, t_current *current,
+		const int limits_y[2])
+{
+	spec_push(spec, emf, current, NULL, NULL, limits_y, PUSH_INTERIOR);
+}
 
-		} else if (iy >= limits_y[1]) // Particles going to the region above
-		{
-			spec_add_to_outgoing_vector(spec->outgoing_part[1], spec->main_vector.data[i]);
-			spec->main_vector.data[i].invalid = true; // Mark the particle as invalid
-		}
-	}
+void spec_advance_band(t_species *spec, const t_emf *emf, t_current *current, const int limits_y[2])
+{
+	spec_push(spec, emf, current, NULL, NULL, limits_y, PUSH_BAND);
+}
 
-	if (spec->moving_window && (spec->iter * spec->dt) > (spec->dx[0] * (spec->n_move + 1)))
-	{
-		// Increase moving window counter
-		spec->n_move++;
+void spec_advance_refined(t_species *spec, const t_emf *emf, t_current *current, t_patch *patch,
+		const int limits_y[2])
+{
+	spec_push(spec, emf, current, patch, NULL, limits_y, PUSH_ALL);
+}
 
-		// Inject particles in the right edge of the simulation box
-		const int range[][2] = {{spec->nx[0] - 1, spec->nx[0]}, {limits_y[0], limits_y[1]}};
-		spec_inject_particles(&spec->main_vector, range, spec->ppc, &spec->density,
-				spec->dx, spec->n_move, spec->ufl, spec->uth);
-	}
+void spec_advance_envelope(t_species *spec, const t_emf *emf, t_current *current,
+		t_envelope *envelope, const int limits_y[2])
+{
+	spec_push(spec, emf, current, NULL, envelope, limits_y, PUSH_ALL);
 }
 
 /*********************************************************************************************
@@ -815,18 +1435,18 @@ void spec_deposit_charge(const t_species *spec, t_part_data *charge)
 
 // Save the deposit particle charge in ZDF file
 void spec_rep_charge(t_part_data *restrict charge, const int true_nx[2], const t_fld box[2],
-		const int iter_num, const float dt, const bool moving_window, const char path[128])
+		const int iter_num, const float dt, const bool periodic[2], const char path[128])
 {
 	size_t buf_size = true_nx[0] * true_nx[1] * sizeof(t_part_data);
 	t_part_data *restrict buf = malloc(buf_size);
 
 	// Correct boundary values
 	// x
-	if (!moving_window) for (int j = 0; j < true_nx[1] + 1; j++)
+	if (periodic[0]) for (int j = 0; j < true_nx[1] + 1; j++)
 		charge[0 + j * (true_nx[0] + 1)] += charge[true_nx[0] + j * (true_nx[0] + 1)];
 
 	// y - Periodic boundaries
-	for (int i = 0; i < true_nx[0] + 1; i++)
+	if (periodic[1]) for (int i = 0; i < true_nx[0] + 1; i++)
 		charge[i] += charge[i + true_nx[1] * (true_nx[0] + 1)];
 
 	t_part_data *restrict b = buf;
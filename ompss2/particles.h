@@ -18,6 +18,10 @@
 #include "zpic.h"
 #include "emf.h"
 #include "current.h"
+#include "density.h"
+#include "patch.h"
+#include "envelope.h"
+#include "task_priority.h"
 
 #define MAX_SPNAME_LEN 32
 #define LTRIM(x) (x >= 1.0f) - (x < 0.0f)
@@ -32,17 +36,6 @@ typedef struct {
 
 } t_part;
 
-enum density_type {
-	UNIFORM, STEP, SLAB
-};
-
-typedef struct {
-	float n;				// reference density (defaults to 1.0, multiplies density profile)
-	enum density_type type;		// Density profile type
-	float start, end;		// Position of the plasma start/end, in simulation units
-
-} t_density;
-
 // Particle data buffer
 typedef struct {
 	t_part *data;
@@ -50,13 +43,33 @@ typedef struct {
 	int size_max;
 } t_part_vector;
 
+// Number of buffers in the queue of particles between two regions. A region can only be one time
+// step ahead of its neighbours (its field solver waits for their current), so at most 2 buffers
+// are in use
+#define PART_QUEUE_SIZE 4
+
+// Lock-free queue (single producer, single consumer) of the particles sent by a neighbouring
+// region. The particle advance of the neighbour fills the buffer at the tail and publishes it,
+// the merge of this region takes the buffers from the head
+typedef struct {
+	t_part_vector buffer[PART_QUEUE_SIZE];
+	int step[PART_QUEUE_SIZE];    // Time step in which the particles were sent
+	unsigned int head, tail;      // Accessed with atomic operations
+} t_part_queue;
+
 typedef struct {
 	char name[MAX_SPNAME_LEN];
 
 	// Particle data buffer
 	t_part_vector main_vector;
-	t_part_vector incoming_part[2];    	// Temporary buffer for incoming particles
-	t_part_vector *outgoing_part[2]; 	// Outgoing particles (0 - Below / 1 - Above)
+	t_part_queue incoming_part[2];    	// Incoming particles (0 - From below / 1 - From above)
+	t_part_queue *outgoing_part[2]; 	// Outgoing particles (0 - Below / 1 - Above)
+
+	// Particles near the edges of the region, left by spec_advance_interior to spec_advance_band
+	// (indexes in the main vector)
+	int *band_part;
+	int n_band;
+	int band_max;
 
 	// Mass over charge ratio
 	t_part_data m_q;
@@ -80,6 +93,10 @@ typedef struct {
 	t_part_data ufl[3];
 	t_part_data uth[3];
 
+	// Quiet start: the thermal momentum follows a deterministic low discrepancy set (see
+	// spec_set_u_quiet) instead of the random number generator
+	bool quiet;
+
 	// Simulation box info
 	int nx[2];
 	t_part_data dx[2];
@@ -95,6 +112,16 @@ typedef struct {
 	bool moving_window;
 	int n_move;
 
+	// Boosted frame: the plasma flows left with the velocity flow (0 = disabled) and enters the
+	// box through the last column (n_inject columns were injected so far)
+	float flow;
+	int n_inject;
+
+	// Absorbing edges of the simulation box ([x/y][lower/upper])
+	bool absorbing[2][2];
+
+	// Region that owns the species
+	int region_id;
 
 } t_species;
 
@@ -104,7 +131,14 @@ void spec_new(t_species *spec, char name[], const t_part_data m_q, const int ppc
 		const float dt, t_density *density);
 void spec_inject_particles(t_part_vector *part_vector, const int range[][2], const int ppc[2],
 		const t_density *part_density, const t_part_data dx[2], const int n_move,
-		const t_part_data ufl[3], const t_part_data uth[3]);
+		const t_part_data ufl[3], const t_part_data uth[3], const bool quiet);
+void spec_set_x(t_part_vector *vector, const int range[][2], const int ppc[2],
+		const t_density *part_density, const t_part_data dx[2], const int n_move);
+void spec_set_u(t_part_vector *vector, const int start, const int end, const t_part_data ufl[3],
+		const t_part_data uth[3]);
+void spec_set_u_quiet(t_part_vector *vector, const int start, const int end,
+		const t_part_data ufl[3], const t_part_data uth[3], const int n_move);
+void spec_set_quiet_start(t_species *spec);
 void spec_delete(t_species *spec);
 
 // Report - General
@@ -113,15 +147,66 @@ double spec_perf(void);
 
 // Utilities
 void realloc_vector(void **restrict ptr, const int old_size, const int new_size, const size_t type_size);
+void part_queue_new(t_part_queue *queue, const int size_max);
+void part_queue_delete(t_part_queue *queue);
+t_part_vector *part_queue_stage(t_part_queue *queue);
+void part_queue_publish(t_part_queue *queue, const int step);
 
 // CPU Tasks
 #pragma oss task label("Spec Advance") \
 	in(emf->E_buf[0; emf->total_size]) in(emf->B_buf[0; emf->total_size]) \
 	inout(spec->main_vector) inout(current->J_buf[0; current->total_size]) \
-	out(*spec->outgoing_part[0]) out(*spec->outgoing_part[1]) priority(5)
+	priority(task_priority[TRACE_SPEC_ADVANCE])
 void spec_advance(t_species *spec, const t_emf *emf, t_current *current, const int limits_y[2]);
 
-#pragma oss task in(spec->incoming_part[0:1]) inout(spec->main_vector) label("Spec Merge Vectors")
+// Particle advance split in two tasks. spec_advance_interior only pushes the particles whose
+// interpolation and deposition stencils stay in the interior rows of the region (the rows that
+// are not exchanged with the neighbouring regions), so it only waits for the field solver of this
+// region and overlaps the halo exchanges of the previous time step. spec_advance_band pushes the
+// remaining particles and applies the boundary conditions to all of them
+#pragma oss task label("Spec Advance Interior") \
+	in(emf->E_buf[emf->overlap; emf->nx[1] * emf->nrow - emf->overlap]) \
+	in(emf->B_buf[emf->overlap; emf->nx[1] * emf->nrow - emf->overlap]) \
+	inout(current->J_buf[current->overlap_zone; \
+			current->nx[1] * current->nrow - current->overlap_zone]) \
+	inout(spec->main_vector) \
+	priority(task_priority[TRACE_SPEC_ADVANCE])
+void spec_advance_interior(t_species *spec, const t_emf *emf, t_current *current,
+		const int limits_y[2]);
+
+#pragma oss task label("Spec Advance Band") \
+	in(emf->E_buf[0; emf->total_size]) in(emf->B_buf[0; emf->total_size]) \
+	inout(spec->main_vector) inout(current->J_buf[0; current->total_size]) \
+	priority(task_priority[TRACE_SPEC_ADVANCE_BAND])
+void spec_advance_band(t_species *spec, const t_emf *emf, t_current *current, const int limits_y[2]);
+
+// The interior rows must hold at least one row of particles
+#define SPEC_SPLIT_ADVANCE(emf) ((emf)->nx[1] > 2 * ((emf)->gc[1][0] + (emf)->gc[1][1]))
+
+// Same as spec_advance, for the regions with a part of the fine grid of the mesh refinement
+#pragma oss task label("Spec Advance") \
+	in(emf->E_buf[0; emf->total_size]) in(emf->B_buf[0; emf->total_size]) \
+	in(patch->emf.E_buf[0; patch->emf.total_size]) in(patch->emf.B_buf[0; patch->emf.total_size]) \
+	inout(spec->main_vector) inout(current->J_buf[0; current->total_size]) \
+	inout(patch->current.J_buf[0; patch->current.total_size]) \
+	priority(task_priority[TRACE_SPEC_ADVANCE])
+void spec_advance_refined(t_species *spec, const t_emf *emf, t_current *current, t_patch *patch,
+		const int limits_y[2]);
+
+// Same as spec_advance, with the laser envelope (ponderomotive force and susceptibility)
+#pragma oss task label("Spec Advance") \
+	in(emf->E_buf[0; emf->total_size]) in(emf->B_buf[0; emf->total_size]) \
+	in(envelope->a2_buf[0; envelope->total_size]) \
+	inout(spec->main_vector) inout(current->J_buf[0; current->total_size]) \
+	inout(envelope->chi_buf[0; envelope->total_size]) \
+	priority(task_priority[TRACE_SPEC_ADVANCE])
+void spec_advance_envelope(t_species *spec, const t_emf *emf, t_current *current,
+		t_envelope *envelope, const int limits_y[2]);
+
+// The incoming particles are taken from the queues without dependencies: the particles that the
+// neighbours have not sent yet (in this time step) are added by the next particle advance
+#pragma oss task inout(spec->main_vector) label("Spec Merge Vectors") \
+priority(task_priority[TRACE_SPEC_MERGE])
 void spec_merge_vectors(t_species *spec);
 
 /*********************************************************************************************
@@ -148,7 +233,7 @@ void spec_rep_pha(const t_part_data *buffer, const int rep_type, const int pha_n
 // Charge map
 void spec_deposit_charge(const t_species *spec, float *charge);
 void spec_rep_charge(t_part_data *restrict charge, const int true_nx[2], const t_fld box[2],
-		const int iter_num, const float dt, const bool moving_window, const char path[128]);
+		const int iter_num, const float dt, const bool periodic[2], const char path[128]);
 
 // Energy
 void spec_calculate_energy(t_species *spec);
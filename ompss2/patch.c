@@ -0,0 +1,424 @@
+/*********************************************************************************************
+ ZPIC
+ patch.c
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#include "patch.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "timer.h"
+#include "perf_counters.h"
+#include "task_trace.h"
+
+// Position of the field components inside the cell (Yee mesh)
+static const float stagger_E[3][2] = { { 0.5f, 0.0f }, { 0.0f, 0.5f }, { 0.0f, 0.0f } };
+static const float stagger_B[3][2] = { { 0.0f, 0.5f }, { 0.5f, 0.0f }, { 0.5f, 0.5f } };
+
+/*********************************************************************************************
+ Constructor / Destructor
+ *********************************************************************************************/
+
+// Cells of the patch [start, end) in the coarse grid
+void patch_cells(const t_mesh_refinement *mr, const t_fld dx[2], int start[2], int end[2])
+{
+	for (int d = 0; d < 2; d++)
+	{
+		start[d] = floorf(mr->start[d] / dx[d]);
+		end[d] = ceilf(mr->end[d] / dx[d]);
+	}
+}
+
+// Rows of the fine grid (patch and ring) inside the region, in coarse cells
+static void patch_rows(const t_mesh_refinement *mr, const t_fld dx[2], const int limits_y[2],
+		int rows[2])
+{
+	int start[2], end[2];
+	patch_cells(mr, dx, start, end);
+
+	rows[0] = start[1] - PATCH_RING > limits_y[0] ? start[1] - PATCH_RING : limits_y[0];
+	rows[1] = end[1] + PATCH_RING < limits_y[1] ? end[1] + PATCH_RING : limits_y[1];
+}
+
+// The region has a part of the fine grid
+bool patch_overlaps(const t_mesh_refinement *mr, const t_fld dx[2], const int limits_y[2])
+{
+	int rows[2];
+	patch_rows(mr, dx, limits_y, rows);
+	return rows[1] > rows[0];
+}
+
+static inline t_fld fld_comp(const t_vfld *f, const int c)
+{
+	return c == 0 ? f->x : (c == 1 ? f->y : f->z);
+}
+
+static inline void set_fld_comp(t_vfld *f, const int c, const t_fld value)
+{
+	if (c == 0) f->x = value;
+	else if (c == 1) f->y = value;
+	else f->z = value;
+}
+
+// Interpolation of the component c of the coarse field F (same layout as the coarse fields):
+// cubic along x and linear along y (the rows of the neighbouring regions are not available). Near
+// the edges of the buffer, it is linear along x too. The position (x, y) is given in coarse cells,
+// relative to the position of the component in the cell [0][0]
+static t_fld coarse_interpolate(const t_vfld *restrict F, const t_emf *coarse, const int c,
+		const float x, const float y)
+{
+	const int nrow = coarse->nrow;
+	const int i = floorf(x);
+	const int j = floorf(y);
+	const float wx = x - i;
+	const float wy = y - j;
+
+	float w[4] = { 0.0f, 1.0f - wx, wx, 0.0f };
+	if (i - 1 >= -coarse->gc[0][0] && i + 2 < coarse->nx[0] + coarse->gc[0][1])
+	{
+		w[0] = -wx * (wx - 1.0f) * (wx - 2.0f) / 6.0f;
+		w[1] = (wx + 1.0f) * (wx - 1.0f) * (wx - 2.0f) / 2.0f;
+		w[2] = -(wx + 1.0f) * wx * (wx - 2.0f) / 2.0f;
+		w[3] = (wx + 1.0f) * wx * (wx - 1.0f) / 6.0f;
+	}
+
+	t_fld value = 0;
+	for (int a = 0; a < 4; a++)
+	{
+		if (w[a] == 0.0f) continue;
+		value += w[a] * (fld_comp(&F[i - 1 + a + j * nrow], c) * (1.0f - wy)
+				+ fld_comp(&F[i - 1 + a + (j + 1) * nrow], c) * wy);
+	}
+
+	return value;
+}
+
+// Restriction of the component c of the fine field F to the coarse cell (i, j) of the coarse
+// patch: the average of the r fine values inside the coarse cell along the directions where the
+// component is staggered, and the fine value at the coarse node along the others
+static t_fld fine_restrict(const t_vfld *restrict F, const int nrow, const int r, const int c,
+		const float stagger[3][2], const int i, const int j)
+{
+	const int na = stagger[c][0] > 0.0f ? r : 1;
+	const int nb = stagger[c][1] > 0.0f ? r : 1;
+
+	t_fld value = 0;
+	for (int b = 0; b < nb; b++)
+		for (int a = 0; a < na; a++)
+			value += fld_comp(&F[r * i + a + (r * j + b) * nrow], c);
+
+	return value / (na * nb);
+}
+
+// Restriction of the component c of the fine current to the coarse cell (i, j): the average
+// along the staggered directions and the linear weights of the 2r - 1 fine nodes around the
+// coarse node along the others, so the restricted current conserves the charge
+static t_fld current_restrict(const t_vfld *restrict J, const int nrow, const int r, const int c,
+		const int i, const int j)
+{
+	const bool stag_x = stagger_E[c][0] > 0.0f;
+	const bool stag_y = stagger_E[c][1] > 0.0f;
+
+	t_fld value = 0;
+	for (int b = stag_y ? 0 : 1 - r; b < r; b++)
+	{
+		const t_fld wb = stag_y ? 1.0f / r : (t_fld) (r - abs(b)) / (r * r);
+
+		for (int a = stag_x ? 0 : 1 - r; a < r; a++)
+		{
+			const t_fld wa = stag_x ? 1.0f / r : (t_fld) (r - abs(a)) / (r * r);
+			value += wa * wb * fld_comp(&J[r * i + a + (r * j + b) * nrow], c);
+		}
+	}
+
+	return value;
+}
+
+static inline int floor_div(const int i, const int r)
+{
+	return i >= 0 ? i / r : -((r - 1 - i) / r);
+}
+
+// Set the fine fields from the coarse ones, interpolated at the time t_n + tau * dt. With
+// ring_only, only the cells of the ring (and the guard cells outside the patch) are set. If the
+// window moved in this time step, the fine grid is still in the old frame and the coarse fields
+// at t_n+1 are shifted by one cell
+static void patch_fill(t_patch *patch, const t_emf *coarse, const float tau, const int shift,
+		const bool ring_only)
+{
+	const int r = patch->ratio;
+	const int nrow = patch->emf.nrow;
+
+	t_vfld *restrict const E = patch->emf.E;
+	t_vfld *restrict const B = patch->emf.B;
+
+	for (int j = -patch->emf.gc[1][0]; j < patch->emf.nx[1] + patch->emf.gc[1][1]; j++)
+	{
+		const int cy = patch->origin[1] + floor_div(j, r);
+		const bool ring_row = cy < patch->start[1] || cy >= patch->end[1];
+
+		for (int i = -patch->emf.gc[0][0]; i < patch->emf.nx[0] + patch->emf.gc[0][1]; i++)
+		{
+			const int cx = patch->origin[0] + floor_div(i, r);
+			if (ring_only && !ring_row && cx >= patch->start[0] && cx < patch->end[0]) continue;
+
+			for (int c = 0; c < 3; c++)
+			{
+				// E component
+				float x = patch->origin[0] + (i + stagger_E[c][0]) / r - stagger_E[c][0];
+				float y = patch->origin[1] - patch->offset_y + (j + stagger_E[c][1]) / r
+						- stagger_E[c][1];
+
+				t_fld value = 0;
+				if (tau < 1.0f)
+					value += (1.0f - tau) * coarse_interpolate(patch->E_old, coarse, c, x, y);
+				if (tau > 0.0f)
+					value += tau * coarse_interpolate(coarse->E, coarse, c, x - shift, y);
+				set_fld_comp(&E[i + j * nrow], c, value);
+
+				// B component
+				x = patch->origin[0] + (i + stagger_B[c][0]) / r - stagger_B[c][0];
+				y = patch->origin[1] - patch->offset_y + (j + stagger_B[c][1]) / r - stagger_B[c][1];
+
+				value = 0;
+				if (tau < 1.0f)
+					value += (1.0f - tau) * coarse_interpolate(patch->B_old, coarse, c, x, y);
+				if (tau > 0.0f)
+					value += tau * coarse_interpolate(coarse->B, coarse, c, x - shift, y);
+				set_fld_comp(&B[i + j * nrow], c, value);
+			}
+		}
+	}
+}
+
+// Store the coarse fields of the current time step
+static void patch_save_coarse(t_patch *patch, const t_emf *coarse)
+{
+	memcpy(patch->E_old_buf, coarse->E_buf, coarse->total_size * sizeof(t_vfld));
+	memcpy(patch->B_old_buf, coarse->B_buf, coarse->total_size * sizeof(t_vfld));
+	patch->n_move = coarse->n_move;
+}
+
+// Create the part of the fine grid inside the region (the fields are interpolated from the
+// coarse grid)
+void patch_new(t_patch *patch, const t_mesh_refinement *mr, const t_emf *coarse,
+		const int limits_y[2])
+{
+	const int r = mr->ratio;
+	int rows[2];
+
+	patch->ratio = r;
+	patch_cells(mr, coarse->dx, patch->start, patch->end);
+	patch_rows(mr, coarse->dx, limits_y, rows);
+
+	patch->origin[0] = patch->start[0] - PATCH_RING;
+	patch->origin[1] = rows[0];
+	patch->offset_y = limits_y[0];
+
+	int nx[2] = { r * (patch->end[0] - patch->start[0] + 2 * PATCH_RING), r * (rows[1] - rows[0]) };
+	t_fld box[2] = { nx[0] * coarse->dx[0] / r, nx[1] * coarse->dx[1] / r };
+
+	// The particles of the region can move one coarse cell (r fine cells) outside it
+	const int gc[2][2] = { { 1, 2 }, { r, r + 1 } };
+
+	emf_new(&patch->emf, nx, box, coarse->dt / r);
+	current_new_gc(&patch->current, nx, gc, box, coarse->dt);
+
+	int nx_c[2] = { nx[0] / r, nx[1] / r };
+	emf_new(&patch->coarse_emf, nx_c, box, coarse->dt);
+	current_new(&patch->coarse_current, nx_c, box, coarse->dt);
+
+	patch->region_id = coarse->region_id;
+	patch->emf.region_id = coarse->region_id;
+	patch->current.region_id = coarse->region_id;
+	patch->coarse_emf.region_id = coarse->region_id;
+	patch->emf.iter = coarse->iter;
+	patch->current.iter = coarse->iter;
+	patch->has_below = false;
+
+	patch->E_old_buf = malloc(coarse->total_size * sizeof(t_vfld));
+	patch->B_old_buf = malloc(coarse->total_size * sizeof(t_vfld));
+	assert(patch->E_old_buf && patch->B_old_buf);
+
+	patch->E_old = patch->E_old_buf + (coarse->E - coarse->E_buf);
+	patch->B_old = patch->B_old_buf + (coarse->B - coarse->B_buf);
+
+	patch_save_coarse(patch, coarse);
+	patch_fill(patch, coarse, 0.0f, 0, false);
+}
+
+void patch_delete(t_patch *patch)
+{
+	emf_delete(&patch->emf);
+	current_delete(&patch->current);
+	emf_delete(&patch->coarse_emf);
+	current_delete(&patch->coarse_current);
+
+	free(patch->E_old_buf);
+	free(patch->B_old_buf);
+	patch->E_old_buf = NULL;
+	patch->B_old_buf = NULL;
+}
+
+// Link the fine grid with the part in the region below
+void patch_overlap_zone(t_patch *patch, t_patch *below)
+{
+	emf_overlap_zone(&patch->emf, &below->emf);
+	current_overlap_zone(&patch->current, &below->current);
+	patch->has_below = true;
+}
+
+/*********************************************************************************************
+ Field solver
+ *********************************************************************************************/
+
+// Shift the fine fields left (the new cells are in the ring)
+static void patch_move_window(t_patch *patch, const int shift)
+{
+	const int n = shift * patch->ratio;
+	const int nrow = patch->emf.nrow;
+	const int i1 = patch->emf.nx[0] + patch->emf.gc[0][1];
+
+	t_vfld *restrict const E = patch->emf.E;
+	t_vfld *restrict const B = patch->emf.B;
+	const t_vfld zero_fld = { 0., 0., 0. };
+
+	for (int j = -patch->emf.gc[1][0]; j < patch->emf.nx[1] + patch->emf.gc[1][1]; j++)
+	{
+		for (int i = -patch->emf.gc[0][0]; i < i1 - n; i++)
+		{
+			E[i + j * nrow] = E[i + n + j * nrow];
+			B[i + j * nrow] = B[i + n + j * nrow];
+		}
+
+		for (int i = i1 - n; i < i1; i++)
+		{
+			E[i + j * nrow] = zero_fld;
+			B[i + j * nrow] = zero_fld;
+		}
+	}
+}
+
+// Two-way coupling: advance the coarse patch from the coarse fields at t_n (old frame) with the
+// restricted fine current, and correct the coarse fields at t_n+1 inside the patch (only the rows
+// of the region) with the restricted fine fields minus the coarse patch fields. If the window
+// moved in this time step, the coarse fields at t_n+1 are shifted by one cell
+static void patch_correct_coarse(t_patch *patch, t_emf *coarse, const int shift)
+{
+	const int r = patch->ratio;
+	const int nrow = coarse->nrow;
+	const int nrow_f = patch->emf.nrow;
+	const int x0 = patch->origin[0];
+	const int y0 = patch->origin[1] - patch->offset_y;
+
+	t_emf *const cpatch = &patch->coarse_emf;
+	t_current *const cpatch_current = &patch->coarse_current;
+	const int nrow_c = cpatch->nrow;
+
+	for (int j = -cpatch->gc[1][0]; j < cpatch->nx[1] + cpatch->gc[1][1]; j++)
+	{
+		for (int i = -cpatch->gc[0][0]; i < cpatch->nx[0] + cpatch->gc[0][1]; i++)
+		{
+			cpatch->E[i + j * nrow_c] = patch->E_old[x0 + i + (y0 + j) * nrow];
+			cpatch->B[i + j * nrow_c] = patch->B_old[x0 + i + (y0 + j) * nrow];
+		}
+	}
+
+	// The fine current of the outer ring cells is incomplete and left out (it only changes the
+	// coarse patch fields in the ring)
+	memset(cpatch_current->J_buf, 0, cpatch_current->total_size * sizeof(t_vfld));
+
+	for (int j = 0; j < cpatch->nx[1]; j++)
+		for (int i = 1; i < cpatch->nx[0] - 1; i++)
+			for (int c = 0; c < 3; c++)
+				set_fld_comp(&cpatch_current->J[i + j * cpatch_current->nrow], c,
+						current_restrict(patch->current.J, patch->current.nrow, r, c, i, j));
+
+	yee_b(cpatch, cpatch->dt / 2.0f);
+	yee_e(cpatch, cpatch_current, cpatch->dt);
+	yee_b(cpatch, cpatch->dt / 2.0f);
+
+	for (int j = 0; j < cpatch->nx[1]; j++)
+	{
+		const int cy = patch->origin[1] + j;
+		if (cy < patch->start[1] || cy >= patch->end[1]) continue;
+
+		for (int i = PATCH_RING; i < cpatch->nx[0] - PATCH_RING; i++)
+		{
+			t_vfld *const E = &coarse->E[x0 + i - shift + (y0 + j) * nrow];
+			t_vfld *const B = &coarse->B[x0 + i - shift + (y0 + j) * nrow];
+
+			for (int c = 0; c < 3; c++)
+			{
+				set_fld_comp(E, c, fld_comp(E, c) + fine_restrict(patch->emf.E, nrow_f, r, c,
+						stagger_E, i, j) - fld_comp(&cpatch->E[i + j * nrow_c], c));
+				set_fld_comp(B, c, fld_comp(B, c) + fine_restrict(patch->emf.B, nrow_f, r, c,
+						stagger_B, i, j) - fld_comp(&cpatch->B[i + j * nrow_c], c));
+			}
+		}
+	}
+}
+
+// Advance the fine fields by one substep (dt / ratio), after the coarse fields were advanced
+// to t_n+1. The fine current is the average over the coarse time step. The last substep also
+// corrects the coarse fields inside the patch
+void patch_advance(t_patch *patch, t_emf *coarse, const int substep)
+{
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
+	const int r = patch->ratio;
+	const int shift = coarse->n_move - patch->n_move;
+	const float dt = patch->emf.dt;
+
+	// Fields in the ring at the beginning of the substep
+	patch_fill(patch, coarse, (float) substep / r, shift, true);
+
+	yee_b(&patch->emf, dt / 2.0f);
+	yee_e(&patch->emf, &patch->current, dt);
+	yee_b(&patch->emf, dt / 2.0f);
+
+	if (substep == r - 1)
+	{
+		patch_correct_coarse(patch, coarse, shift);
+
+		// The patch moves with the simulation window
+		if (shift > 0) patch_move_window(patch, shift);
+	}
+
+	TASK_TRACE_END(TRACE_PATCH_ADVANCE, patch->region_id, patch->emf.iter,
+			(5 * patch->emf.total_size + 4 * coarse->total_size) * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_EMF_ADVANCE, patch->region_id, patch->emf.iter);
+	timer_phase_add(TIMER_SOLVE, t0);
+
+	// Advance internal iteration number
+	if (substep == r - 1)
+	{
+		patch->emf.iter++;
+		patch->current.iter++;
+	}
+}
+
+// Store the coarse fields at t_n+1, after the correction of all the regions and the update of
+// their guard cells, and set the fine fields in the ring at t_n+1
+void patch_update_coarse(t_patch *patch, const t_emf *coarse)
+{
+	const uint64_t t0 = timer_ticks();
+	PERF_COUNTERS_BEGIN();
+	TASK_TRACE_BEGIN();
+
+	patch_fill(patch, coarse, 1.0f, 0, true);
+	patch_save_coarse(patch, coarse);
+
+	TASK_TRACE_END(TRACE_PATCH_ADVANCE, patch->region_id, patch->emf.iter - 1,
+			(2 * patch->emf.total_size + 4 * coarse->total_size) * sizeof(t_vfld));
+	PERF_COUNTERS_END(PERF_EMF_ADVANCE, patch->region_id, patch->emf.iter - 1);
+	timer_phase_add(TIMER_SOLVE, t0);
+}
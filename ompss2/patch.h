@@ -0,0 +1,128 @@
+/*********************************************************************************************
+ ZPIC
+ patch.h
+
+ Static mesh refinement: a single patch where the fields are solved in a finer grid (the same
+ refinement ratio in x, y and time). The coarse grid still covers the whole box and receives the
+ current of all particles, while the particles inside the patch are pushed with the fine fields
+ and also deposit their current in the fine grid. The fine fields in a ring around the patch are
+ interpolated (in space and time) from the coarse grid.
+
+ The coupling is two-way: after the last substep, a coarse grid over the patch and the ring (the
+ coarse patch) is advanced from the coarse fields of the previous time step with the fine current
+ restricted to it, and the coarse fields inside the patch are corrected by adding the restricted
+ fine fields and subtracting the coarse patch fields. The coarse grid then carries the fine
+ solution out of the patch, while the part of its own solution that does not come from the fine
+ current (e.g., the current filter) is kept.
+
+ Each region stores the rows of the fine grid that overlap it, so the fine grid is solved and
+ exchanged like the coarse one.
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __PATCH__
+#define __PATCH__
+
+#include <stdbool.h>
+
+#include "zpic.h"
+#include "emf.h"
+#include "current.h"
+#include "task_priority.h"
+
+// Width of the ring around the patch (coarse cells). The particles up to 2 cells away from the
+// patch deposit current in the fine grid, so the fine current inside the patch is complete
+#define PATCH_RING 3
+
+#define PATCH_MAX_RATIO 8
+
+// Refined patch, in simulation units (x is relative to the moving window, if enabled)
+typedef struct {
+	int ratio;			// Refinement ratio (0 = no refinement)
+	float start[2];		// Lower corner
+	float end[2];		// Upper corner
+} t_mesh_refinement;
+
+typedef struct {
+	int ratio;
+
+	// Patch in coarse cells [start, end) (x: moving window frame, y: global)
+	int start[2], end[2];
+
+	// Coarse cell of the fine cell [0][0]
+	int origin[2];
+
+	// First row of the region (global)
+	int offset_y;
+
+	// Fine grid over the patch and the ring (only the rows of the region)
+	t_emf emf;
+	t_current current;
+
+	// Coarse patch, over the same cells as the fine grid (two-way coupling)
+	t_emf coarse_emf;
+	t_current coarse_current;
+
+	// Coarse fields of the region in the previous time step (same layout as the region fields)
+	t_vfld *E_old_buf, *B_old_buf;
+	t_vfld *E_old, *B_old;
+
+	// Moving window counter of the coarse fields in the previous time step
+	int n_move;
+
+	// The region below also has a part of the fine grid
+	bool has_below;
+
+	// Region that owns the patch
+	int region_id;
+
+} t_patch;
+
+// Setup
+void patch_new(t_patch *patch, const t_mesh_refinement *mr, const t_emf *coarse,
+		const int limits_y[2]);
+void patch_delete(t_patch *patch);
+void patch_overlap_zone(t_patch *patch, t_patch *below);
+bool patch_overlaps(const t_mesh_refinement *mr, const t_fld dx[2], const int limits_y[2]);
+void patch_cells(const t_mesh_refinement *mr, const t_fld dx[2], int start[2], int end[2]);
+
+// CPU Tasks
+#pragma oss task inout(patch->emf.E_buf[0; patch->emf.total_size]) \
+inout(patch->emf.B_buf[0; patch->emf.total_size]) \
+in(patch->current.J_buf[0; patch->current.total_size]) \
+inout(coarse->E_buf[0; coarse->total_size]) inout(coarse->B_buf[0; coarse->total_size]) \
+in(patch->E_old_buf[0; coarse->total_size]) in(patch->B_old_buf[0; coarse->total_size]) \
+inout(patch->coarse_emf.E_buf[0; patch->coarse_emf.total_size]) \
+inout(patch->coarse_emf.B_buf[0; patch->coarse_emf.total_size]) \
+inout(patch->coarse_current.J_buf[0; patch->coarse_current.total_size]) \
+label("Patch Advance") priority(task_priority[TRACE_PATCH_ADVANCE])
+void patch_advance(t_patch *patch, t_emf *coarse, const int substep);
+
+#pragma oss task inout(patch->emf.E_buf[0; patch->emf.total_size]) \
+inout(patch->emf.B_buf[0; patch->emf.total_size]) \
+in(coarse->E_buf[0; coarse->total_size]) in(coarse->B_buf[0; coarse->total_size]) \
+out(patch->E_old_buf[0; coarse->total_size]) out(patch->B_old_buf[0; coarse->total_size]) \
+label("Patch Update") priority(task_priority[TRACE_PATCH_ADVANCE])
+void patch_update_coarse(t_patch *patch, const t_emf *coarse);
+
+/*********************************************************************************************
+ Particles
+ *********************************************************************************************/
+
+// The particle is pushed with the fine fields
+static inline bool patch_gather_zone(const t_patch *patch, const int ix, const int iy)
+{
+	return ix >= patch->start[0] && ix < patch->end[0] && iy >= patch->start[1]
+			&& iy < patch->end[1];
+}
+
+// The particle deposits current in the fine grid
+static inline bool patch_deposit_zone(const t_patch *patch, const int ix, const int iy)
+{
+	return ix >= patch->start[0] - 2 && ix < patch->end[0] + 2 && iy >= patch->start[1] - 2
+			&& iy < patch->end[1] + 2;
+}
+
+#endif
@@ -0,0 +1,256 @@
+/*********************************************************************************************
+ ZPIC
+ perf_counters.c
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifdef ENABLE_PERF_COUNTERS
+
+#define _GNU_SOURCE
+
+#include "perf_counters.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "timer.h"
+
+static const char *phase_names[PERF_N_PHASES] = {
+	"spec_advance", "emf_advance", "envelope_advance", "current_filter", "merge", "exchange",
+	"diagnostics"
+};
+
+static const char *event_names[PERF_N_EVENTS] = {
+	"cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses"
+};
+
+// Accumulated values (time + events), per region / phase and per step / phase
+typedef uint64_t t_perf_values[PERF_N_EVENTS + 1];
+
+static t_perf_values *perf_regions = NULL;   // [n_regions + 1][PERF_N_PHASES]
+static t_perf_values *perf_steps = NULL;     // [n_steps][PERF_N_PHASES]
+static int perf_n_regions = 0;
+static int perf_n_steps = 0;
+
+// Each worker thread opens its own set of counters (measuring only the calling thread)
+static __thread bool thread_init = false;
+static __thread int thread_fd[PERF_N_EVENTS];
+
+/*********************************************************************************************
+ Counters
+ *********************************************************************************************/
+
+static int open_event(const uint32_t type, const uint64_t config)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(struct perf_event_attr));
+
+	attr.size = sizeof(struct perf_event_attr);
+	attr.type = type;
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void open_thread_counters(void)
+{
+	thread_fd[PERF_CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	thread_fd[PERF_INSTRUCTIONS] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	thread_fd[PERF_L1D_MISSES] = open_event(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+			| (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	thread_fd[PERF_LLC_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	thread_fd[PERF_DTLB_MISSES] = open_event(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+			| (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+
+	// Unsupported events (e.g., virtual machines or restricted perf_event_paranoid) will read as 0
+	for (int e = 0; e < PERF_N_EVENTS; e++)
+		if (thread_fd[e] < 0)
+			fprintf(stderr, "Warning: Hardware counter %s is not available\n", event_names[e]);
+
+	thread_init = true;
+}
+
+void perf_counters_begin(t_perf_sample *start)
+{
+	if (!thread_init) open_thread_counters();
+
+	for (int e = 0; e < PERF_N_EVENTS; e++)
+		if (thread_fd[e] < 0 || read(thread_fd[e], &start->events[e], sizeof(uint64_t)) != sizeof(uint64_t))
+			start->events[e] = 0;
+
+	start->time = timer_ticks();
+}
+
+void perf_counters_end(const t_perf_sample *start, const enum perf_phase phase, const int region,
+		const int step)
+{
+	t_perf_sample end;
+
+	end.time = timer_ticks();
+	for (int e = 0; e < PERF_N_EVENTS; e++)
+		if (thread_fd[e] < 0 || read(thread_fd[e], &end.events[e], sizeof(uint64_t)) != sizeof(uint64_t))
+			end.events[e] = start->events[e];
+
+	const int region_idx = region == PERF_GLOBAL ? perf_n_regions : region;
+	uint64_t *restrict region_values = perf_regions[region_idx * PERF_N_PHASES + phase];
+	uint64_t *restrict step_values = NULL;
+	if (step >= 0 && step < perf_n_steps) step_values = perf_steps[step * PERF_N_PHASES + phase];
+
+	// Tasks from different regions may end concurrently
+	__atomic_fetch_add(&region_values[0], end.time - start->time, __ATOMIC_RELAXED);
+	if (step_values) __atomic_fetch_add(&step_values[0], end.time - start->time, __ATOMIC_RELAXED);
+
+	for (int e = 0; e < PERF_N_EVENTS; e++)
+	{
+		uint64_t delta = end.events[e] - start->events[e];
+		__atomic_fetch_add(&region_values[e + 1], delta, __ATOMIC_RELAXED);
+		if (step_values) __atomic_fetch_add(&step_values[e + 1], delta, __ATOMIC_RELAXED);
+	}
+}
+
+/*********************************************************************************************
+ Setup
+ *********************************************************************************************/
+
+void perf_counters_init(const int n_regions, const int n_steps)
+{
+	perf_n_regions = n_regions;
+	perf_n_steps = n_steps;
+
+	perf_regions = calloc((n_regions + 1) * PERF_N_PHASES, sizeof(t_perf_values));
+	perf_steps = calloc(n_steps * PERF_N_PHASES, sizeof(t_perf_values));
+
+	if (!perf_regions || !perf_steps)
+	{
+		fprintf(stderr, "Error allocating the performance counters. Exiting...\n");
+		exit(1);
+	}
+}
+
+void perf_counters_finalize(void)
+{
+	free(perf_regions);
+	free(perf_steps);
+	perf_regions = NULL;
+	perf_steps = NULL;
+
+	// Only the counters of the calling thread can be closed here
+	if (thread_init)
+	{
+		for (int e = 0; e < PERF_N_EVENTS; e++)
+			if (thread_fd[e] >= 0) close(thread_fd[e]);
+		thread_init = false;
+	}
+}
+
+/*********************************************************************************************
+ Report
+ *********************************************************************************************/
+
+// Print the counters of each phase (all regions) with the derived metrics
+void perf_counters_report(void)
+{
+	fprintf(stdout, "\nHardware counters (all regions):\n");
+	fprintf(stdout, "%-16s %12s %14s %14s %6s %12s %12s %12s %10s\n", "phase", "time [s]",
+			"cycles", "instructions", "IPC", "L1D misses", "LLC misses", "DTLB misses", "GB/s");
+
+	for (int p = 0; p < PERF_N_PHASES; p++)
+	{
+		t_perf_values total = { 0 };
+
+		for (int r = 0; r <= perf_n_regions; r++)
+			for (int e = 0; e <= PERF_N_EVENTS; e++)
+				total[e] += perf_regions[r * PERF_N_PHASES + p][e];
+
+		if (total[0] == 0) continue;
+
+		const double time = total[0] * 1.0e-9;
+		const double ipc = total[PERF_CYCLES + 1] > 0 ?
+				(double) total[PERF_INSTRUCTIONS + 1] / total[PERF_CYCLES + 1] : 0;
+		const double bandwidth = (double) total[PERF_LLC_MISSES + 1] * PERF_CACHE_LINE / time / 1.0e9;
+
+		fprintf(stdout, "%-16s %12.6f %14" PRIu64 " %14" PRIu64 " %6.2f %12" PRIu64 " %12" PRIu64
+				" %12" PRIu64 " %10.3f\n", phase_names[p], time, total[PERF_CYCLES + 1],
+				total[PERF_INSTRUCTIONS + 1], ipc,
+				total[PERF_L1D_MISSES + 1], total[PERF_LLC_MISSES + 1], total[PERF_DTLB_MISSES + 1],
+				bandwidth);
+	}
+
+	fprintf(stdout, "Time is accumulated over all workers. Bandwidth estimated from the LLC misses.\n");
+}
+
+static void write_values(FILE *file, const uint64_t *values)
+{
+	fprintf(file, "%" PRIu64, values[0]);
+	for (int e = 0; e < PERF_N_EVENTS; e++)
+		fprintf(file, ";%" PRIu64, values[e + 1]);
+	fprintf(file, ";%" PRIu64 "\n", values[PERF_LLC_MISSES + 1] * PERF_CACHE_LINE);
+}
+
+static void write_header(FILE *file, const char *first_column)
+{
+	fprintf(file, "%s;phase;time_ns", first_column);
+	for (int e = 0; e < PERF_N_EVENTS; e++)
+		fprintf(file, ";%s", event_names[e]);
+	fprintf(file, ";bytes\n");
+}
+
+// Save the counters per step and per region (output/<sim_name>/perf_*.csv)
+void perf_counters_save_csv(const char sim_name[64])
+{
+	char filename[128];
+	FILE *file;
+
+	sprintf(filename, "output/%s/perf_steps.csv", sim_name);
+	file = fopen(filename, "w");
+	if (!file)
+	{
+		printf("Error on open file: %s", filename);
+		exit(1);
+	}
+
+	write_header(file, "step");
+	for (int s = 0; s < perf_n_steps; s++)
+	{
+		for (int p = 0; p < PERF_N_PHASES; p++)
+		{
+			if (perf_steps[s * PERF_N_PHASES + p][0] == 0) continue;
+			fprintf(file, "%d;%s;", s, phase_names[p]);
+			write_values(file, perf_steps[s * PERF_N_PHASES + p]);
+		}
+	}
+	fclose(file);
+
+	sprintf(filename, "output/%s/perf_regions.csv", sim_name);
+	file = fopen(filename, "w");
+	if (!file)
+	{
+		printf("Error on open file: %s", filename);
+		exit(1);
+	}
+
+	write_header(file, "region");
+	for (int r = 0; r <= perf_n_regions; r++)
+	{
+		for (int p = 0; p < PERF_N_PHASES; p++)
+		{
+			if (perf_regions[r * PERF_N_PHASES + p][0] == 0) continue;
+			if (r == perf_n_regions) fprintf(file, "global;%s;", phase_names[p]);
+			else fprintf(file, "%d;%s;", r, phase_names[p]);
+			write_values(file, perf_regions[r * PERF_N_PHASES + p]);
+		}
+	}
+	fclose(file);
+}
+
+#endif
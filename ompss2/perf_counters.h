@@ -0,0 +1,60 @@
+/*********************************************************************************************
+ ZPIC
+ perf_counters.h
+
+ Hardware performance counters (Linux perf_event_open) for the main simulation phases.
+ Compile with -DENABLE_PERF_COUNTERS to enable it, otherwise the macros below are empty.
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __PERF_COUNTERS__
+#define __PERF_COUNTERS__
+
+#include <stdint.h>
+
+enum perf_phase {
+	PERF_SPEC_ADVANCE, PERF_EMF_ADVANCE, PERF_ENVELOPE_ADVANCE, PERF_CURRENT_FILTER, PERF_MERGE,
+	PERF_EXCHANGE, PERF_DIAGNOSTICS, PERF_N_PHASES
+};
+
+enum perf_event {
+	PERF_CYCLES, PERF_INSTRUCTIONS, PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_DTLB_MISSES,
+	PERF_N_EVENTS
+};
+
+// Region id for the work that is not associated with any region (e.g., diagnostics)
+#define PERF_GLOBAL -1
+
+// Bytes transferred from the main memory are estimated from the LLC misses
+#define PERF_CACHE_LINE 64
+
+typedef struct {
+	uint64_t time;   // Nanoseconds
+	uint64_t events[PERF_N_EVENTS];
+} t_perf_sample;
+
+#ifdef ENABLE_PERF_COUNTERS
+
+void perf_counters_init(const int n_regions, const int n_steps);
+void perf_counters_finalize(void);
+
+void perf_counters_begin(t_perf_sample *start);
+void perf_counters_end(const t_perf_sample *start, const enum perf_phase phase, const int region,
+		const int step);
+
+void perf_counters_report(void);
+void perf_counters_save_csv(const char sim_name[64]);
+
+#define PERF_COUNTERS_BEGIN() t_perf_sample _perf_start; perf_counters_begin(&_perf_start)
+#define PERF_COUNTERS_END(phase, region, step) perf_counters_end(&_perf_start, phase, region, step)
+
+#else
+
+#define PERF_COUNTERS_BEGIN()
+#define PERF_COUNTERS_END(phase, region, step)
+
+#endif
+
+#endif
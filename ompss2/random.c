@@ -15,10 +15,15 @@ uint32_t m_z = 67890; /* must not be zero */
 
 int iset = 1;
 
+// Second value of the Box-Muller method (stored for the next call of rand_norm)
+static int norm_iset = 0;
+static double norm_gset = 0.0;
+
 void set_rand_seed(uint32_t m_w_, uint32_t m_z_)
 {
 	m_w = m_w_;
 	m_z = m_z_;
+	norm_iset = 0;
 }
 
 uint32_t rand_uint32(void)
@@ -30,13 +35,10 @@ uint32_t rand_uint32(void)
 
 double rand_norm(void)
 {
-	static int iset = 0;
-	static double gset = 0.0;
-
-	if (iset)
+	if (norm_iset)
 	{
-		iset = 0;
-		return gset;
+		norm_iset = 0;
+		return norm_gset;
 	} else
 	{
 		double v1, v2, rsq, fac;
@@ -59,10 +61,40 @@ double rand_norm(void)
 		fac = sqrt(-2.0 * log(rsq) / rsq);
 
 		// store 1 value for future use
-		gset = v1 * fac;
-		iset = 1;
+		norm_gset = v1 * fac;
+		norm_iset = 1;
 
 		return v2 * fac;
 	}
 
 }
+
+// Integer hash (avalanche of the bits of x), gives a well mixed number for each key
+uint32_t rand_hash(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return x;
+}
+
+// Radical inverse of n in the given base (the digits of n mirrored around the decimal point),
+// i.e., the n-th point of the van der Corput sequence. Halton sequences use a prime base per
+// dimension
+double rand_radical_inverse(uint32_t n, const uint32_t base)
+{
+	const double inv_base = 1.0 / base;
+	double f = inv_base;
+	double r = 0.0;
+
+	while (n > 0)
+	{
+		r += f * (n % base);
+		n /= base;
+		f *= inv_base;
+	}
+
+	return r;
+}
@@ -17,4 +17,8 @@ void set_rand_seed(uint32_t m_z_, uint32_t m_w_);
 double rand_norm(void);
 uint32_t rand_uint32(void);
 
+// Counter based (deterministic) numbers
+uint32_t rand_hash(uint32_t x);
+double rand_radical_inverse(uint32_t n, const uint32_t base);
+
 #endif
@@ -35,54 +35,17 @@ void region_new(t_region *region, int n_regions, int nx[2], int id, int n_spec,
 	region->nx[0] = nx[0];
 	region->nx[1] = region->limits_y[1] - region->limits_y[0];
 
-	// Initialise the particles inside the region
-	t_part_vector *restrict particles;
-
+	// Initialise the species (the particles are loaded by region_load_particles)
 	region->n_species = n_spec;
 	region->species = (t_species*) malloc(n_spec * sizeof(t_species));
 	assert(region->species);
 
-	int start, end;
 	for (int n = 0; n < n_spec; ++n)
 	{
 		spec_new(&region->species[n], spec[n].name, spec[n].m_q, spec[n].ppc, spec[n].ufl,
 				spec[n].uth, spec[n].nx, spec[n].box, spec[n].dt, &spec[n].density);
-
-		particles = &region->species[n].main_vector;
-
-		const int ppc = region->species[n].ppc[1] * region->species[n].ppc[0];
-
-		switch (spec[n].density.type)
-		{
-			case STEP:
-				start = spec->density.start / spec->dx[0];
-				particles->size = (region->nx[0] - start) * region->nx[1] * ppc;
-				break;
-
-			case SLAB:
-				start = spec->density.start / spec->dx[0] - spec->n_move;
-				end = spec->density.end / spec->dx[0] - spec->n_move;
-				particles->size = (end - start) * region->nx[1] * ppc;
-				break;
-
-			default:
-				particles->size = region->nx[0] * region->nx[1] * ppc;
-				break;
-		}
-
-		particles->size_max = particles->size;
-		particles->data = malloc(particles->size * sizeof(t_part));
-		memcpy(particles->data, spec[n].main_vector.data, particles->size * sizeof(t_part));
-
-		spec[n].main_vector.size -= particles->size;
-		void *restrict ptr = malloc(spec[n].main_vector.size * sizeof(t_part));
-
-		if(ptr)
-		{
-			memcpy(ptr, spec[n].main_vector.data + particles->size, spec[n].main_vector.size * sizeof(t_part));
-			free(spec[n].main_vector.data);
-			spec[n].main_vector.data = ptr;
-		}
+		region->species[n].quiet = spec[n].quiet;
+		region->species[n].region_id = id;
 	}
 
 	//Calculate the region box
@@ -90,9 +53,27 @@ void region_new(t_region *region, int n_regions, int nx[2], int id, int n_spec,
 
 	// Initialise the local current
 	current_new(&region->local_current, region->nx, region_box, dt);
+	region->local_current.region_id = id;
 
 	// Initialise the local emf
 	emf_new(&region->local_emf, region->nx, region_box, dt);
+	region->local_emf.region_id = id;
+
+	region->patch = NULL;
+	region->envelope = NULL;
+}
+
+// Set the position of the particles inside the region according to the density profile of each
+// species (the momentum is set afterwards, see sim_new)
+void region_load_particles(t_region *region)
+{
+	const int range[][2] = {{0, region->nx[0]}, {region->limits_y[0], region->limits_y[1]}};
+
+	for (int n = 0; n < region->n_species; n++)
+	{
+		t_species *spec = &region->species[n];
+		spec_set_x(&spec->main_vector, range, spec->ppc, &spec->density, spec->dx, spec->n_move);
+	}
 }
 
 // Link two adjacent regions and calculate the overlap zone between them
@@ -113,13 +94,79 @@ void region_set_moving_window(t_region *region)
 {
 	region->local_current.moving_window = true;
 	region->local_emf.moving_window = true;
+	if (region->envelope) region->envelope->moving_window = true;
 
 	for (int i = 0; i < region->n_species; i++)
 		region->species[i].moving_window = true;
 }
 
+// Set the boundary conditions (the y edges only apply to the first and last region)
+void region_set_boundaries(t_region *region, const t_boundary *boundary, const int global_nx[2])
+{
+	bool absorbing[2][2];
+	for (int d = 0; d < 2; d++)
+		for (int e = 0; e < 2; e++)
+			absorbing[d][e] = boundary->type[d][e] == BOUNDARY_PML;
+
+	for (int e = 0; e < 2; e++)
+		region->local_current.absorbing[0][e] = absorbing[0][e];
+	region->local_current.absorbing[1][0] = absorbing[1][0] && region->limits_y[0] == 0;
+	region->local_current.absorbing[1][1] = absorbing[1][1] && region->limits_y[1] == global_nx[1];
+
+	emf_set_boundaries(&region->local_emf, boundary, region->limits_y[0], global_nx[1]);
+
+	if (region->envelope)
+		for (int d = 0; d < 2; d++)
+			for (int e = 0; e < 2; e++)
+				region->envelope->absorbing[d][e] = region->local_emf.absorbing[d][e];
+
+	for (int i = 0; i < region->n_species; i++)
+		for (int d = 0; d < 2; d++)
+			for (int e = 0; e < 2; e++)
+				region->species[i].absorbing[d][e] = absorbing[d][e];
+}
+
+// Create the part of the fine grid inside the region (if any)
+void region_set_refinement(t_region *region, const t_mesh_refinement *mr)
+{
+	if (!patch_overlaps(mr, region->local_emf.dx, region->limits_y)) return;
+
+	region->patch = malloc(sizeof(t_patch));
+	assert(region->patch);
+	patch_new(region->patch, mr, &region->local_emf, region->limits_y);
+}
+
+// Create the laser envelope of the region (with the same boundaries as the fields)
+void region_set_envelope(t_region *region, const float k0)
+{
+	region->envelope = malloc(sizeof(t_envelope));
+	assert(region->envelope);
+
+	envelope_new(region->envelope, region->nx, region->local_emf.box, region->local_emf.dt, k0);
+	region->envelope->region_id = region->id;
+	region->envelope->moving_window = region->local_emf.moving_window;
+
+	for (int d = 0; d < 2; d++)
+		for (int e = 0; e < 2; e++)
+			region->envelope->absorbing[d][e] = region->local_emf.absorbing[d][e];
+}
+
 void region_delete(t_region *region)
 {
+	if (region->patch)
+	{
+		patch_delete(region->patch);
+		free(region->patch);
+		region->patch = NULL;
+	}
+
+	if (region->envelope)
+	{
+		envelope_delete(region->envelope);
+		free(region->envelope);
+		region->envelope = NULL;
+	}
+
 	current_delete(&region->local_current);
 	emf_delete(&region->local_emf);
 
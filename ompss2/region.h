@@ -15,6 +15,8 @@
 #include "particles.h"
 #include "emf.h"
 #include "current.h"
+#include "patch.h"
+#include "envelope.h"
 
 typedef struct Region
 {
@@ -34,12 +36,24 @@ typedef struct Region
 	t_current local_current;
 	t_emf local_emf;
 
+	// Part of the fine grid of the mesh refinement (NULL if the region does not overlap it)
+	t_patch *patch;
+
+	// Laser envelope (NULL if the lasers are solved by the field solver)
+	t_envelope *envelope;
+
 } t_region;
 
 void region_new(t_region *region, int n_regions, int nx[2], int id, int n_spec, t_species *spec,
 		float box[], float dt, t_region *prev_region, t_region *next_region);
 void region_link_adj_regions(t_region *region);
+
+#pragma oss task inout(*region) label("Region Load Particles")
+void region_load_particles(t_region *region);
 void region_set_moving_window(t_region *region);
+void region_set_boundaries(t_region *region, const t_boundary *boundary, const int global_nx[2]);
+void region_set_refinement(t_region *region, const t_mesh_refinement *mr);
+void region_set_envelope(t_region *region, const float k0);
 void region_delete(t_region *region);
 
 #endif
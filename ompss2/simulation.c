@@ -18,11 +18,18 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <assert.h>
-#include <nanos6.h>
 
 #include "simulation.h"
 #include "timer.h"
 #include "zdf.h"
+#include "perf_counters.h"
+#include "task_trace.h"
+
+#ifdef ENABLE_OPENMP_TASKS
+#include "omp_tasks.h"
+#else
+#include <nanos6.h>
+#endif
 
 
 /*********************************************************************************************
@@ -52,6 +59,29 @@ void sim_create_dir(t_simulation *sim)
 	}
 }
 
+// Load the particles of each region in parallel. The momentum is set afterwards, species by
+// species and in the order of the regions, so the random sequence is the same as injecting each
+// species in the whole simulation space (independent of the number of regions)
+static void sim_load_particles(t_simulation *sim)
+{
+	for(int i = 0; i < sim->n_regions; i++)
+		region_load_particles(&sim->regions[i]);
+	#pragma oss taskwait
+#ifdef ENABLE_OPENMP_TASKS
+	#pragma omp taskwait
+#endif
+
+	for (int n = 0; n < sim->regions[0].n_species; n++)
+		for(int i = 0; i < sim->n_regions; i++)
+		{
+			t_species *spec = &sim->regions[i].species[n];
+			if (spec->quiet)
+				spec_set_u_quiet(&spec->main_vector, 0, spec->main_vector.size, spec->ufl, spec->uth,
+						0);
+			else spec_set_u(&spec->main_vector, 0, spec->main_vector.size, spec->ufl, spec->uth);
+		}
+}
+
 // Constructor
 void sim_new(t_simulation *sim, int nx[2], float box[2], float dt, float tmax, int ndump,
 		t_species *species, int n_species, char name[64], int n_regions)
@@ -59,6 +89,12 @@ void sim_new(t_simulation *sim, int nx[2], float box[2], float dt, float tmax, i
 	// Simulation parameters
 	sim->iter = 0;
 	sim->moving_window = false;
+	sim->boundary = (t_boundary) {.type = {{BOUNDARY_PERIODIC, BOUNDARY_PERIODIC},
+			{BOUNDARY_PERIODIC, BOUNDARY_PERIODIC}}};
+	sim->refinement = (t_mesh_refinement) {.ratio = 0};
+	sim->boost = (t_boost) {.gamma = 0};
+	sim->lab_diag = (t_lab_diag) {.n_snapshots = 0, .buffer = NULL, .saved = NULL};
+	sim_set_task_priority(sim, TASK_PRIORITY_DEPTH);
 	sim->dt = dt;
 	sim->tmax = tmax;
 	sim->ndump = ndump;
@@ -77,12 +113,6 @@ void sim_new(t_simulation *sim, int nx[2], float box[2], float dt, float tmax, i
 		exit(-1);
 	}
 
-	// Inject particles in the simulation that will be distributed to all the regions
-	const int range[][2] = {{0, nx[0]}, {0, nx[1]}};
-	for (int n = 0; n < n_species; ++n)
-		spec_inject_particles(&species[n].main_vector, range, species[n].ppc, &species[n].density,
-				species[n].dx, species[n].n_move, species[n].ufl, species[n].uth);
-
 	// Initialise the regions
 	sim->n_regions = n_regions;
 	sim->regions = malloc(n_regions * sizeof(t_region));
@@ -96,6 +126,8 @@ void sim_new(t_simulation *sim, int nx[2], float box[2], float dt, float tmax, i
 		prev = &sim->regions[i];
 	}
 
+	sim_load_particles(sim);
+
 	// Cleaning
 	for (int n = 0; n < n_species; ++n)
 		spec_delete(&species[n]);
@@ -112,6 +144,14 @@ void sim_new(t_simulation *sim, int nx[2], float box[2], float dt, float tmax, i
 	// Create output directory (energy)
 	sim_create_dir(sim);
 
+#ifdef ENABLE_PERF_COUNTERS
+	perf_counters_init(n_regions, tmax / dt + 2);
+#endif
+
+#ifdef ENABLE_TASK_TRACE
+	task_trace_init();
+#endif
+
 	char filename[128];
 	FILE *file;
 	sprintf(filename, "output/%s/energy.csv", sim->name);
@@ -121,16 +161,42 @@ void sim_new(t_simulation *sim, int nx[2], float box[2], float dt, float tmax, i
 
 void sim_delete(t_simulation *sim)
 {
+	// Save the lab frame snapshots that were not completed
+	if (sim->lab_diag.n_snapshots > 0)
+	{
+		for (int s = 0; s < sim->lab_diag.n_snapshots; s++)
+			if (!sim->lab_diag.saved[s]) lab_diag_save(&sim->lab_diag, s);
+		#pragma oss taskwait
+#ifdef ENABLE_OPENMP_TASKS
+		#pragma omp taskwait
+#endif
+
+		lab_diag_delete(&sim->lab_diag);
+	}
+
 	for(int i = 0; i < sim->n_regions; i++)
 		region_delete(&sim->regions[i]);
 
 	free(sim->regions);
+
+#ifdef ENABLE_PERF_COUNTERS
+	perf_counters_finalize();
+#endif
+
+#ifdef ENABLE_TASK_TRACE
+	task_trace_finalize();
+#endif
 }
 
 void sim_add_laser(t_simulation *sim, t_emf_laser *laser)
 {
 	for(int i = 0; i < sim->n_regions; i++)
-		emf_add_laser(&sim->regions[i].local_emf, laser, sim->regions[i].limits_y[0]);
+	{
+		if (sim->boost.gamma > 1)
+			emf_add_laser_boosted(&sim->regions[i].local_emf, laser, sim->regions[i].limits_y[0],
+					sim->boost.gamma, sim->boost.origin);
+		else emf_add_laser(&sim->regions[i].local_emf, laser, sim->regions[i].limits_y[0]);
+	}
 
 	for(int i = 1; i < sim->n_regions; i++)
 		emf_update_gc_y_serial(&sim->regions[i].local_emf);
@@ -148,6 +214,75 @@ void sim_add_laser(t_simulation *sim, t_emf_laser *laser)
 		emf_update_gc_x(&sim->regions[i].local_emf);
 }
 
+// Add a laser antenna in the plane x (lab frame, see t_emf_antenna). The antenna must be outside
+// the absorbing layers and it is not supported in the boosted frame. With a moving window, the
+// antenna stops when the window passes it
+void sim_add_antenna(t_simulation *sim, t_emf_laser *laser, const float x)
+{
+	const t_fld dx = sim->box[0] / sim->nx[0];
+	const int i = lroundf(x / dx);
+
+	int lower = 1, upper = sim->nx[0];
+	if (sim->boundary.type[0][0] == BOUNDARY_PML) lower = sim->boundary.pml_size;
+	if (sim->boundary.type[0][1] == BOUNDARY_PML) upper = sim->nx[0] - sim->boundary.pml_size;
+
+	if (i < lower || i >= upper)
+	{
+		fprintf(stderr, "Invalid antenna position (it must be inside the box and outside the "
+				"PML)\n");
+		exit(-1);
+	}
+
+	if (sim->boost.gamma > 1)
+	{
+		fprintf(stderr, "The laser antenna is not supported in the boosted frame\n");
+		exit(-1);
+	}
+
+	for(int k = 0; k < sim->n_regions; k++)
+		emf_add_antenna(&sim->regions[k].local_emf, laser, x, sim->regions[k].limits_y[0]);
+}
+
+// Add a laser pulse described by its envelope (see envelope.h) instead of the full laser fields.
+// All the envelope lasers must have the same frequency. The laser envelope does not support the
+// boosted frame nor the mesh refinement
+void sim_add_laser_envelope(t_simulation *sim, t_emf_laser *laser)
+{
+	if (sim->boost.gamma > 1 || sim->refinement.ratio > 0)
+	{
+		fprintf(stderr, "The laser envelope does not support the boosted frame or the mesh "
+				"refinement\n");
+		exit(-1);
+	}
+
+	if (laser->omega0 <= 0)
+	{
+		fprintf(stderr, "Invalid laser frequency, must be > 0\n");
+		exit(-1);
+	}
+
+	if (sim->regions[0].envelope && sim->regions[0].envelope->k0 != laser->omega0)
+	{
+		fprintf(stderr, "All the envelope lasers must have the same frequency\n");
+		exit(-1);
+	}
+
+	if (!sim->regions[0].envelope)
+	{
+		for(int i = 0; i < sim->n_regions; i++)
+			region_set_envelope(&sim->regions[i], laser->omega0);
+
+		for(int i = 0; i < sim->n_regions; i++)
+			envelope_overlap_zone(sim->regions[i].envelope, sim->regions[i].prev->envelope);
+	}
+
+	for(int i = 0; i < sim->n_regions; i++)
+		envelope_add_laser(sim->regions[i].envelope, laser, sim->regions[i].limits_y[0]);
+
+	for(int i = 0; i < sim->n_regions; i++)
+		envelope_update_gc_y_serial(sim->regions[i].envelope);
+}
+
 void sim_set_smooth(t_simulation *sim, t_smooth *smooth)
 {
 	if ((smooth->xtype != NONE) && (smooth->xlevel <= 0))
@@ -166,8 +301,208 @@ void sim_set_smooth(t_simulation *sim, t_smooth *smooth)
 		sim->regions[i].local_current.smooth = *smooth;
 }
 
+// Set the boundary conditions of the simulation box (this must come after sim_new)
+void sim_set_boundaries(t_simulation *sim, t_boundary *boundary)
+{
+	const char dir[] = {'x', 'y'};
+	t_boundary bnd = *boundary;
+
+	// Default PML parameters
+	if (bnd.pml_size == 0) bnd.pml_size = 16;
+	if (bnd.pml_reflection == 0) bnd.pml_reflection = 1e-6;
+
+	for (int d = 0; d < 2; d++)
+	{
+		if ((bnd.type[d][0] == BOUNDARY_PERIODIC) != (bnd.type[d][1] == BOUNDARY_PERIODIC))
+		{
+			fprintf(stderr, "Periodic boundaries must be set in both edges (%c direction)\n", dir[d]);
+			exit(-1);
+		}
+
+		if (bnd.type[d][0] == BOUNDARY_PML && (bnd.pml_size < 1 || 2 * bnd.pml_size > sim->nx[d]))
+		{
+			fprintf(stderr, "Invalid PML size along %c direction\n", dir[d]);
+			exit(-1);
+		}
+	}
+
+	if (bnd.pml_reflection <= 0 || bnd.pml_reflection >= 1)
+	{
+		fprintf(stderr, "Invalid PML reflection coefficient\n");
+		exit(-1);
+	}
+
+	if (sim->moving_window && bnd.type[0][0] != BOUNDARY_PERIODIC)
+	{
+		fprintf(stderr, "The x boundaries are set by the moving window\n");
+		exit(-1);
+	}
+
+	sim->boundary = bnd;
+
+	for(int i = 0; i < sim->n_regions; i++)
+		region_set_boundaries(&sim->regions[i], &bnd, sim->nx);
+
+	// Link the convolution terms of the PML in adjacent regions
+	for(int i = 0; i < sim->n_regions; i++)
+		emf_overlap_zone(&sim->regions[i].local_emf, &sim->regions[i].prev->local_emf);
+}
+
+// Add a refined patch (this must come after sim_add_laser and sim_set_boundaries). With a moving
+// window, the patch moves with it
+void sim_set_refinement(t_simulation *sim, t_mesh_refinement *mr)
+{
+	const char dir[] = {'x', 'y'};
+	const t_fld dx[] = {sim->box[0] / sim->nx[0], sim->box[1] / sim->nx[1]};
+	int start[2], end[2];
+
+	if (mr->ratio < 2 || mr->ratio > PATCH_MAX_RATIO)
+	{
+		fprintf(stderr, "Invalid refinement ratio (must be between 2 and %d)\n", PATCH_MAX_RATIO);
+		exit(-1);
+	}
+
+	patch_cells(mr, dx, start, end);
+
+	for (int d = 0; d < 2; d++)
+	{
+		// The ring around the patch must be inside the box (and outside the PML)
+		int lower = 1, upper = sim->nx[d] - 1;
+		if (sim->boundary.type[d][0] == BOUNDARY_PML) lower = sim->boundary.pml_size;
+		if (sim->boundary.type[d][1] == BOUNDARY_PML) upper = sim->nx[d] - sim->boundary.pml_size;
+
+		if (end[d] <= start[d] || start[d] - PATCH_RING < lower || end[d] + PATCH_RING > upper)
+		{
+			fprintf(stderr, "Invalid refined patch along %c direction (it must be at least %d cells "
+					"away from the edges)\n", dir[d], PATCH_RING + lower);
+			exit(-1);
+		}
+	}
+
+	if (sim->refinement.ratio > 0)
+	{
+		fprintf(stderr, "Only one refined patch is supported\n");
+		exit(-1);
+	}
+
+	if (sim->regions[0].envelope)
+	{
+		fprintf(stderr, "The mesh refinement does not support the laser envelope\n");
+		exit(-1);
+	}
+
+	// The fine grid does not include the antennas (with a moving window, the antennas move left
+	// in the window)
+	for (int k = 0; k < sim->regions[0].local_emf.n_antennas; k++)
+	{
+		const int i = lroundf(sim->regions[0].local_emf.antennas[k].x / dx[0]);
+		if (i >= start[0] - PATCH_RING && (sim->moving_window || i < end[0] + PATCH_RING))
+		{
+			fprintf(stderr, "The laser antennas must be outside the refined patch\n");
+			exit(-1);
+		}
+	}
+
+	sim->refinement = *mr;
+
+	for(int i = 0; i < sim->n_regions; i++)
+		region_set_refinement(&sim->regions[i], mr);
+
+	// Link the fine grid in adjacent regions
+	for(int i = 1; i < sim->n_regions; i++)
+		if (sim->regions[i].patch && sim->regions[i - 1].patch)
+			patch_overlap_zone(sim->regions[i].patch, sim->regions[i - 1].patch);
+}
+
+// Run the simulation in a boosted frame (this must come after sim_set_boundaries and before
+// sim_add_laser). The density profile and the fluid momentum of the species are transformed and
+// the particles are loaded again
+void sim_set_boost(t_simulation *sim, t_boost *boost)
+{
+	if (boost->gamma <= 1)
+	{
+		fprintf(stderr, "Invalid Lorentz factor of the boosted frame (must be > 1)\n");
+		exit(-1);
+	}
+
+	if (sim->regions[0].envelope)
+	{
+		fprintf(stderr, "The boosted frame does not support the laser envelope\n");
+		exit(-1);
+	}
+
+	if (sim->moving_window || sim->boundary.type[0][0] != BOUNDARY_PML
+			|| sim->boundary.type[0][1] != BOUNDARY_PML)
+	{
+		fprintf(stderr, "The boosted frame requires absorbing boundaries along x (and no moving "
+				"window)\n");
+		exit(-1);
+	}
+
+	if (boost->n_snapshots < 0 || (boost->n_snapshots > 0 && (boost->nx_lab <= 0
+			|| boost->x_lab[1] <= boost->x_lab[0] || boost->dt_snapshot < 0)))
+	{
+		fprintf(stderr, "Invalid lab frame diagnostics\n");
+		exit(-1);
+	}
+
+	sim->boost = *boost;
+	const float beta = sqrtf(1.0f - 1.0f / (boost->gamma * boost->gamma));
+
+	// The plasma is contracted (higher density) and flows left
+	for(int i = 0; i < sim->n_regions; i++)
+		for (int n = 0; n < sim->regions[i].n_species; n++)
+		{
+			t_species *spec = &sim->regions[i].species[n];
+			t_part_data ufl[3];
+
+			spec->density.gamma = boost->gamma;
+			spec->density.origin = boost->origin;
+			spec->q *= boost->gamma;
+
+			boost_momentum(boost, spec->ufl, ufl);
+			for (int d = 0; d < 3; d++)
+				spec->ufl[d] = ufl[d];
+
+			spec->flow = beta;
+			spec->n_inject = 0;
+			spec->main_vector.size = 0;
+		}
+
+	sim_load_particles(sim);
+
+	for(int i = 0; i < sim->n_regions; i++)
+		for (int n = 0; n < sim->regions[i].n_species; n++)
+			spec_calculate_energy(&sim->regions[i].species[n]);
+
+	// Numerical Cherenkov mitigation
+	if (boost->filter[0] > 0 || boost->filter[1] > 0)
+	{
+		t_smooth smooth = {.xtype = boost->filter[0] > 0 ? COMPENSATED : NONE,
+				.xlevel = boost->filter[0], .ytype = boost->filter[1] > 0 ? COMPENSATED : NONE,
+				.ylevel = boost->filter[1]};
+		sim_set_smooth(sim, &smooth);
+	}
+
+	if (boost->n_snapshots > 0)
+		lab_diag_new(&sim->lab_diag, boost, sim->nx, sim->box, sim->dt, sim->name);
+}
+
+// Select how the priorities of the tasks are set (see task_priority.h)
+void sim_set_task_priority(t_simulation *sim, const enum task_priority_policy policy)
+{
+	sim->priority = policy;
+	task_priority_set_policy(policy);
+}
+
 void sim_set_moving_window(t_simulation *sim)
 {
+	if (sim->boundary.type[0][0] != BOUNDARY_PERIODIC)
+	{
+		fprintf(stderr, "The x boundaries are set by the moving window\n");
+		exit(-1);
+	}
+
 	sim->moving_window = true;
 	for(int i = 0; i < sim->n_regions; i++)
 		region_set_moving_window(&sim->regions[i]);
@@ -181,13 +516,49 @@ void sim_iter(t_simulation *sim)
 	t_region *regions = sim->regions;
 	const int n_regions = sim->n_regions;
 
+#ifdef ENABLE_CONSUME_CURRENT
+	// The field solver clears the current after using it, unless the current is needed for the
+	// diagnostics (in that case, it is cleared at the beginning of the next time step)
+	const bool clear_current = !report(sim->iter + 1, sim->ndump);
+	const bool zero_current = report(sim->iter, sim->ndump);
+#else
+	const bool clear_current = false;
+	const bool zero_current = true;
+#endif
+
 	for(int i = 0; i < n_regions; i++)
 	{
-		current_zero(&regions[i].local_current);
+		if (zero_current) current_zero(&regions[i].local_current);
 
-		for (int k = 0; k < regions[i].n_species; k++)
-			spec_advance(&regions[i].species[k], &regions[i].local_emf, &regions[i].local_current,
-							regions[i].limits_y);
+		if (regions[i].patch)
+		{
+			current_zero(&regions[i].patch->current);
+
+			for (int k = 0; k < regions[i].n_species; k++)
+				spec_advance_refined(&regions[i].species[k], &regions[i].local_emf,
+						&regions[i].local_current, regions[i].patch, regions[i].limits_y);
+		} else if (regions[i].envelope)
+		{
+			for (int k = 0; k < regions[i].n_species; k++)
+				spec_advance_envelope(&regions[i].species[k], &regions[i].local_emf,
+						&regions[i].local_current, regions[i].envelope, regions[i].limits_y);
+		} else if (SPEC_SPLIT_ADVANCE(&regions[i].local_emf))
+		{
+			// The particles far from the edges of the region only wait for the field solver of this
+			// region, the ones near the edges also wait for the exchange of the ghost cells
+			for (int k = 0; k < regions[i].n_species; k++)
+				spec_advance_interior(&regions[i].species[k], &regions[i].local_emf,
+						&regions[i].local_current, regions[i].limits_y);
+
+			for (int k = 0; k < regions[i].n_species; k++)
+				spec_advance_band(&regions[i].species[k], &regions[i].local_emf,
+						&regions[i].local_current, regions[i].limits_y);
+		} else
+		{
+			for (int k = 0; k < regions[i].n_species; k++)
+				spec_advance(&regions[i].species[k], &regions[i].local_emf,
+						&regions[i].local_current, regions[i].limits_y);
+		}
 
 		if(!regions[i].local_current.moving_window)
 			current_reduction_x(&regions[i].local_current);
@@ -198,6 +569,11 @@ void sim_iter(t_simulation *sim)
 		for (int k = 0; k < regions[i].n_species; k++)
 			spec_merge_vectors(&regions[i].species[k]);
 		current_reduction_y(&regions[i].local_current);
+
+		if (regions[i].patch && regions[i].patch->has_below)
+			current_reduction_y(&regions[i].patch->current);
+
+		if (regions[i].envelope) envelope_reduction_y(regions[i].envelope);
 	}
 
 	if (regions->local_current.smooth.xtype != NONE)
@@ -231,14 +607,75 @@ void sim_iter(t_simulation *sim)
 	}
 
 	for(int i = 0; i < n_regions; i++)
-		emf_advance(&regions[i].local_emf, &regions[i].local_current);
+		emf_advance(&regions[i].local_emf, &regions[i].local_current, clear_current);
 
 	for(int i = 0; i < n_regions; i++)
 		emf_update_gc_y(&regions[i].local_emf);
 
+	// The laser envelope is advanced with the susceptibility of the particles at t_n
+	if (regions[0].envelope)
+	{
+		for(int i = 0; i < n_regions; i++)
+			envelope_advance(regions[i].envelope);
+
+		for(int i = 0; i < n_regions; i++)
+			envelope_update_gc_y(regions[i].envelope);
+	}
+
+	// The fine grid is advanced in substeps, after the coarse grid (for the time interpolation).
+	// The last substep also corrects the coarse fields inside the patch
+	for (int k = 0; k < sim->refinement.ratio; k++)
+	{
+		for(int i = 0; i < n_regions; i++)
+			if (regions[i].patch) patch_advance(regions[i].patch, &regions[i].local_emf, k);
+
+		for(int i = 0; i < n_regions; i++)
+			if (regions[i].patch && regions[i].patch->has_below)
+				emf_update_gc_y(&regions[i].patch->emf);
+	}
+
+	if (sim->refinement.ratio > 0)
+	{
+		// Ghost cells of the corrected coarse fields, before they are stored for the next step
+		for(int i = 0; i < n_regions; i++)
+			emf_update_gc_y(&regions[i].local_emf);
+
+		for(int i = 0; i < n_regions; i++)
+			if (regions[i].patch) patch_update_coarse(regions[i].patch, &regions[i].local_emf);
+	}
+
+	// Lab frame diagnostics of the boosted frame (fields at t_n+1)
+	if (sim->lab_diag.n_snapshots > 0)
+	{
+		for(int i = 0; i < n_regions; i++)
+			lab_diag_update(&sim->lab_diag, &regions[i].local_emf, regions[i].limits_y, sim->iter + 1);
+
+		for (int s = 0; s < sim->lab_diag.n_snapshots; s++)
+			if (lab_diag_complete(&sim->lab_diag, s, sim->iter + 1))
+			{
+				sim->lab_diag.saved[s] = true;
+				lab_diag_save(&sim->lab_diag, s);
+			}
+	}
+
 	sim->iter++;
 }
 
+// Add the particles that are still in the queues between regions (sent after the merge of the
+// neighbour, see spec_merge_vectors) to the main buffers, before reporting them. Called after a
+// taskwait
+void sim_merge_particles(t_simulation *sim)
+{
+	for (int i = 0; i < sim->n_regions; i++)
+		for (int k = 0; k < sim->regions[i].n_species; k++)
+			spec_merge_vectors(&sim->regions[i].species[k]);
+
+	#pragma oss taskwait
+#ifdef ENABLE_OPENMP_TASKS
+	#pragma omp taskwait
+#endif
+}
+
 /*********************************************************************************************
  Diagnostics
  *********************************************************************************************/
@@ -255,6 +692,7 @@ int report(int n, int ndump)
 
 void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1)
 {
+
 	int n_threads = nanos6_get_num_cpus();
 	double npart = 0;
 	float sim_time = timer_interval_seconds(t0, t1);
@@ -264,15 +702,34 @@ void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1)
 			npart += sim->regions[j].species[i].npush;
 
 #ifndef TEST
+	static const char *priority_names[] = {"none", "fixed", "depth"};
+
 	fprintf(stdout, "Simulation: %s\n", sim->name);
 	fprintf(stdout, "Number of regions: %d\n", sim->n_regions);
 	fprintf(stdout, "Number of threads: %d\n", n_threads);
+	fprintf(stdout, "Task priorities: %s\n", priority_names[sim->priority]);
 	fprintf(stdout, "Total simulation time  = %f s\n", sim_time);
 	fprintf(stdout, "Performance: %f Mpart/s", npart / sim_time / 1E6);
 	fprintf(stdout, "\n");
 
+	t_phase_timings timings;
+	timer_phase_collect(&timings);
+	timer_phase_report(&timings);
+
+#ifdef ENABLE_PERF_COUNTERS
+	perf_counters_report();
+#endif
+
 #else
-	printf("%s,%d,%d,%f,%lf\n", sim->name, n_regions, n_threads, sim_time, npart / sim_time / 10E6);
+	printf("%s,%d,%d,%f,%lf\n", sim->name, sim->n_regions, n_threads, sim_time, npart / sim_time / 10E6);
+#endif
+
+#ifdef ENABLE_PERF_COUNTERS
+	perf_counters_save_csv(sim->name);
+#endif
+
+#ifdef ENABLE_TASK_TRACE
+	task_trace_save(sim->name);
 #endif
 }
 
@@ -341,6 +798,15 @@ void sim_report_grid_zdf(t_simulation *sim, enum report_grid_type type, const in
 			current_report(global_buf, sim->iter, sim->nx, sim->box, sim->dt, coord, path);
 			break;
 
+		case REPORT_ENVELOPE:
+			if (!sim->regions[0].envelope) break;
+
+			for(int j = 0; j < sim->n_regions; j++)
+				envelope_reconstruct_global_buffer(sim->regions[j].envelope, global_buf,
+						sim->regions[j].limits_y[0]);
+			envelope_report(global_buf, sim->box, sim->nx, sim->iter, sim->dt, path);
+			break;
+
 		default:
 			fprintf(stderr, "Error: Unsupported grid report!");
 			break;
@@ -351,7 +817,7 @@ void sim_report_grid_zdf(t_simulation *sim, enum report_grid_type type, const in
 
 // Save a particle property to a ZDF file
 void sim_report_spec_zdf(t_simulation *sim, const int species, const int rep_type,
-		const int pha_nx[2], const float pha_range[][2])
+		const int pha_nx[], const float pha_range[][2])
 {
 	size_t size;
 	char path[128] = "";
@@ -367,7 +833,10 @@ void sim_report_spec_zdf(t_simulation *sim, const int species, const int rep_typ
 
 			for(int j = 0; j < sim->n_regions; j++)
 				spec_deposit_charge(&sim->regions[j].species[species], charge);
-			spec_rep_charge(charge, sim->nx, sim->box, sim->iter, sim->dt, sim->moving_window, path);
+			const bool periodic[] = {!sim->moving_window
+					&& sim->boundary.type[0][0] == BOUNDARY_PERIODIC,
+					sim->boundary.type[1][0] == BOUNDARY_PERIODIC};
+			spec_rep_charge(charge, sim->nx, sim->box, sim->iter, sim->dt, periodic, path);
 
 			free(charge);
 		}
@@ -18,9 +18,10 @@
 #include "particles.h"
 #include "emf.h"
 #include "current.h"
+#include "boost.h"
 
 enum report_grid_type {
-	REPORT_EFLD, REPORT_BFLD, REPORT_CURRENT
+	REPORT_EFLD, REPORT_BFLD, REPORT_CURRENT, REPORT_ENVELOPE
 };
 
 typedef struct {
@@ -37,6 +38,15 @@ typedef struct {
 	int nx[2];
 	t_fld box[2];
 	bool moving_window;
+	t_boundary boundary;
+	t_mesh_refinement refinement;
+
+	// Boosted frame (gamma = 0: lab frame) and lab frame diagnostics
+	t_boost boost;
+	t_lab_diag lab_diag;
+
+	// Policy for the priority of the tasks
+	enum task_priority_policy priority;
 
 	unsigned int n_regions;
 	t_region *regions;
@@ -51,11 +61,18 @@ void sim_new(t_simulation *sim, int nx[2], float box[2], float dt, float tmax, i
 void sim_init(t_simulation *sim, int n_regions);
 void sim_set_moving_window(t_simulation *sim);
 void sim_set_smooth(t_simulation *sim, t_smooth *smooth);
+void sim_set_boundaries(t_simulation *sim, t_boundary *boundary);
+void sim_set_refinement(t_simulation *sim, t_mesh_refinement *mr);
+void sim_set_boost(t_simulation *sim, t_boost *boost);
+void sim_set_task_priority(t_simulation *sim, const enum task_priority_policy policy);
 void sim_add_laser(t_simulation *sim, t_emf_laser *laser);
+void sim_add_antenna(t_simulation *sim, t_emf_laser *laser, const float x);
+void sim_add_laser_envelope(t_simulation *sim, t_emf_laser *laser);
 void sim_delete(t_simulation *sim);
 
 // Iteration
 void sim_iter(t_simulation *sim);
+void sim_merge_particles(t_simulation *sim);
 
 // Report
 int report(int n, int ndump);
@@ -0,0 +1,124 @@
+/*********************************************************************************************
+ ZPIC
+ task_priority.c
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#include "task_priority.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+int task_priority[TRACE_N_TASKS] = {0};
+
+// Dependencies between the tasks of one time step (predecessor, successor), following the
+// order of sim_iter. The lab frame diagnostics are left out, since the next time step does not
+// wait for them. When the particle advance is split (spec_advance_interior), TRACE_SPEC_ADVANCE
+// is its interior part and the band part, which releases the reductions, comes after it
+static const int step_graph[][2] = {
+	{TRACE_CURRENT_RESET, TRACE_SPEC_ADVANCE},
+	{TRACE_SPEC_ADVANCE, TRACE_SPEC_MERGE},
+	{TRACE_SPEC_ADVANCE, TRACE_CURRENT_REDUCTION_X},
+	{TRACE_SPEC_ADVANCE, TRACE_ENVELOPE_REDUCTION_Y},
+	{TRACE_SPEC_ADVANCE, TRACE_SPEC_ADVANCE_BAND},
+	{TRACE_SPEC_ADVANCE_BAND, TRACE_SPEC_MERGE},
+	{TRACE_SPEC_ADVANCE_BAND, TRACE_CURRENT_REDUCTION_X},
+	{TRACE_CURRENT_REDUCTION_X, TRACE_CURRENT_REDUCTION_Y},
+	{TRACE_CURRENT_REDUCTION_Y, TRACE_CURRENT_SMOOTH_X},
+	{TRACE_CURRENT_REDUCTION_Y, TRACE_EMF_ADVANCE},
+	{TRACE_CURRENT_REDUCTION_Y, TRACE_PATCH_ADVANCE},
+	{TRACE_CURRENT_SMOOTH_X, TRACE_CURRENT_SMOOTH_Y},
+	{TRACE_CURRENT_SMOOTH_X, TRACE_CURRENT_UPDATE_GC},
+	{TRACE_CURRENT_SMOOTH_Y, TRACE_CURRENT_UPDATE_GC},
+	{TRACE_CURRENT_UPDATE_GC, TRACE_EMF_ADVANCE},
+	{TRACE_EMF_ADVANCE, TRACE_EMF_UPDATE_GC},
+	{TRACE_EMF_ADVANCE, TRACE_PATCH_ADVANCE},
+	{TRACE_ENVELOPE_REDUCTION_Y, TRACE_ENVELOPE_ADVANCE},
+	{TRACE_ENVELOPE_ADVANCE, TRACE_ENVELOPE_UPDATE_GC},
+};
+
+#define STEP_GRAPH_EDGES (int) (sizeof(step_graph) / sizeof(step_graph[0]))
+
+// Tasks that run more than once in one time step (smoothing passes along y, substeps of the
+// fine grid, ghost cells of the coarse fields corrected by the fine grid). They close cycles in
+// the graph, so they are only used for the critical path of the trace and not for the priorities
+static const int step_repeat[][2] = {
+	{TRACE_CURRENT_UPDATE_GC, TRACE_CURRENT_SMOOTH_Y},
+	{TRACE_PATCH_ADVANCE, TRACE_PATCH_ADVANCE},
+	{TRACE_EMF_UPDATE_GC, TRACE_PATCH_ADVANCE},
+	{TRACE_PATCH_ADVANCE, TRACE_EMF_UPDATE_GC},
+};
+
+#define STEP_REPEAT_EDGES (int) (sizeof(step_repeat) / sizeof(step_repeat[0]))
+
+// The priority of a task is the latest depth at which it can run without making the time step
+// longer than the critical path of the graph, i.e., the critical path length minus the longest
+// path from the task to the end of the step. The tasks at the end of a chain (halo updates,
+// reductions along y, merge of the incoming particles) release the next time step of the
+// neighbouring regions and get the highest priorities, while the tasks of the next time step
+// (particle advance) that are already ready wait for them
+static void task_priority_depth(void)
+{
+	int level[TRACE_N_TASKS];   // Longest path to the end of the step
+	bool in_graph[TRACE_N_TASKS];
+	memset(level, 0, sizeof(level));
+	memset(in_graph, 0, sizeof(in_graph));
+
+	for (int e = 0; e < STEP_GRAPH_EDGES; e++)
+		in_graph[step_graph[e][0]] = in_graph[step_graph[e][1]] = true;
+
+	// The graph is acyclic, so the levels do not change after (number of tasks) passes
+	for (int pass = 0; pass < TRACE_N_TASKS; pass++)
+		for (int e = 0; e < STEP_GRAPH_EDGES; e++)
+			if (level[step_graph[e][0]] < level[step_graph[e][1]] + 1)
+				level[step_graph[e][0]] = level[step_graph[e][1]] + 1;
+
+	int critical_path = 0;
+	for (int t = 0; t < TRACE_N_TASKS; t++)
+		if (level[t] > critical_path) critical_path = level[t];
+
+	for (int t = 0; t < TRACE_N_TASKS; t++)
+		task_priority[t] = in_graph[t] ? critical_path - level[t] + 1 : 0;
+}
+
+// precedes[a][b] is true if a task of type b waits (directly or not) for a task of type a of the
+// same time step. The diagnostics wait for all the other tasks
+void task_graph_closure(bool precedes[TRACE_N_TASKS][TRACE_N_TASKS])
+{
+	memset(precedes, 0, TRACE_N_TASKS * sizeof(precedes[0]));
+
+	for (int e = 0; e < STEP_GRAPH_EDGES; e++)
+		precedes[step_graph[e][0]][step_graph[e][1]] = true;
+	for (int e = 0; e < STEP_REPEAT_EDGES; e++)
+		precedes[step_repeat[e][0]][step_repeat[e][1]] = true;
+	for (int t = 0; t < TRACE_N_TASKS; t++)
+		if (t != TRACE_DIAGNOSTICS) precedes[t][TRACE_DIAGNOSTICS] = true;
+
+	// Transitive closure (Floyd-Warshall)
+	for (int k = 0; k < TRACE_N_TASKS; k++)
+		for (int a = 0; a < TRACE_N_TASKS; a++)
+			if (precedes[a][k])
+				for (int b = 0; b < TRACE_N_TASKS; b++)
+					if (precedes[k][b]) precedes[a][b] = true;
+}
+
+// Set the priority of each type of task
+void task_priority_set_policy(const enum task_priority_policy policy)
+{
+	memset(task_priority, 0, sizeof(task_priority));
+
+	switch (policy)
+	{
+		case TASK_PRIORITY_NONE:
+			break;
+		case TASK_PRIORITY_FIXED:
+			task_priority[TRACE_SPEC_ADVANCE] = 5;
+			task_priority[TRACE_SPEC_ADVANCE_BAND] = 5;
+			break;
+		case TASK_PRIORITY_DEPTH:
+			task_priority_depth();
+			break;
+	}
+}
@@ -0,0 +1,35 @@
+/*********************************************************************************************
+ ZPIC
+ task_priority.h
+
+ Priority of each type of task (the task types are the same as the ones in the trace). The
+ priorities are computed from the dependencies between the tasks of one time step, so that the
+ tasks that release the work of the other regions (and of the next time step) run first.
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __TASK_PRIORITY__
+#define __TASK_PRIORITY__
+
+#include "task_trace.h"
+
+#include <stdbool.h>
+
+enum task_priority_policy {
+	TASK_PRIORITY_NONE,   // All the tasks with the same priority
+	TASK_PRIORITY_FIXED,  // Only the particle advance with a higher priority (original version)
+	TASK_PRIORITY_DEPTH   // From the depth of the task in the time step graph (default)
+};
+
+// Priority of each type of task (used in the priority clause of the task pragmas)
+extern int task_priority[TRACE_N_TASKS];
+
+void task_priority_set_policy(const enum task_priority_policy policy);
+
+// Dependencies between the types of task of one time step (used for the critical path of the
+// task trace)
+void task_graph_closure(bool precedes[TRACE_N_TASKS][TRACE_N_TASKS]);
+
+#endif
@@ -0,0 +1,346 @@
+/*********************************************************************************************
+ ZPIC
+ task_trace.c
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifdef ENABLE_TASK_TRACE
+
+#define _GNU_SOURCE
+
+#include "task_trace.h"
+#include "task_priority.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+// Same names as the task labels
+static const char *task_names[TRACE_N_TASKS] = {
+	"Current Reset", "Spec Advance", "Spec Merge Vectors", "Current Reduction X",
+	"Current Reduction Y", "Current Smooth X", "Current Smooth Y", "Current Update GC",
+	"EMF Advance", "EMF Update GC", "Diagnostics", "Patch Advance", "Envelope Reduction Y",
+	"Envelope Advance", "Envelope Update GC", "Spec Advance Band"
+};
+
+static t_trace_event *trace_buffer = NULL;
+static uint64_t trace_count = 0;   // Number of events recorded (including the discarded ones)
+static uint64_t trace_t0 = 0;
+static int trace_n_workers = 0;
+
+// Worker id (assigned in the first event of each thread)
+static __thread int worker_id = -1;
+
+/*********************************************************************************************
+ Events
+ *********************************************************************************************/
+
+static uint64_t trace_clock(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t task_trace_begin(void)
+{
+	return trace_clock();
+}
+
+static void trace_event_set(t_trace_event *restrict event, const uint64_t begin,
+		const uint64_t end, const uint64_t bytes, const enum trace_task task, const int region,
+		const int step)
+{
+	event->begin = begin - trace_t0;
+	event->end = end - trace_t0;
+	event->bytes = bytes;
+	event->task = task;
+	event->worker = worker_id;
+	event->region = region;
+	event->step = step;
+}
+
+void task_trace_end(const uint64_t begin, const enum trace_task task, const int region,
+		const int step, const uint64_t bytes)
+{
+	const uint64_t end = trace_clock();
+
+	if (worker_id < 0) worker_id = __atomic_fetch_add(&trace_n_workers, 1, __ATOMIC_RELAXED);
+
+	const uint64_t idx = __atomic_fetch_add(&trace_count, 1, __ATOMIC_RELAXED);
+
+#ifdef TASK_TRACE_RING
+	// The writer of the same slot one lap before may not be done yet. Wait for it and keep the
+	// newest record, which is published (seq) only after it is complete
+	t_trace_event *restrict event = &trace_buffer[idx % TASK_TRACE_SIZE];
+	while (__atomic_exchange_n(&event->lock, 1, __ATOMIC_ACQUIRE)) continue;
+
+	if (event->seq <= idx)
+	{
+		trace_event_set(event, begin, end, bytes, task, region, step);
+		__atomic_store_n(&event->seq, idx + 1, __ATOMIC_RELEASE);
+	}
+
+	__atomic_store_n(&event->lock, 0, __ATOMIC_RELEASE);
+#else
+	if (idx >= TASK_TRACE_SIZE) return;
+	trace_event_set(&trace_buffer[idx], begin, end, bytes, task, region, step);
+#endif
+}
+
+/*********************************************************************************************
+ Setup
+ *********************************************************************************************/
+
+void task_trace_init(void)
+{
+	trace_buffer = calloc(TASK_TRACE_SIZE, sizeof(t_trace_event));
+	if (!trace_buffer)
+	{
+		fprintf(stderr, "Error allocating the task trace buffer. Exiting...\n");
+		exit(1);
+	}
+
+	trace_count = 0;
+	trace_t0 = trace_clock();
+}
+
+void task_trace_finalize(void)
+{
+	free(trace_buffer);
+	trace_buffer = NULL;
+}
+
+/*********************************************************************************************
+ Critical path
+ *********************************************************************************************/
+
+typedef struct {
+	uint64_t begin, end;
+	uint64_t chain;   // Longest chain of dependent tasks ending at this one
+	int task, region, step;
+} t_trace_node;
+
+static int trace_cmp_begin(const void *a, const void *b)
+{
+	const t_trace_node *na = a, *nb = b;
+	if (na->begin != nb->begin) return na->begin < nb->begin ? -1 : 1;
+	return (na->end > nb->end) - (na->end < nb->end);
+}
+
+static int trace_cmp_end(const void *a, const void *b)
+{
+	const t_trace_node *na = *(t_trace_node *const *) a, *nb = *(t_trace_node *const *) b;
+	if (na->end != nb->end) return na->end < nb->end ? -1 : 1;
+	return (na > nb) - (na < nb);
+}
+
+// Longest chain of dependent tasks, weighted by their durations (the time step cannot be shorter
+// with any number of workers). A task depends on the tasks that finished before it started and
+// are either its predecessors in the graph of the time step (task_graph_closure) or tasks of the
+// previous time step, in the same or in a neighbour region, and on the global tasks (they run
+// after a taskwait). The tasks are visited in the order they started, and the ones that finished
+// before are added to a table with the longest chain ending at each (step, region, type of task)
+static uint64_t trace_critical_path(t_trace_node *nodes, const uint64_t n_nodes)
+{
+	if (n_nodes == 0) return 0;
+
+	bool precedes[TRACE_N_TASKS][TRACE_N_TASKS];
+	task_graph_closure(precedes);
+
+	int step_min = INT32_MAX, step_max = INT32_MIN, n_regions = 1;
+	for (uint64_t k = 0; k < n_nodes; k++)
+	{
+		if (nodes[k].step < step_min) step_min = nodes[k].step;
+		if (nodes[k].step > step_max) step_max = nodes[k].step;
+		if (nodes[k].region >= n_regions) n_regions = nodes[k].region + 1;
+	}
+
+	// Longest chain ending at each (step, region, type), the last column is for any type
+	const int n_cols = TRACE_N_TASKS + 1;
+	const int n_steps = step_max - step_min + 1;
+	uint64_t *chain = calloc((uint64_t) n_steps * n_regions * n_cols, sizeof(uint64_t));
+	t_trace_node **by_end = malloc(n_nodes * sizeof(t_trace_node *));
+	if (!chain || !by_end)
+	{
+		fprintf(stderr, "Error allocating the critical path buffers. Exiting...\n");
+		exit(1);
+	}
+
+	qsort(nodes, n_nodes, sizeof(t_trace_node), trace_cmp_begin);
+	for (uint64_t k = 0; k < n_nodes; k++) by_end[k] = &nodes[k];
+	qsort(by_end, n_nodes, sizeof(t_trace_node *), trace_cmp_end);
+
+	uint64_t global_chain = 0;   // Longest chain ending at a global task
+	uint64_t all_chain = 0;      // Longest chain ending at any task
+	uint64_t next = 0;
+
+	for (uint64_t k = 0; k < n_nodes; k++)
+	{
+		t_trace_node *node = &nodes[k];
+
+		// Add the tasks that finished before this one started
+		while (next < n_nodes && by_end[next]->end <= node->begin && by_end[next] < node)
+		{
+			const t_trace_node *done = by_end[next++];
+			if (done->chain > all_chain) all_chain = done->chain;
+
+			if (done->region < 0)
+			{
+				if (done->chain > global_chain) global_chain = done->chain;
+				continue;
+			}
+
+			uint64_t *row = &chain[((uint64_t) (done->step - step_min) * n_regions + done->region) *
+					n_cols];
+			if (done->chain > row[done->task]) row[done->task] = done->chain;
+			if (done->chain > row[TRACE_N_TASKS]) row[TRACE_N_TASKS] = done->chain;
+		}
+
+		// The global tasks wait for all the previous ones
+		uint64_t start = node->region < 0 ? all_chain : global_chain;
+
+		for (int r = node->region - 1; node->region >= 0 && r <= node->region + 1; r++)
+		{
+			if (r < 0 || r >= n_regions) continue;
+
+			const uint64_t *row = &chain[((uint64_t) (node->step - step_min) * n_regions + r) * n_cols];
+			for (int t = 0; t < TRACE_N_TASKS; t++)
+				if (precedes[t][node->task] && row[t] > start) start = row[t];
+
+			// Any task of the previous time step
+			if (node->step > step_min)
+			{
+				const uint64_t *prev = row - n_regions * n_cols;
+				if (prev[TRACE_N_TASKS] > start) start = prev[TRACE_N_TASKS];
+			}
+		}
+
+		node->chain = start + node->end - node->begin;
+	}
+
+	uint64_t critical_path = 0;
+	for (uint64_t k = 0; k < n_nodes; k++)
+		if (nodes[k].chain > critical_path) critical_path = nodes[k].chain;
+
+	free(by_end);
+	free(chain);
+
+	return critical_path;
+}
+
+/*********************************************************************************************
+ Output
+ *********************************************************************************************/
+
+// Save the trace (output/<sim_name>/trace.json) and print a summary of the tasks
+void task_trace_save(const char sim_name[64])
+{
+	char filename[128];
+	uint64_t total_time[TRACE_N_TASKS] = { 0 };
+	uint64_t n_tasks[TRACE_N_TASKS] = { 0 };
+
+	const uint64_t n_events = trace_count < TASK_TRACE_SIZE ? trace_count : TASK_TRACE_SIZE;
+#ifdef TASK_TRACE_RING
+	const uint64_t first = trace_count > TASK_TRACE_SIZE ? trace_count % TASK_TRACE_SIZE : 0;
+#else
+	const uint64_t first = 0;
+#endif
+
+	sprintf(filename, "output/%s/trace.json", sim_name);
+	FILE *file = fopen(filename, "w");
+	if (!file)
+	{
+		printf("Error on open file: %s", filename);
+		exit(1);
+	}
+
+	fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+	for (int w = 0; w < trace_n_workers; w++)
+		fprintf(file, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, "
+				"\"args\": {\"name\": \"Worker %d\"}},\n", w, w);
+
+	t_trace_node *nodes = malloc((n_events > 0 ? n_events : 1) * sizeof(t_trace_node));
+	if (!nodes)
+	{
+		fprintf(stderr, "Error allocating the critical path buffers. Exiting...\n");
+		exit(1);
+	}
+
+	uint64_t n_nodes = 0;
+	uint64_t t_min = UINT64_MAX, t_max = 0;
+
+	for (uint64_t k = 0; k < n_events; k++)
+	{
+		const t_trace_event *event = &trace_buffer[(first + k) % TASK_TRACE_SIZE];
+#ifdef TASK_TRACE_RING
+		if (__atomic_load_n(&event->seq, __ATOMIC_ACQUIRE) == 0) continue;   // Not published
+#endif
+		const uint64_t duration = event->end - event->begin;
+
+		total_time[event->task] += duration;
+		n_tasks[event->task]++;
+		if (event->begin < t_min) t_min = event->begin;
+		if (event->end > t_max) t_max = event->end;
+
+		nodes[n_nodes++] = (t_trace_node) {.begin = event->begin, .end = event->end,
+				.task = event->task, .region = event->region, .step = event->step};
+
+		// Timestamps in microseconds
+		fprintf(file, "%s{\"name\": \"%s\", \"cat\": \"task\", \"ph\": \"X\", \"pid\": 0, "
+				"\"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"region\": %d, \"step\": %d, "
+				"\"bytes\": %" PRIu64 "}}", n_nodes > 1 ? ",\n" : "", task_names[event->task],
+				event->worker, event->begin * 1.0e-3, duration * 1.0e-3, event->region, event->step,
+				event->bytes);
+	}
+
+	const uint64_t critical_path = trace_critical_path(nodes, n_nodes);
+	free(nodes);
+
+	uint64_t busy = 0;
+	for (int t = 0; t < TRACE_N_TASKS; t++)
+		busy += total_time[t];
+
+	// Chrome trace metadata (also available in the -DTEST builds, which print no summary)
+	fprintf(file, "\n], \"otherData\": {\"total_work_us\": %.3f, \"critical_path_us\": %.3f}}\n",
+			busy * 1.0e-3, critical_path * 1.0e-3);
+	fclose(file);
+
+#ifndef TEST
+	fprintf(stdout, "\nTask trace: %" PRIu64 " events saved in %s", n_nodes, filename);
+	if (trace_count > n_nodes)
+		fprintf(stdout, " (%" PRIu64 " events %s)", trace_count - n_nodes,
+#ifdef TASK_TRACE_RING
+				"overwritten");
+#else
+				"discarded");
+#endif
+	fprintf(stdout, "\n");
+
+	fprintf(stdout, "%-20s %10s %14s %14s\n", "task", "count", "total [ms]", "mean [us]");
+	for (int t = 0; t < TRACE_N_TASKS; t++)
+	{
+		if (n_tasks[t] == 0) continue;
+		fprintf(stdout, "%-20s %10" PRIu64 " %14.3f %14.3f\n", task_names[t], n_tasks[t],
+				total_time[t] * 1.0e-6, total_time[t] * 1.0e-3 / n_tasks[t]);
+	}
+
+	// Total work over the critical path is the highest speedup allowed by the dependencies, the
+	// average number of tasks running concurrently is the one achieved
+	fprintf(stdout, "Total work: %.3f ms, critical path: %.3f ms", busy * 1.0e-6,
+			critical_path * 1.0e-6);
+	if (critical_path > 0)
+		fprintf(stdout, " (available parallelism: %.2f)", (double) busy / critical_path);
+	fprintf(stdout, "\n");
+
+	if (t_max > t_min)
+		fprintf(stdout, "Average parallelism: %.2f (%d workers)\n", (double) busy / (t_max - t_min),
+				trace_n_workers);
+#endif
+}
+
+#endif
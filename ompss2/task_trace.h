@@ -0,0 +1,70 @@
+/*********************************************************************************************
+ ZPIC
+ task_trace.h
+
+ Task-level execution trace (begin/end, worker, region, time step and bytes touched), saved in
+ the Chrome trace-event format (chrome://tracing or https://ui.perfetto.dev).
+ Compile with -DENABLE_TASK_TRACE to enable it, otherwise the macros below are empty.
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef __TASK_TRACE__
+#define __TASK_TRACE__
+
+#include <stdint.h>
+
+enum trace_task {
+	TRACE_CURRENT_RESET, TRACE_SPEC_ADVANCE, TRACE_SPEC_MERGE, TRACE_CURRENT_REDUCTION_X,
+	TRACE_CURRENT_REDUCTION_Y, TRACE_CURRENT_SMOOTH_X, TRACE_CURRENT_SMOOTH_Y,
+	TRACE_CURRENT_UPDATE_GC, TRACE_EMF_ADVANCE, TRACE_EMF_UPDATE_GC, TRACE_DIAGNOSTICS,
+	TRACE_PATCH_ADVANCE, TRACE_ENVELOPE_REDUCTION_Y, TRACE_ENVELOPE_ADVANCE, TRACE_ENVELOPE_UPDATE_GC,
+	TRACE_SPEC_ADVANCE_BAND, TRACE_N_TASKS
+};
+
+// Region id for the work that is not associated with any region (e.g., diagnostics)
+#define TRACE_GLOBAL -1
+
+// Maximum number of events stored (-DTASK_TRACE_SIZE=<n>). By default, the events after the
+// buffer is full are discarded. With -DTASK_TRACE_RING, the buffer keeps the last events instead
+#ifndef TASK_TRACE_SIZE
+#define TASK_TRACE_SIZE (1 << 20)
+#endif
+
+#ifdef ENABLE_TASK_TRACE
+
+typedef struct {
+	uint64_t begin, end;   // Nanoseconds since task_trace_init
+	uint64_t bytes;        // Estimation of the bytes read and written by the task
+	int16_t task;
+	int16_t worker;
+	int32_t region;
+	int32_t step;
+#ifdef TASK_TRACE_RING
+	uint32_t lock;         // The slots are reused, only one writer at a time
+	uint64_t seq;          // Index of the event + 1, stored after the record is complete
+#endif
+} t_trace_event;
+
+void task_trace_init(void);
+void task_trace_finalize(void);
+
+uint64_t task_trace_begin(void);
+void task_trace_end(const uint64_t begin, const enum trace_task task, const int region,
+		const int step, const uint64_t bytes);
+
+void task_trace_save(const char sim_name[64]);
+
+#define TASK_TRACE_BEGIN() const uint64_t _trace_begin = task_trace_begin()
+#define TASK_TRACE_END(task, region, step, bytes) \
+	task_trace_end(_trace_begin, task, region, step, bytes)
+
+#else
+
+#define TASK_TRACE_BEGIN()
+#define TASK_TRACE_END(task, region, step, bytes)
+
+#endif
+
+#endif
@@ -13,9 +13,46 @@
 
 #include <stdint.h>
 
+// Ticks are nanoseconds of a monotonic clock (not affected by NTP adjustments)
 uint64_t timer_ticks( void );
 double timer_interval_seconds(uint64_t start, uint64_t end);
 double timer_cpu_seconds( void );
 double timer_resolution( void );
 
+/*********************************************************************************************
+ Phase timing
+ *********************************************************************************************/
+
+// The particle push and the current deposition are fused in the same loop in all versions,
+// so both are accounted in TIMER_PUSH. TIMER_EXCHANGE covers the particle transfers and the
+// messages between processes, while TIMER_GUARD_CELLS covers the local guard cell updates (and
+// the reset of the current)
+enum timer_phase {
+	TIMER_PUSH, TIMER_SORT, TIMER_FILTER, TIMER_SOLVE, TIMER_GUARD_CELLS, TIMER_EXCHANGE,
+	TIMER_DIAGNOSTICS, TIMER_N_PHASES
+};
+
+// Maximum number of threads with their own accumulators (the remaining share the slots)
+#ifndef TIMER_MAX_WORKERS
+#define TIMER_MAX_WORKERS 256
+#endif
+
+typedef struct {
+	double total[TIMER_N_PHASES];    // Sum over all workers (seconds)
+	double max[TIMER_N_PHASES];      // Slowest worker (seconds)
+	uint64_t count[TIMER_N_PHASES];  // Number of calls
+	int n_workers;
+} t_phase_timings;
+
+// timer.c is the same in all versions. The reduction across processes is done by the versions
+// with multiple ranks (sim_reduce_timings in mpi_ompss2 and gaspi_ompss2)
+
+// Add the time elapsed since start (timer_ticks) to the phase of the calling thread
+void timer_phase_add(const enum timer_phase phase, const uint64_t start);
+
+double timer_phase_seconds(const enum timer_phase phase);
+void timer_phase_collect(t_phase_timings *timings);
+void timer_phase_report(const t_phase_timings *timings);
+void timer_phase_reset(void);
+
 #endif
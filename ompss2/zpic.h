@@ -18,6 +18,26 @@ typedef struct {
 	t_fld x, y, z;
 } t_vfld;
 
+/* Order of the particle shape (1 - linear, 2 - quadratic, 3 - cubic), set at compile time */
+
+#ifndef SHAPE_ORDER
+#define SHAPE_ORDER 1
+#endif
+
+#if SHAPE_ORDER < 1 || SHAPE_ORDER > 3
+#error "Invalid particle shape order (SHAPE_ORDER must be 1, 2 or 3)"
+#endif
+
+/* Guard cells of the field and current grids ([lower/upper]) needed by the particle shape */
+
+#if SHAPE_ORDER == 1
+#define SHAPE_GC_LOWER 1
+#define SHAPE_GC_UPPER 2
+#else
+#define SHAPE_GC_LOWER 2
+#define SHAPE_GC_UPPER 3
+#endif
+
 /* ANSI C does not define math constants */
 
 #ifndef M_PI
@@ -16,6 +16,7 @@
 #include <string.h>
 #include <cuda.h>
 
+#include "timer.h"
 #include "utilities.h"
 #include "zdf.h"
 
@@ -86,6 +87,7 @@ void current_overlap_zone(t_current *current, t_current *current_below, const in
 // Set the current buffer to zero (OpenACC)
 void current_zero_openacc(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	current->iter++;
 
 	// zero fields
@@ -96,6 +98,8 @@ void current_zero_openacc(t_current *current)
 		current->J_buf[i].y = 0.0f;
 		current->J_buf[i].z = 0.0f;
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 /*********************************************************************************************
@@ -105,6 +109,7 @@ void current_zero_openacc(t_current *current)
 // Each region is only responsible to do the reduction operation (y direction) in its bottom edge (OpenAcc)
 void current_reduction_y_openacc(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = current->nrow;
 	t_vfld *restrict const J = current->J;
 	t_vfld *restrict const J_overlap = current->J_below;
@@ -121,11 +126,14 @@ void current_reduction_y_openacc(t_current *current)
 			J_overlap[i + (j + current->gc[1][0]) * nrow] = J[i + j * nrow];
 		}
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 // Current reduction between ghost cells in the x direction (OpenAcc)
 void current_reduction_x_openacc(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = current->nrow;
 	t_vfld *restrict const J = current->J;
 	t_vfld *restrict const J_overlap = &current->J[current->nx[0]];
@@ -142,11 +150,14 @@ void current_reduction_x_openacc(t_current *current)
 			J_overlap[i + j * nrow] = J[i + j * nrow];
 		}
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 // Update the ghost cells in the y direction (only the bottom edge, OpenAcc)
 void current_gc_update_y_openacc(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = current->nrow;
 	t_vfld *restrict const J = current->J;
 	t_vfld *restrict const J_overlap = current->J_below;
@@ -165,6 +176,8 @@ void current_gc_update_y_openacc(t_current *current)
 			}
 		}
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 /*********************************************************************************************
@@ -175,6 +188,7 @@ void current_gc_update_y_openacc(t_current *current)
 // Then, pass a compensation filter (if applicable). OpenAcc Task
 void current_smooth_x_openacc(t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const int size = current->total_size;
 	const int nrow = current->nrow;
 	t_vfld *restrict const J = current->J;
@@ -276,6 +290,8 @@ void current_smooth_x_openacc(t_current *current)
 			}
 		}
 	}
+
+	timer_phase_add(TIMER_FILTER, t0);
 }
 
 // Apply the filter in the y direction (CPU)
@@ -572,6 +572,7 @@ void emf_update_gc_x_openacc(t_vfld *restrict E, t_vfld *restrict B, const int n
 // Update ghost cells in the below overlap zone (Y direction, OpenAcc)
 void emf_update_gc_y_openacc(t_emf *emf)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nrow = emf->nrow;
 
 	t_vfld *const restrict E = emf->E;
@@ -596,6 +597,8 @@ void emf_update_gc_y_openacc(t_emf *emf)
 			}
 		}
 	}
+
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 // Move the simulation window
@@ -646,6 +649,7 @@ void emf_move_window_openacc(t_vfld *restrict E, t_vfld *restrict B, const int n
 // Perform the local integration of the fields (and post processing). OpenAcc Task
 void emf_advance_openacc(t_emf *emf, const t_current *current)
 {
+	const uint64_t t0 = timer_ticks();
 	const int queue = nanos6_get_current_acc_queue();
 
 	const t_fld dt = emf->dt;
@@ -674,5 +678,7 @@ void emf_advance_openacc(t_emf *emf, const t_current *current)
 		// Update guard cells with new values
 		emf_update_gc_x_openacc(emf->E, emf->B, emf->nrow, emf->nx, emf->gc, queue);
 	}
+
+	timer_phase_add(TIMER_SOLVE, t0);
 }
 
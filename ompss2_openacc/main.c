@@ -30,7 +30,11 @@
 // Simulation parameters (naming scheme : <type>-<number of particles>-<grid size x>-<grid size y>.c)
 
 /* Strong scaling */
+#ifdef INPUT
+#include INPUT
+#else
 #include "input/weibel-2000-151M-2048-2048.c"
+#endif
 //#include "input/lwfa-8000-74M-4000-2048.c"
 
 /* Weak scaling */
@@ -61,7 +65,7 @@ int main(int argc, const char *argv[])
 	fprintf(stderr, "Starting simulation ...\n\n");
 #endif
 
-	size_t t0, t1;
+	uint64_t t0, t1;
 	t0 = timer_ticks();
 
 	for (n = 0, t = 0.0; t <= sim.tmax; n++, t = n * sim.dt)
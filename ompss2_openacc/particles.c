@@ -20,6 +20,7 @@
 #include <vector_types.h>
 
 #include "random.h"
+#include "timer.h"
 #include "utilities.h"
 #include "zdf.h"
 
@@ -765,6 +766,7 @@ void advance_part_momentum(float3 *part_velocity, t_vfld Ep, t_vfld Bp, const t_
 void spec_advance_openacc(t_species *restrict const spec, const t_emf *restrict const emf,
 		t_current *restrict const current, const int limits_y[2])
 {
+	const uint64_t t0 = timer_ticks();
 	const t_part_data tem = 0.5 * spec->dt / spec->m_q;
 	const t_part_data dt_dx = spec->dt / spec->dx[0];
 	const t_part_data dt_dy = spec->dt / spec->dx[1];
@@ -930,6 +932,8 @@ void spec_advance_openacc(t_species *restrict const spec, const t_emf *restrict
 
 	// Advance internal iteration number
 	spec->iter++;
+
+	timer_phase_add(TIMER_PUSH, t0);
 }
 
 /*********************************************************************************************
@@ -939,6 +943,7 @@ void spec_advance_openacc(t_species *restrict const spec, const t_emf *restrict
 // Shift the particle left and inject particles in the rightmost cells. OpenAcc Task
 void spec_move_window_openacc(t_species *restrict spec, const int limits_y[2], const int device)
 {
+	const uint64_t t0 = timer_ticks();
 	// Move window
 	if (spec->iter * spec->dt > spec->dx[0] * (spec->n_move + 1))
 	{
@@ -963,11 +968,14 @@ void spec_move_window_openacc(t_species *restrict spec, const int limits_y[2], c
 					spec->dx, spec->n_move, spec->ufl, spec->uth);
 		}else spec->incoming_part[2].size = np_inj; // Reuse the temporary vector (THIS ONLY WORKS IF THE INJECTED PARTICLES HAVE NO MOMENTUM)
 	}
+
+	timer_phase_add(TIMER_PUSH, t0);
 }
 
 // Transfer particles between regions (if applicable). OpenAcc Task
 void spec_check_boundaries_openacc(t_species *spec, const int limits_y[2], const int device)
 {
+	const uint64_t t0 = timer_ticks();
 	const int nx0 = spec->nx[0];
 	const int nx1 = spec->nx[1];
 
@@ -1099,6 +1107,8 @@ void spec_check_boundaries_openacc(t_species *spec, const int limits_y[2], const
 			}
 		}
 	}
+
+	timer_phase_add(TIMER_EXCHANGE, t0);
 }
 
 /*********************************************************************************************
@@ -1477,6 +1487,7 @@ void spec_sort_particles(t_part_vector *part_vector, t_part_vector incoming_part
 
 void spec_sort_openacc(t_species *spec, const int limits_y[2], const int device)
 {
+	const uint64_t t0 = timer_ticks();
 	const int64_t old_size = spec->main_vector.size;
 	const int n_tiles = spec->n_tiles_x * spec->n_tiles_y;
 	spec->mv_part_offset[n_tiles] = 0;
@@ -1528,6 +1539,8 @@ void spec_sort_openacc(t_species *spec, const int limits_y[2], const int device)
 	acc_free(counter);
 	acc_free(target_idx);
 	acc_free(source_idx);
+
+	timer_phase_add(TIMER_SORT, t0);
 }
 
 /*********************************************************************************************
@@ -264,7 +264,7 @@ void sim_report_energy(t_simulation *sim)
 	}
 }
 
-void sim_timings(t_simulation *sim, size_t t0, size_t t1, const unsigned int n_iterations)
+void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1, const unsigned int n_iterations)
 {
 	double npart = 0;
 	float sim_time = timer_interval_seconds(t0, t1);
@@ -287,6 +287,10 @@ void sim_timings(t_simulation *sim, size_t t0, size_t t1, const unsigned int n_i
 	fprintf(stdout, "Performance: %f Mpart/s", npart / sim_time / 1E6);
 	fprintf(stdout, "\n");
 
+	t_phase_timings timings;
+	timer_phase_collect(&timings);
+	timer_phase_report(&timings);
+
 #else
 #ifdef ENABLE_PREFETCH
 	printf("%s,%d,%d,1,%f,%f\n", sim->name, sim->n_regions, acc_get_num_devices(DEVICE_TYPE), sim_time, npart / sim_time / 1E6);
@@ -341,7 +345,7 @@ void sim_report_grid_zdf(t_simulation *sim, enum report_grid_type type, const in
 
 // Save a particle property to a ZDF file
 void sim_report_spec_zdf(t_simulation *sim, const int species, const int rep_type,
-		const int pha_nx[2], const float pha_range[][2])
+		const int pha_nx[], const float pha_range[][2])
 {
 	t_region *regions = sim->regions;
 	const int n_regions = sim->n_regions;
@@ -7,42 +7,141 @@
  *
  */
 
+#define _GNU_SOURCE
+
 #include "timer.h"
+#include <stdio.h>
 #include <stdlib.h>
-#include <sys/time.h>
+#include <string.h>
+#include <time.h>
+
+// CLOCK_MONOTONIC_RAW is Linux specific
+#ifdef CLOCK_MONOTONIC_RAW
+#define TIMER_CLOCK CLOCK_MONOTONIC_RAW
+#else
+#define TIMER_CLOCK CLOCK_MONOTONIC
+#endif
 
-size_t timer_ticks()
+uint64_t timer_ticks()
 {
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
+	struct timespec ts;
+	clock_gettime(TIMER_CLOCK, &ts);
 
-	return ((size_t) tv.tv_sec) * 1000000 + (size_t) tv.tv_usec;
+	return ((uint64_t) ts.tv_sec) * 1000000000 + (uint64_t) ts.tv_nsec;
 }
 
-double timer_interval_seconds(size_t start, size_t end)
+double timer_interval_seconds(uint64_t start, uint64_t end)
 {
-	return (end - start) * 1.0e-6;
+	return (end - start) * 1.0e-9;
 }
 
 double timer_cpu_seconds()
 {
-	struct timeval tv;
-	double wtime;
-	gettimeofday(&tv, NULL);
-	wtime = tv.tv_sec;
-	wtime += (double) tv.tv_usec * 1.0e-6;
-	return wtime;
+	struct timespec ts;
+	clock_gettime(TIMER_CLOCK, &ts);
+
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1.0e-9;
 }
 
 double timer_resolution()
 {
-	struct timeval tv1, tv2;
+	struct timespec ts;
+	clock_getres(TIMER_CLOCK, &ts);
+
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1.0e-9;
+}
+
+/*********************************************************************************************
+ Phase timing
+ *********************************************************************************************/
+
+static const char *phase_names[TIMER_N_PHASES] = {
+	"Push + deposit", "Sort", "Filter", "Field solve", "Guard cells", "Exchange", "Diagnostics"
+};
+
+// Each worker accumulates in its own cache line(s) to avoid false sharing
+typedef struct {
+	uint64_t time[TIMER_N_PHASES];
+	uint64_t count[TIMER_N_PHASES];
+} __attribute__((aligned(64))) t_phase_slot;
+
+static t_phase_slot phase_slots[TIMER_MAX_WORKERS];
+static int phase_n_workers = 0;
+
+// Worker id (assigned in the first call of each thread)
+static __thread int phase_worker = -1;
+
+void timer_phase_add(const enum timer_phase phase, const uint64_t start)
+{
+	const uint64_t elapsed = timer_ticks() - start;
+
+	if (phase_worker < 0)
+		phase_worker = __atomic_fetch_add(&phase_n_workers, 1, __ATOMIC_RELAXED);
+
+	// The slot is only shared if there are more than TIMER_MAX_WORKERS threads
+	t_phase_slot *restrict slot = &phase_slots[phase_worker % TIMER_MAX_WORKERS];
+	__atomic_fetch_add(&slot->time[phase], elapsed, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&slot->count[phase], 1, __ATOMIC_RELAXED);
+}
+
+// Total time of a phase (sum over all workers, seconds)
+double timer_phase_seconds(const enum timer_phase phase)
+{
+	uint64_t total = 0;
+	for (int w = 0; w < TIMER_MAX_WORKERS; w++)
+		total += __atomic_load_n(&phase_slots[w].time[phase], __ATOMIC_RELAXED);
 
-	gettimeofday(&tv1, NULL);
-	do
+	return total * 1.0e-9;
+}
+
+// Reduce the accumulators of all workers. Must be called when no phase is running
+void timer_phase_collect(t_phase_timings *timings)
+{
+	const int n_slots = phase_n_workers < TIMER_MAX_WORKERS ? phase_n_workers : TIMER_MAX_WORKERS;
+
+	for (int p = 0; p < TIMER_N_PHASES; p++)
 	{
-		gettimeofday(&tv2, NULL);
-	} while (tv1.tv_usec == tv2.tv_usec);
+		uint64_t total = 0, max = 0, count = 0;
+
+		for (int w = 0; w < n_slots; w++)
+		{
+			total += phase_slots[w].time[p];
+			count += phase_slots[w].count[p];
+			if (phase_slots[w].time[p] > max) max = phase_slots[w].time[p];
+		}
 
-	return (double) (tv2.tv_usec - tv1.tv_usec) * 1.0e-6;
+		timings->total[p] = total * 1.0e-9;
+		timings->max[p] = max * 1.0e-9;
+		timings->count[p] = count;
+	}
+
+	timings->n_workers = phase_n_workers;
+}
+
+void timer_phase_report(const t_phase_timings *timings)
+{
+	double sum = 0;
+	for (int p = 0; p < TIMER_N_PHASES; p++)
+		sum += timings->total[p];
+
+	fprintf(stdout, "\nPhase timings (workers: %d):\n", timings->n_workers);
+	fprintf(stdout, "%-16s %12s %14s %14s %14s %8s\n", "phase", "calls", "total [s]", "per worker [s]",
+			"max worker [s]", "%");
+
+	for (int p = 0; p < TIMER_N_PHASES; p++)
+	{
+		if (timings->count[p] == 0) continue;
+
+		fprintf(stdout, "%-16s %12llu %14.6f %14.6f %14.6f %8.2f\n", phase_names[p],
+				(unsigned long long) timings->count[p], timings->total[p],
+				timings->total[p] / timings->n_workers, timings->max[p],
+				sum > 0 ? 100.0 * timings->total[p] / sum : 0.0);
+	}
+
+	fprintf(stdout, "\n");
+}
+
+void timer_phase_reset(void)
+{
+	memset(phase_slots, 0, sizeof(phase_slots));
 }
@@ -0,0 +1,385 @@
+/*********************************************************************************************
+ ZPIC
+ bench.c
+
+ Microbenchmarks for the particle sort (tile organization) and the prefix sum (checked against
+ a sequential scan). Build with "make bench" to run the OpenACC kernels on the host (GCC
+ -fopenacc host fallback, no CUDA required).
+
+ Usage: ./bench [grid size] [particles per cell (per direction)] [repetitions]
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "zpic.h"
+#include "particles.h"
+#include "random.h"
+#include "timer.h"
+#include "utilities.h"
+
+// Same parameters as the decks in input/weak
+#define BENCH_BOX 51.2f
+#define BENCH_DT 0.07f
+
+// Synthetic particle distributions
+typedef struct {
+	const char *name;
+	t_part_data uth;    // Thermal momentum
+	bool shuffle;       // Random particle order (instead of the cell order of the injection)
+} t_bench_dist;
+
+static const t_bench_dist distributions[] = {
+	{ .name = "cold-sorted", .uth = 0.0f, .shuffle = false },
+	{ .name = "cold-shuffled", .uth = 0.0f, .shuffle = true },
+	{ .name = "warm-sorted", .uth = 0.01f, .shuffle = false },
+	{ .name = "warm-shuffled", .uth = 0.01f, .shuffle = true },
+	{ .name = "hot-sorted", .uth = 0.1f, .shuffle = false },
+	{ .name = "hot-shuffled", .uth = 0.1f, .shuffle = true }
+};
+
+typedef struct {
+	t_species spec;
+	int limits_y[2];
+
+	// Initial particles (injection order or shuffled)
+	t_part_vector initial;
+
+	// Particles organized in tiles and then moved by one time step
+	t_part_vector moved;
+	int *tile_offset;
+} t_bench;
+
+// Prefix sum (random histogram-like input)
+typedef struct {
+	int size;
+	int *input;
+	int *vector;
+	t_scratch_pool pool;
+} t_bench_scan;
+
+// Sizes of the prefix sum benchmark (the number of tiles + 1 of the regions is typically small)
+static const int scan_sizes[] = { 33, 1025, 65537, 1 << 20, (1 << 22) + 3 };
+
+typedef struct {
+	double min, median, mean, stddev;
+} t_bench_stats;
+
+/*********************************************************************************************
+ Setup
+ *********************************************************************************************/
+
+// Fisher-Yates shuffle of the particle vector
+void bench_shuffle(t_part_vector *vector)
+{
+	t_part_vector temp;
+	part_vector_alloc(&temp, 1);
+
+	for (int i = vector->size - 1; i > 0; i--)
+	{
+		int k = rand_uint32() % (i + 1);
+		part_vector_assign_part(vector, i, &temp, 0);
+		part_vector_assign_part(vector, k, vector, i);
+		part_vector_assign_part(&temp, 0, vector, k);
+	}
+
+	part_vector_free(&temp);
+}
+
+// Copy the particle vector (size included)
+void bench_copy(const t_part_vector *source, t_part_vector *target)
+{
+	part_vector_memcpy(source, target, 0, source->size);
+	target->size = source->size;
+}
+
+// Move the particles by one time step (periodic boundaries, single region)
+void bench_move(t_bench *bench)
+{
+	t_part_vector *vector = &bench->spec.main_vector;
+	const t_part_data dt_dx = bench->spec.dt / bench->spec.dx[0];
+	const t_part_data dt_dy = bench->spec.dt / bench->spec.dx[1];
+
+	for (int i = 0; i < vector->size; i++)
+	{
+		t_part_data rg = 1.0f / sqrtf(1.0f + vector->ux[i] * vector->ux[i]
+				+ vector->uy[i] * vector->uy[i] + vector->uz[i] * vector->uz[i]);
+		t_part_data x1 = vector->x[i] + dt_dx * rg * vector->ux[i];
+		t_part_data y1 = vector->y[i] + dt_dy * rg * vector->uy[i];
+		int di = LTRIM(x1);
+		int dj = LTRIM(y1);
+
+		vector->x[i] = x1 - di;
+		vector->y[i] = y1 - dj;
+		vector->ix[i] += di;
+		vector->iy[i] += dj;
+
+		if (vector->ix[i] < 0) vector->ix[i] += bench->spec.nx[0];
+		else if (vector->ix[i] >= bench->spec.nx[0]) vector->ix[i] -= bench->spec.nx[0];
+
+		if (vector->iy[i] < 0) vector->iy[i] += bench->spec.nx[1];
+		else if (vector->iy[i] >= bench->spec.nx[1]) vector->iy[i] -= bench->spec.nx[1];
+	}
+}
+
+void bench_new(t_bench *bench, const int nx, const int ppc, const t_bench_dist *dist)
+{
+	int grid[2] = { nx, nx };
+	int spec_ppc[2] = { ppc, ppc };
+	t_part_data box[2] = { BENCH_BOX, BENCH_BOX };
+	t_part_data ufl[3] = { 0.0f, 0.0f, 0.0f };
+	t_part_data uth[3] = { dist->uth, dist->uth, dist->uth };
+
+	set_rand_seed(12345, 67890);
+
+	// A single region covering the whole simulation space
+	bench->limits_y[0] = 0;
+	bench->limits_y[1] = nx;
+
+	spec_new(&bench->spec, "electrons", -1.0f, spec_ppc, ufl, uth, grid, box, BENCH_DT, NULL, nx);
+	const int range[][2] = { { 0, nx }, { 0, nx } };
+	spec_inject_particles(&bench->spec.main_vector, range, spec_ppc, &bench->spec.density,
+			bench->spec.dx, 0, ufl, uth);
+
+	if (dist->shuffle) bench_shuffle(&bench->spec.main_vector);
+
+	const int n_tiles = bench->spec.n_tiles_x * bench->spec.n_tiles_y;
+	const int size_max = bench->spec.main_vector.size_max;
+
+	part_vector_alloc(&bench->initial, size_max);
+	part_vector_alloc(&bench->moved, size_max);
+	bench->tile_offset = malloc((n_tiles + 1) * sizeof(int));
+
+	bench_copy(&bench->spec.main_vector, &bench->initial);
+
+	// Organize in tiles and advance the particles to get the input of the tile sort
+	spec_organize_in_tiles(&bench->spec, bench->limits_y);
+	bench_move(bench);
+
+	bench_copy(&bench->spec.main_vector, &bench->moved);
+	memcpy(bench->tile_offset, bench->spec.tile_offset, (n_tiles + 1) * sizeof(int));
+}
+
+void bench_delete(t_bench *bench)
+{
+	spec_delete(&bench->spec);
+	part_vector_free(&bench->initial);
+	part_vector_free(&bench->moved);
+	free(bench->tile_offset);
+}
+
+// Restore the initial particles (before the organization in tiles)
+void bench_reset_organize(void *data)
+{
+	t_bench *bench = data;
+	const int n_tiles = bench->spec.n_tiles_x * bench->spec.n_tiles_y;
+
+	bench_copy(&bench->initial, &bench->spec.main_vector);
+	memset(bench->spec.tile_offset, 0, (n_tiles + 1) * sizeof(int));
+}
+
+// Restore the particles organized in tiles and moved by one time step
+void bench_reset_sort(void *data)
+{
+	t_bench *bench = data;
+	const int n_tiles = bench->spec.n_tiles_x * bench->spec.n_tiles_y;
+
+	bench_copy(&bench->moved, &bench->spec.main_vector);
+	memcpy(bench->spec.tile_offset, bench->tile_offset, (n_tiles + 1) * sizeof(int));
+}
+
+/*********************************************************************************************
+ Kernels
+ *********************************************************************************************/
+
+void bench_organize(void *data)
+{
+	t_bench *bench = data;
+	spec_organize_in_tiles(&bench->spec, bench->limits_y);
+}
+
+void bench_sort(void *data)
+{
+	t_bench *bench = data;
+	spec_sort_openacc(&bench->spec, bench->limits_y, 0);
+}
+
+/*********************************************************************************************
+ Prefix Sum
+ *********************************************************************************************/
+
+void bench_scan_new(t_bench_scan *scan, const int size)
+{
+	scan->size = size;
+	scan->input = malloc(size * sizeof(int));
+	scan->vector = malloc(size * sizeof(int));
+	scratch_pool_init(&scan->pool, false);
+
+	for (int i = 0; i < size; i++)
+		scan->input[i] = rand_uint32() % 64;
+}
+
+void bench_scan_delete(t_bench_scan *scan)
+{
+	free(scan->input);
+	free(scan->vector);
+	scratch_pool_free(&scan->pool);
+}
+
+void bench_reset_scan(void *data)
+{
+	t_bench_scan *scan = data;
+	memcpy(scan->vector, scan->input, scan->size * sizeof(int));
+}
+
+void bench_scan_openacc(void *data)
+{
+	t_bench_scan *scan = data;
+	scratch_pool_reset(&scan->pool);
+	prefix_sum_openacc(scan->vector, scan->size, &scan->pool);
+}
+
+void bench_scan_openmp(void *data)
+{
+	t_bench_scan *scan = data;
+	prefix_sum_openmp(scan->vector, scan->size);
+}
+
+// Compare the prefix sum with the sequential one (exit with an error if they differ)
+void bench_scan_check(t_bench_scan *scan, const char *kernel_name, void (*kernel)(void*))
+{
+	bench_reset_scan(scan);
+	kernel(scan);
+
+	int acc = 0;
+	for (int i = 0; i < scan->size; i++)
+	{
+		if (scan->vector[i] != acc)
+		{
+			fprintf(stderr, "%s (size %d): wrong value at %d (expected %d, got %d)\n",
+					kernel_name, scan->size, i, acc, scan->vector[i]);
+			exit(1);
+		}
+		acc += scan->input[i];
+	}
+}
+
+/*********************************************************************************************
+ Measurement
+ *********************************************************************************************/
+
+int compare_double(const void *a, const void *b)
+{
+	const double x = *(const double*) a;
+	const double y = *(const double*) b;
+	return (x > y) - (x < y);
+}
+
+// Compute the statistics of the samples (the sample vector is sorted in place)
+void bench_stats(double *samples, const int n, t_bench_stats *stats)
+{
+	qsort(samples, n, sizeof(double), compare_double);
+
+	stats->min = samples[0];
+	stats->median = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+
+	stats->mean = 0;
+	for (int i = 0; i < n; i++)
+		stats->mean += samples[i];
+	stats->mean /= n;
+
+	stats->stddev = 0;
+	for (int i = 0; i < n; i++)
+		stats->stddev += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+	stats->stddev = n > 1 ? sqrt(stats->stddev / (n - 1)) : 0;
+}
+
+// Run the kernel several times (after a warm-up run) and report the time per unit of work
+void bench_run(void *bench, const char *kernel_name, const char *dist_name,
+		void (*kernel)(void*), void (*reset)(void*), const double work,
+		const char *unit, const int reps)
+{
+	double samples[reps];
+	t_bench_stats stats;
+
+	for (int r = -1; r < reps; r++)
+	{
+		if (reset) reset(bench);
+
+		uint64_t t0 = timer_ticks();
+		kernel(bench);
+		uint64_t t1 = timer_ticks();
+
+		if (r >= 0) samples[r] = 1.0e9 * timer_interval_seconds(t0, t1) / work;
+	}
+
+	bench_stats(samples, reps, &stats);
+	printf("%-22s %-14s %10.3f %10.3f %10.3f %10.3f  %s\n", kernel_name, dist_name, stats.min,
+			stats.median, stats.mean, stats.stddev, unit);
+}
+
+/*********************************************************************************************
+ Main
+ *********************************************************************************************/
+
+int main(int argc, const char *argv[])
+{
+	const int nx = argc > 1 ? atoi(argv[1]) : 512;
+	const int ppc = argc > 2 ? atoi(argv[2]) : 2;
+	const int reps = argc > 3 ? atoi(argv[3]) : 10;
+
+	if (nx <= 0 || ppc <= 0 || reps <= 0)
+	{
+		fprintf(stderr, "Usage: %s [grid size] [particles per cell (per direction)] [repetitions]\n",
+				argv[0]);
+		exit(1);
+	}
+
+	printf("Grid: %d x %d, particles per cell: %d x %d, repetitions: %d\n\n", nx, nx, ppc, ppc, reps);
+	printf("%-22s %-14s %10s %10s %10s %10s  %s\n", "kernel", "distribution", "min", "median",
+			"mean", "stddev", "unit");
+
+	t_bench bench;
+	const int n_dist = sizeof(distributions) / sizeof(distributions[0]);
+
+	for (int d = 0; d < n_dist; d++)
+	{
+		const char *name = distributions[d].name;
+		bench_new(&bench, nx, ppc, &distributions[d]);
+
+		const double np = bench.initial.size;
+
+		bench_run(&bench, "spec_organize_in_tiles", name, bench_organize, bench_reset_organize, np,
+				"ns/part", reps);
+		bench_run(&bench, "spec_sort_openacc", name, bench_sort, bench_reset_sort, np, "ns/part", reps);
+
+		bench_delete(&bench);
+	}
+
+	t_bench_scan scan;
+	const int n_sizes = sizeof(scan_sizes) / sizeof(scan_sizes[0]);
+
+	for (int n = 0; n < n_sizes; n++)
+	{
+		char name[32];
+		sprintf(name, "n=%d", scan_sizes[n]);
+		bench_scan_new(&scan, scan_sizes[n]);
+
+		bench_scan_check(&scan, "prefix_sum_openacc", bench_scan_openacc);
+		bench_scan_check(&scan, "prefix_sum_openmp", bench_scan_openmp);
+
+		bench_run(&scan, "prefix_sum_openacc", name, bench_scan_openacc, bench_reset_scan,
+				scan.size, "ns/elem", reps);
+		bench_run(&scan, "prefix_sum_openmp", name, bench_scan_openmp, bench_reset_scan,
+				scan.size, "ns/elem", reps);
+
+		bench_scan_delete(&scan);
+	}
+
+	return 0;
+}
@@ -14,7 +14,6 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
-#include <cuda.h>
 
 #include "utilities.h"
 #include "zdf.h"
@@ -14,7 +14,6 @@
 #include <assert.h>
 #include <string.h>
 #include <math.h>
-#include <cuda.h>
 
 #include "emf.h"
 #include "zdf.h"
@@ -684,19 +683,29 @@ void emf_move_window_openacc(t_emf *emf)
 void emf_advance_openacc(t_emf *emf, const t_current *current, const int device)
 {
 	const float dt = emf->dt;
+	uint64_t t0 = timer_ticks();
 
 	// Advance EM field using Yee algorithm modified for having E and B time centered
 	yee_b_openacc(emf, dt / 2.0f);
 	yee_e_openacc(emf, current, dt);
 	yee_b_openacc(emf, dt / 2.0f);
 
+	timer_phase_add(TIMER_SOLVE, t0);
+
 	// Update guard cells with new values
+	t0 = timer_ticks();
 	emf_gc_x_openacc(emf);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 
 	// Advance internal iteration number
 	emf->iter += 1;
 
 	// Move simulation window if needed
-	if (emf->moving_window) emf_move_window_openacc(emf);
+	if (emf->moving_window)
+	{
+		t0 = timer_ticks();
+		emf_move_window_openacc(emf);
+		timer_phase_add(TIMER_SOLVE, t0);
+	}
 }
 
@@ -19,6 +19,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <omp.h>
 
 #include "zpic.h"
@@ -28,11 +29,16 @@
 #include "particles.h"
 #include "timer.h"
 #include "utilities.h"
+#include "autotune.h"
 
 // Simulation parameters (naming scheme : <type>-<number of particles>-<grid size x>-<grid size y>.c)
 
 /* Strong scaling */
+#ifdef INPUT
+#include INPUT
+#else
 #include "input/weibel-2000-151M-2048-2048.c"
+#endif
 //#include "input/lwfa-8000-74M-4000-2048.c"
 
 /* Weak scaling */
@@ -45,18 +51,19 @@ int main(int argc, const char *argv[])
 {
 	if(argc != 2)
 	{
-		fprintf(stderr, "Wrong arguments. Expected: <number of regions>");
+		fprintf(stderr, "Wrong arguments. Expected: <number of regions | auto>");
 		exit(1);
 	}
 
 	// Initialize simulation
 	t_simulation sim;
-	sim_init(&sim, atoi(argv[1]));
+	if (!strcmp(argv[1], "auto")) autotune_regions(&sim);
+	else sim_init(&sim, atoi(argv[1]));
 
 	// Run simulation
 	int n;
 	float t;
-	const int num_threads = MIN_VALUE(atoi(argv[1]), omp_get_max_threads());
+	const int num_threads = MIN_VALUE(sim.n_regions, omp_get_max_threads());
 
 #ifndef TEST
 	fprintf(stderr, "Starting simulation ...\n\n");
@@ -73,7 +80,12 @@ int main(int argc, const char *argv[])
 			#pragma omp master
 			{
 				fprintf(stderr, "n = %i, t = %f\n", n, t);
- 				if (report(n, sim.ndump)) sim_report(&sim);
+				if (report(n, sim.ndump))
+				{
+					const uint64_t t_diag = timer_ticks();
+					sim_report(&sim);
+					timer_phase_add(TIMER_DIAGNOSTICS, t_diag);
+				}
 				sim.iter++;
 			}
 
@@ -103,6 +103,7 @@ void part_vector_memcpy(const t_part_vector *source, t_part_vector *target, cons
 
 void part_vector_mem_advise(t_part_vector *vector, const int advise, const int device)
 {
+#ifndef DISABLE_CUDA
 	cuMemAdvise(vector->ix, vector->size_max * sizeof(int), advise, device);
 	cuMemAdvise(vector->iy, vector->size_max * sizeof(int), advise, device);
 	cuMemAdvise(vector->x, vector->size_max * sizeof(t_part_data), advise, device);
@@ -111,6 +112,7 @@ void part_vector_mem_advise(t_part_vector *vector, const int advise, const int d
 	cuMemAdvise(vector->uy, vector->size_max * sizeof(t_part_data), advise, device);
 	cuMemAdvise(vector->uz, vector->size_max * sizeof(t_part_data), advise, device);
 	cuMemAdvise(vector->invalid, vector->size_max * sizeof(bool), advise, device);
+#endif
 }
 
 // Prefetching for particle vector
@@ -282,7 +284,7 @@ void spec_organize_in_tiles(t_species *spec, const int limits_y[2])
 	}
 
 	// Prefix sum to find the initial idx of each tile in the particle vector
-	prefix_sum_serial(tile_offset, n_tiles_x * n_tiles_y + 1);
+	prefix_sum_openmp(tile_offset, n_tiles_x * n_tiles_y + 1);
 
 	// Calculate the target position of each particle
 	#pragma omp parallel for
@@ -398,6 +400,19 @@ void spec_new(t_species *spec, char name[], const t_part_data m_q, const int ppc
 
 	const int n_tiles = spec->n_tiles_x * spec->n_tiles_y;
 	spec->tile_offset = calloc((n_tiles + 1), sizeof(int));
+
+	scratch_pool_init(&spec->device_pool, true);
+	scratch_pool_init(&spec->host_pool, false);
+
+	// Adaptive buffer sizes
+	spec->sort_capacity = ((int) (SORT_BUFFER_INIT * spec->main_vector.size_max) / 1024 + 1) * 1024;
+	spec->sort_peak = 0;
+	spec->sort_low_steps = 0;
+	spec->sort_low_peak = 0;
+	spec->np_last = -1;
+	spec->np_growth_peak = 0;
+	spec->np_peak = 0;
+	spec->n_resize = 0;
 }
 
 void spec_delete(t_species *spec)
@@ -405,6 +420,9 @@ void spec_delete(t_species *spec)
 	part_vector_free(&spec->main_vector);
 	free(spec->tile_offset);
 
+	scratch_pool_free(&spec->device_pool);
+	scratch_pool_free(&spec->host_pool);
+
 	for(int n = 0; n < 3; n++)
 		if(spec->incoming_part[n].enable_vector)
 			part_vector_free(&spec->incoming_part[n]);
@@ -956,11 +974,70 @@ void spec_move_window_openacc(t_species *restrict spec, const int limits_y[2], c
 	}
 }
 
+// Move the particles in [begin, end) that are leaving the region through the lower (upper = false)
+// or upper boundary to the outgoing vector, using a stream compaction: flag the leaving
+// particles, scan the flags to get their position in the outgoing vector and copy them
+void spec_transfer_outgoing(t_species *spec, t_part_vector *outgoing, const int begin,
+		const int end, const int limits_y[2], const bool upper)
+{
+	const int nx1 = spec->nx[1];
+	const int limit = upper ? limits_y[1] : limits_y[0];
+	const int size = end - begin;
+	const int base = outgoing->size;
+
+	if (size <= 0) return;
+
+	t_part_vector *restrict main_vector = &spec->main_vector;
+	int *restrict select = scratch_pool_get(&spec->host_pool, (size + 1) * sizeof(int));
+
+	// Count
+	#pragma acc parallel loop
+	for (int k = 0; k < size; k++)
+	{
+		const int i = begin + k;
+		const int iy = main_vector->iy[i];
+		select[k] = !main_vector->invalid[i] && (upper ? iy >= limit : iy < limit);
+	}
+
+	// Scan
+	const int np_leaving = stream_compact_openacc(select, size, &spec->host_pool);
+
+	// Check if buffer is large enough and if not reallocate
+	if (base + np_leaving > outgoing->size_max)
+		part_vector_realloc(outgoing, ((base + np_leaving) / 1024 + 1) * 1024);
+
+	// Compaction
+	#pragma acc parallel loop
+	for (int k = 0; k < size; k++)
+	{
+		if (select[k + 1] == select[k]) continue;
+
+		const int i = begin + k;
+		const int idx = base + select[k];
+		int iy = main_vector->iy[i];
+
+		if (iy < 0) iy += nx1;
+		else if (iy >= nx1) iy -= nx1;
+
+		outgoing->ix[idx] = main_vector->ix[i];
+		outgoing->iy[idx] = iy;
+		outgoing->x[idx] = main_vector->x[i];
+		outgoing->y[idx] = main_vector->y[i];
+		outgoing->ux[idx] = main_vector->ux[i];
+		outgoing->uy[idx] = main_vector->uy[i];
+		outgoing->uz[idx] = main_vector->uz[i];
+		outgoing->invalid[idx] = false;
+
+		main_vector->invalid[i] = true;  // Mark the particle as invalid
+	}
+
+	outgoing->size = base + np_leaving;
+}
+
 // Transfer particles between regions (if applicable). OpenAcc Task
 void spec_check_boundaries_openacc(t_species *spec, const int limits_y[2], const int device)
 {
 	const int nx0 = spec->nx[0];
-	const int nx1 = spec->nx[1];
 
 #ifdef ENABLE_PREFETCH
 	spec_prefetch_openacc(spec->outgoing_part[1], device, NULL);
@@ -1009,85 +1086,15 @@ void spec_check_boundaries_openacc(t_species *spec, const int limits_y[2], const
 		}
 	}
 
-	// Check if particles are exiting the lower boundary and needs to be transfer to another region
-	#pragma acc parallel loop gang
-	for (int tile_x = 0; tile_x < spec->n_tiles_x; tile_x++)
-	{
-		const int begin = spec->tile_offset[tile_x];
-		const int end = spec->tile_offset[tile_x + 1];
-
-		#pragma acc loop vector
-		for (int i = begin; i < end; i++)
-		{
-			bool is_invalid = spec->main_vector.invalid[i];
-
-			if (!is_invalid)
-			{
-				int iy = spec->main_vector.iy[i];
-				int idx;
-
-				// Check if the particle is leaving the box
-				if (iy < limits_y[0])
-				{
-					if (iy < 0) iy += nx1;
+	// Transfer the particles exiting the lower/upper boundary to the neighbour regions. Only the
+	// first/last row of tiles needs to be checked (contiguous in the particle vector)
+	scratch_pool_reset(&spec->host_pool);
 
-					// Reserve a position in the vector
-					#pragma acc atomic capture
-					idx = spec->outgoing_part[0]->size++;
-
-					spec->outgoing_part[0]->ix[idx] = spec->main_vector.ix[i];
-					spec->outgoing_part[0]->iy[idx] = iy;
-					spec->outgoing_part[0]->x[idx] = spec->main_vector.x[i];
-					spec->outgoing_part[0]->y[idx] = spec->main_vector.y[i];
-					spec->outgoing_part[0]->ux[idx] = spec->main_vector.ux[i];
-					spec->outgoing_part[0]->uy[idx] = spec->main_vector.uy[i];
-					spec->outgoing_part[0]->uz[idx] = spec->main_vector.uz[i];
-					spec->outgoing_part[0]->invalid[idx] = false;
-
-					spec->main_vector.invalid[i] = true;  // Mark the particle as invalid
-				}
-			}
-		}
-	}
-
-	// Check if particles are exiting the upper boundary and needs to be transfer to another region
-	#pragma acc parallel loop gang
-	for (int tile_x = 0; tile_x < spec->n_tiles_x; tile_x++)
-	{
-		const int tile_idx = tile_x + (spec->n_tiles_y - 1) * spec->n_tiles_x;
-		const int begin = spec->tile_offset[tile_idx];
-		const int end = spec->tile_offset[tile_idx + 1];
-
-		#pragma acc loop vector
-		for (int i = begin; i < end; i++)
-		{
-			if (!spec->main_vector.invalid[i])
-			{
-				int iy = spec->main_vector.iy[i];
-				int idx;
-
-				// Check if the particle is leaving the box
-				if (iy >= limits_y[1])
-				{
-					if (iy >= nx1) iy -= nx1;
-
-					#pragma acc atomic capture
-					idx = spec->outgoing_part[1]->size++;
-
-					spec->outgoing_part[1]->ix[idx] = spec->main_vector.ix[i];
-					spec->outgoing_part[1]->iy[idx] = iy;
-					spec->outgoing_part[1]->x[idx] = spec->main_vector.x[i];
-					spec->outgoing_part[1]->y[idx] = spec->main_vector.y[i];
-					spec->outgoing_part[1]->ux[idx] = spec->main_vector.ux[i];
-					spec->outgoing_part[1]->uy[idx] = spec->main_vector.uy[i];
-					spec->outgoing_part[1]->uz[idx] = spec->main_vector.uz[i];
-					spec->outgoing_part[1]->invalid[idx] = false;
-
-					spec->main_vector.invalid[i] = true;  // Mark the particle as invalid
-				}
-			}
-		}
-	}
+	const int n_tiles = spec->n_tiles_x * spec->n_tiles_y;
+	spec_transfer_outgoing(spec, spec->outgoing_part[0], spec->tile_offset[0],
+			spec->tile_offset[spec->n_tiles_x], limits_y, false);
+	spec_transfer_outgoing(spec, spec->outgoing_part[1],
+			spec->tile_offset[n_tiles - spec->n_tiles_x], spec->tile_offset[n_tiles], limits_y, true);
 }
 
 /*********************************************************************************************
@@ -1095,6 +1102,7 @@ void spec_check_boundaries_openacc(t_species *spec, const int limits_y[2], const
  *********************************************************************************************/
 
 // Exchange particles between tiles (one particle vector parameter at a time to reduce memory usage)
+// Staging all the attributes of a chunk of particles at once was tried and ran slower (bench)
 void spec_apply_sort(uint32_t *restrict vector, const int *restrict source_idx,
 					 const int *restrict target_idx, uint32_t *restrict temp, const int sort_size)
 {
@@ -1112,10 +1120,10 @@ void spec_apply_sort(uint32_t *restrict vector, const int *restrict source_idx,
 // Calculate an histogram for the number of particles per tile
 void histogram_np_per_tile(t_part_vector *part_vector, int *restrict tile_offset,
 		t_part_vector incoming_part[3], const int n_tiles_y, const int n_tiles_x,
-		const int offset_region)
+		const int offset_region, t_scratch_pool *device_pool)
 {
 	const int n_tiles = n_tiles_x * n_tiles_y;
-	int *restrict np_per_tile = acc_malloc(n_tiles * sizeof(int));
+	int *restrict np_per_tile = scratch_pool_get(device_pool, n_tiles * sizeof(int));
 
 	#pragma acc parallel loop deviceptr(np_per_tile)
 	for(int i = 0; i < n_tiles; i++)
@@ -1206,8 +1214,6 @@ void histogram_np_per_tile(t_part_vector *part_vector, int *restrict tile_offset
 	for (int i = 0; i < n_tiles; i++)
 		tile_offset[i] = np_per_tile[i];
 	tile_offset[n_tiles] = 0;
-
-	acc_free(np_per_tile);
 }
 
 // Calculate an histogram for the particles moving between tiles
@@ -1409,6 +1415,68 @@ void merge_particles_buffers(t_part_vector *part_vector, t_part_vector *incoming
 	}
 }
 
+// Enlarge the particle vector if it cannot hold the required number of particles. The new size
+// covers the peak growth per step for VECTOR_HEADROOM_STEPS (at least EXTRA_NP of the particles)
+void spec_adapt_vector(t_species *spec, const int required)
+{
+	if (required <= spec->main_vector.size_max) return;
+
+	int headroom = spec->np_growth_peak * VECTOR_HEADROOM_STEPS;
+	if (headroom < EXTRA_NP * required) headroom = EXTRA_NP * required;
+
+	part_vector_realloc(&spec->main_vector, ((required + headroom) / 1024 + 1) * 1024);
+	spec->n_resize++;
+}
+
+// Track the growth of the particle vector after the sort
+void spec_track_vector(t_species *spec)
+{
+	const int np = spec->main_vector.size;
+
+	if (spec->np_last >= 0 && np - spec->np_last > spec->np_growth_peak)
+		spec->np_growth_peak = np - spec->np_last;
+	if (np > spec->np_peak) spec->np_peak = np;
+
+	spec->np_last = np;
+}
+
+// Choose the size of the sort buffers for the particles moving between tiles (sorting_size).
+// The buffers grow immediately (BUFFER_GROWTH times the required size) and only shrink after
+// BUFFER_SHRINK_STEPS consecutive steps using less than BUFFER_SHRINK_USAGE of their size
+// (hysteresis). Returns true if the buffers shrink (the old ones can be released)
+bool spec_adapt_sort_buffers(t_species *spec, const int sorting_size)
+{
+	if (sorting_size > spec->sort_peak) spec->sort_peak = sorting_size;
+
+	if (sorting_size >= spec->sort_capacity)
+	{
+		spec->sort_capacity = ((int) (BUFFER_GROWTH * sorting_size) / 1024 + 1) * 1024;
+		spec->sort_low_steps = 0;
+		spec->sort_low_peak = 0;
+		spec->n_resize++;
+		return false;
+	}
+
+	if (sorting_size >= BUFFER_SHRINK_USAGE * spec->sort_capacity)
+	{
+		spec->sort_low_steps = 0;
+		spec->sort_low_peak = 0;
+		return false;
+	}
+
+	if (sorting_size > spec->sort_low_peak) spec->sort_low_peak = sorting_size;
+	if (++spec->sort_low_steps < BUFFER_SHRINK_STEPS) return false;
+
+	const int new_capacity = ((int) (BUFFER_GROWTH * spec->sort_low_peak) / 1024 + 1) * 1024;
+	spec->sort_low_steps = 0;
+	spec->sort_low_peak = 0;
+	if (new_capacity >= spec->sort_capacity) return false;
+
+	spec->sort_capacity = new_capacity;
+	spec->n_resize++;
+	return true;
+}
+
 void spec_sort_openacc(t_species *spec, const int limits_y[2], const int device)
 {
 	const int offset_region = limits_y[0];
@@ -1416,24 +1484,22 @@ void spec_sort_openacc(t_species *spec, const int limits_y[2], const int device)
 	const int n_tiles_x = spec->n_tiles_x;
 	const int n_tiles = n_tiles_x * spec->n_tiles_y;
 
-	// acc_malloc --> Allocate the buffer in the device memory
-	const int max_leaving_np = spec->main_vector.size_max * MAX_LEAVING_PART;
-	int *restrict source_idx = acc_malloc(max_leaving_np * sizeof(int));
-	int *restrict target_idx = acc_malloc(max_leaving_np * sizeof(int));
-	int *restrict sort_counter = acc_malloc(n_tiles * sizeof(int));
-	int *restrict mv_part_offset = malloc((n_tiles + 1) * sizeof(int));
-	uint32_t *restrict temp = acc_malloc(max_leaving_np * sizeof(uint32_t));
+	// Temporary buffers (device pool --> device memory, host pool --> managed memory). The
+	// buffers are kept in the species and only reallocated when they need to grow
+	t_scratch_pool *device_pool = &spec->device_pool;
+	t_scratch_pool *host_pool = &spec->host_pool;
+	scratch_pool_reset(device_pool);
+	scratch_pool_reset(host_pool);
+
+	int *restrict sort_counter = scratch_pool_get(device_pool, n_tiles * sizeof(int));
+	int *restrict mv_part_offset = scratch_pool_get(host_pool, (n_tiles + 1) * sizeof(int));
 
 	int np_inj = 0;
 	for(int i = 0; i < 3; i++)
 		if(spec->incoming_part[i].enable_vector) np_inj += spec->incoming_part[i].size;
 
 	// Check if buffer is large enough and if not reallocate
-	if (spec->main_vector.size + np_inj > spec->main_vector.size_max)
-	{
-		const int new_size = ((spec->main_vector.size_max + np_inj) / 1024 + 1) * 1024;
-		part_vector_realloc(&spec->main_vector, new_size);
-	}
+	spec_adapt_vector(spec, spec->main_vector.size + np_inj);
 
 #ifdef ENABLE_PREFETCH
 	for(int i = 0; i < 2; i++)
@@ -1441,26 +1507,26 @@ void spec_sort_openacc(t_species *spec, const int limits_y[2], const int device)
 #endif
 
 	histogram_np_per_tile(&spec->main_vector, spec->tile_offset, spec->incoming_part, spec->n_tiles_y, n_tiles_x,
-			offset_region);
+			offset_region, device_pool);
 
 	// Prefix sum to find the initial idx of each bin
-	prefix_sum_openacc(spec->tile_offset, n_tiles + 1);
+	prefix_sum_openacc(spec->tile_offset, n_tiles + 1, host_pool);
 	spec->main_vector.size = spec->tile_offset[n_tiles];
 
 	histogram_moving_particles(&spec->main_vector, spec->tile_offset, mv_part_offset, n_tiles, n_tiles_x,
 			offset_region, size);
 
 	mv_part_offset[n_tiles] = 0;
-	prefix_sum_openacc(mv_part_offset, n_tiles + 1);
+	prefix_sum_openacc(mv_part_offset, n_tiles + 1, host_pool);
 
+	// Buffers for the particles moving between tiles (sized after the number of particles is known)
 	const int sorting_size = mv_part_offset[n_tiles];
-	if(sorting_size >= max_leaving_np)
-	{
-		fprintf(stderr, "Out-of-bounds: Buffer size (%d) is too small (Minimum: %d). "
-				"Increase MAX_LEAVING_PART to solve this issue.\n",
-		        max_leaving_np, sorting_size);
-		exit(1);
-	}
+	if (spec_adapt_sort_buffers(spec, sorting_size)) scratch_pool_release(device_pool);
+
+	const int sort_capacity = spec->sort_capacity;
+	int *restrict source_idx = scratch_pool_get(device_pool, sort_capacity * sizeof(int));
+	int *restrict target_idx = scratch_pool_get(device_pool, sort_capacity * sizeof(int));
+	uint32_t *restrict temp = scratch_pool_get(device_pool, sort_capacity * sizeof(uint32_t));
 
 	calculate_sorted_idx(&spec->main_vector, spec->tile_offset,source_idx,target_idx, sort_counter, mv_part_offset,
 			 spec->n_tiles_y, n_tiles_x, size, offset_region, sorting_size);
@@ -1481,12 +1547,7 @@ void spec_sort_openacc(t_species *spec, const int limits_y[2], const int device)
 	merge_particles_buffers(&spec->main_vector, spec->incoming_part, sort_counter, target_idx, n_tiles_x,
 							offset_region);
 
-	// Clean temporary vectors
-	acc_free(sort_counter);
-	free(mv_part_offset);
-	acc_free(target_idx);
-	acc_free(source_idx);
-	acc_free(temp);
+	spec_track_vector(spec);
 }
 
 /*********************************************************************************************
@@ -18,11 +18,18 @@
 #include "zpic.h"
 #include "emf.h"
 #include "current.h"
+#include "utilities.h"
 
 #define THREAD_BLOCK 320
 #define MAX_SPNAME_LEN 32
 #define EXTRA_NP 0.05 // Overallocation (fraction of the total)
-#define MAX_LEAVING_PART 1.0 // Maximum percentage of particles that can exchanged between tiles
+
+// Adaptive sizing of the particle buffers
+#define SORT_BUFFER_INIT 0.1 // Initial size of the sort buffers (fraction of the particle vector)
+#define BUFFER_GROWTH 1.5 // Size of the sort buffers after growing (times the required size)
+#define BUFFER_SHRINK_USAGE 0.25 // Shrink the sort buffers if their usage stays below this fraction
+#define BUFFER_SHRINK_STEPS 100 // ... for this number of consecutive time steps
+#define VECTOR_HEADROOM_STEPS 32 // The particle vector grows for this number of steps (peak growth)
 
 enum density_type {
 	UNIFORM, STEP, SLAB
@@ -104,6 +111,20 @@ typedef struct {
 	int n_tiles_y;
 	int *tile_offset;
 
+	// Temporary buffers of the sort and the boundary check, kept between time steps
+	t_scratch_pool device_pool;
+	t_scratch_pool host_pool;
+
+	// Adaptive sizing of the particle buffers (see spec_adapt_sort_buffers)
+	int sort_capacity;   // Size of the sort buffers (particles)
+	int sort_peak;       // Maximum number of particles sorted in one step
+	int sort_low_steps;  // Consecutive steps with low usage of the sort buffers
+	int sort_low_peak;   // Maximum number of particles sorted in these steps
+	int np_last;         // Number of particles after the previous sort (-1 if unknown)
+	int np_growth_peak;  // Maximum growth of the particle vector in one step
+	int np_peak;         // Maximum number of particles
+	int n_resize;        // Number of reallocations of the particle vector and sort buffers
+
 } t_species;
 
 // Setup
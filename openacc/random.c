@@ -15,10 +15,15 @@ uint32_t m_z = 67890; /* must not be zero */
 
 int iset = 1;
 
+// Second value of the Box-Muller method (stored for the next call of rand_norm)
+static int norm_iset = 0;
+static double norm_gset = 0.0;
+
 void set_rand_seed(uint32_t m_w_, uint32_t m_z_)
 {
 	m_w = m_w_;
 	m_z = m_z_;
+	norm_iset = 0;
 }
 
 uint32_t rand_uint32(void)
@@ -30,13 +35,10 @@ uint32_t rand_uint32(void)
 
 double rand_norm(void)
 {
-	static int iset = 0;
-	static double gset = 0.0;
-
-	if (iset)
+	if (norm_iset)
 	{
-		iset = 0;
-		return gset;
+		norm_iset = 0;
+		return norm_gset;
 	} else
 	{
 		double v1, v2, rsq, fac;
@@ -59,8 +61,8 @@ double rand_norm(void)
 		fac = sqrt(-2.0 * log(rsq) / rsq);
 
 		// store 1 value for future use
-		gset = v1 * fac;
-		iset = 1;
+		norm_gset = v1 * fac;
+		norm_iset = 1;
 
 		return v2 * fac;
 	}
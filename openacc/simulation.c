@@ -182,19 +182,30 @@ void sim_iter(t_simulation *sim)
 		const int device = i % num_gpus;
 		acc_set_device_num(device, DEVICE_TYPE);
 
+		uint64_t t0 = timer_ticks();
 		current_zero_openacc(&regions[i].local_current, device);
+		timer_phase_add(TIMER_GUARD_CELLS, t0);
 
 		for (int k = 0; k < regions[i].n_species; k++)
 		{
+			t0 = timer_ticks();
 			spec_advance_openacc(&regions[i].species[k], &regions[i].local_emf,
 					&regions[i].local_current, regions[i].limits_y, device);
 			if (regions[i].species[k].moving_window)
 				spec_move_window_openacc(&regions[i].species[k], regions[i].limits_y, device);
+			timer_phase_add(TIMER_PUSH, t0);
+
+			t0 = timer_ticks();
 			spec_check_boundaries_openacc(&regions[i].species[k], regions[i].limits_y, device);
+			timer_phase_add(TIMER_EXCHANGE, t0);
 		}
 
 		if (!regions[i].local_current.moving_window)
+		{
+			t0 = timer_ticks();
 			current_reduction_x_openacc(&regions[i].local_current, device);
+			timer_phase_add(TIMER_GUARD_CELLS, t0);
+		}
 	}
 
 	#pragma omp for schedule(static, 1)
@@ -203,9 +214,14 @@ void sim_iter(t_simulation *sim)
 		const int device = i % num_gpus;
 		acc_set_device_num(i % num_gpus, DEVICE_TYPE);
 
+		uint64_t t0 = timer_ticks();
 		for (int k = 0; k < regions[i].n_species; k++)
 			spec_sort_openacc(&regions[i].species[k], regions[i].limits_y, device);
+		timer_phase_add(TIMER_SORT, t0);
+
+		t0 = timer_ticks();
 		current_reduction_y_openacc(&regions[i].local_current, device);
+		timer_phase_add(TIMER_GUARD_CELLS, t0);
 	}
 
 	if (regions[0].local_current.smooth.xtype != NONE)
@@ -215,7 +231,10 @@ void sim_iter(t_simulation *sim)
 		{
 			const int device = i % num_gpus;
 			acc_set_device_num(i % num_gpus, DEVICE_TYPE);
+
+			const uint64_t t0 = timer_ticks();
 			current_smooth_x_openacc(&regions[i].local_current, device);
+			timer_phase_add(TIMER_FILTER, t0);
 		}
 	}
 
@@ -225,14 +244,21 @@ void sim_iter(t_simulation *sim)
 		{
 			#pragma omp for schedule(static, 1)
 			for(int i = 0; i < n_regions; i++)
+			{
+				const uint64_t t0 = timer_ticks();
 				current_smooth_y(&regions[i].local_current, BINOMIAL);
+				timer_phase_add(TIMER_FILTER, t0);
+			}
 
 			#pragma omp for schedule(static, 1)
 			for(int i = 0; i < n_regions; i++)
 			{
 				const int device = i % num_gpus;
 				acc_set_device_num(device, DEVICE_TYPE);
+
+				const uint64_t t0 = timer_ticks();
 				current_gc_update_y_openacc(&regions[i].local_current, device);
+				timer_phase_add(TIMER_GUARD_CELLS, t0);
 			}
 		}
 
@@ -240,7 +266,11 @@ void sim_iter(t_simulation *sim)
 		{
 			#pragma omp for schedule(static, 1)
 			for(int i = 0; i < n_regions; i++)
+			{
+				const uint64_t t0 = timer_ticks();
 				current_smooth_y(&regions[i].local_current, COMPENSATED);
+				timer_phase_add(TIMER_FILTER, t0);
+			}
 
 			#pragma omp for schedule(static, 1)
 			for(int i = 0; i < n_regions; i++)
@@ -248,7 +278,10 @@ void sim_iter(t_simulation *sim)
 				const int device = i % num_gpus;
 
 				acc_set_device_num(device, DEVICE_TYPE);
+
+				const uint64_t t0 = timer_ticks();
 				current_gc_update_y_openacc(&regions[i].local_current, device);
+				timer_phase_add(TIMER_GUARD_CELLS, t0);
 			}
 		}
 	}
@@ -266,7 +299,10 @@ void sim_iter(t_simulation *sim)
 	{
 		const int device = i % num_gpus;
 		acc_set_device_num(device, DEVICE_TYPE);
+
+		const uint64_t t0 = timer_ticks();
 		emf_update_gc_y_openacc(&regions[i].local_emf, device);
+		timer_phase_add(TIMER_GUARD_CELLS, t0);
 	}
 }
 
@@ -318,6 +354,33 @@ void sim_report_energy(t_simulation *sim)
 	}
 }
 
+// Print the final size of the particle buffers (sum of all regions) chosen by the adaptive sizing
+void sim_report_buffers(t_simulation *sim)
+{
+	fprintf(stdout, "\nParticle buffers (all regions):\n");
+	fprintf(stdout, "%-16s %14s %14s %14s %14s %8s\n", "species", "vector [part]", "peak [part]",
+			"sort [part]", "peak sort", "resizes");
+
+	for (int i = 0; i < sim->regions[0].n_species; i++)
+	{
+		long vector_size = 0, np_peak = 0, sort_size = 0, sort_peak = 0;
+		int n_resize = 0;
+
+		for (int j = 0; j < sim->n_regions; j++)
+		{
+			const t_species *spec = &sim->regions[j].species[i];
+			vector_size += spec->main_vector.size_max;
+			np_peak += spec->np_peak;
+			sort_size += spec->sort_capacity;
+			sort_peak += spec->sort_peak;
+			n_resize += spec->n_resize;
+		}
+
+		fprintf(stdout, "%-16s %14ld %14ld %14ld %14ld %8d\n", sim->regions[0].species[i].name,
+				vector_size, np_peak, sort_size, sort_peak, n_resize);
+	}
+}
+
 void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1, const unsigned int n_iterations)
 {
 	double npart = 0;
@@ -341,6 +404,12 @@ void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1, const unsigned int
 	fprintf(stdout, "Performance: %f Mpart/s", npart / sim_time / 1E6);
 	fprintf(stdout, "\n");
 
+	t_phase_timings timings;
+	timer_phase_collect(&timings);
+	timer_phase_report(&timings);
+
+	sim_report_buffers(sim);
+
 #else
 #ifdef ENABLE_PREFETCH
 	printf("%s,%d,%d,1,%f,%f\n", sim->name, sim->n_regions, acc_get_num_devices(DEVICE_TYPE), sim_time, npart / sim_time / 1E6);
@@ -395,7 +464,7 @@ void sim_report_grid_zdf(t_simulation *sim, enum report_grid_type type, const in
 
 // Save a particle property to a ZDF file
 void sim_report_spec_zdf(t_simulation *sim, const int species, const int rep_type,
-		const int pha_nx[2], const float pha_range[][2])
+		const int pha_nx[], const float pha_range[][2])
 {
 	t_region *regions = sim->regions;
 	const int n_regions = sim->n_regions;
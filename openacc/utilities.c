@@ -1,181 +1,273 @@
+#include <stdio.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "utilities.h"
 
 /*********************************************************************************************
  Prefix Sum
  *********************************************************************************************/
 
-// Add the block offset to the vector
-void add_block_sum(int *restrict vector, int *restrict block_sum, const int num_blocks,
-        const int block_size, const int vector_size)
+// Number of elements per block of the scan (at least LOCAL_BUFFER_SIZE, so the number of blocks
+// never exceeds SCAN_MAX_BLOCKS)
+int prefix_sum_block_size(const int size)
 {
-	#pragma acc parallel loop gang
-	for (int block_id = 1; block_id < num_blocks; block_id++)
-	{
-		const int begin_idx = block_id * block_size;
-
-		#pragma acc loop vector
-		for (int i = 0; i < block_size; i++)
-			if (i + begin_idx < vector_size) vector[i + begin_idx] += block_sum[block_id];
-	}
+	const int min_block = (size + SCAN_MAX_BLOCKS - 1) / SCAN_MAX_BLOCKS;
+	return MAX_VALUE((min_block + LOCAL_BUFFER_SIZE - 1) / LOCAL_BUFFER_SIZE * LOCAL_BUFFER_SIZE,
+			LOCAL_BUFFER_SIZE);
 }
 
-// Prefix Sum (Exclusive) - 1 warp per thread block
-void prefix_sum_min(int *restrict vector, int *restrict block_sum, const int num_blocks,
-        const int size)
+// Prefix/Scan Sum (Exclusive). Reduce-then-scan with a fixed two-level hierarchy: (1) each
+// thread block reduces its block, (2) the block sums are scanned by a single thread and (3) each
+// thread block scans its block (binomial tree in the shared memory, LOCAL_BUFFER_SIZE elements
+// at a time) starting from the block offset. The block sums are taken from the host pool
+void prefix_sum_openacc(int *restrict vector, const int size, t_scratch_pool *pool)
 {
-	// Prefix sum using a binomial tree
-	#pragma acc parallel loop gang vector_length(MIN_WARP_SIZE)
+	if (size <= 0) return;
+
+	const int block_size = prefix_sum_block_size(size);
+	const int num_blocks = (size + block_size - 1) / block_size;
+	int *restrict block_sum = scratch_pool_get(pool, num_blocks * sizeof(int));
+
+	// Block reduction
+	#pragma acc parallel loop gang
 	for (int block_id = 0; block_id < num_blocks; block_id++)
 	{
-		const int begin_idx = block_id * MIN_WARP_SIZE;
-		int local_buffer[MIN_WARP_SIZE];
+		const int begin_idx = block_id * block_size;
+		const int end_idx = MIN_VALUE(begin_idx + block_size, size);
+		int sum = 0;
 
-		#pragma acc cache(local_buffer[0: MIN_WARP_SIZE])
+		#pragma acc loop vector reduction(+:sum)
+		for (int i = begin_idx; i < end_idx; i++)
+			sum += vector[i];
 
-		// Copy to the local buffer
-		#pragma acc loop vector
-		for (int i = 0; i < MIN_WARP_SIZE; i++)
-		{
-			if (i + begin_idx < size) local_buffer[i] = vector[i + begin_idx];
-			else local_buffer[i] = 0;
-		}
+		block_sum[block_id] = sum;
+	}
 
-		// Scan the tree upward (in direction to the root).
-		// Add the values of each node and stores the result in the right node
-		for (int offset = 1; offset < MIN_WARP_SIZE; offset *= 2)
+	// Scan of the block sums (at most SCAN_MAX_BLOCKS values)
+	#pragma acc serial
+	{
+		int acc = 0;
+		for (int block_id = 0; block_id < num_blocks; block_id++)
 		{
-			#pragma acc loop vector
-			for (int i = offset - 1; i < MIN_WARP_SIZE; i += 2 * offset)
-				local_buffer[i + offset] += local_buffer[i];
+			int temp = block_sum[block_id];
+			block_sum[block_id] = acc;
+			acc += temp;
 		}
+	}
 
-		// Store the total sum in the block sum vector and reset the last position of the vector
-		block_sum[block_id] = local_buffer[MIN_WARP_SIZE - 1];
-		local_buffer[MIN_WARP_SIZE - 1] = 0;
+	// Block scan
+	#pragma acc parallel loop gang vector_length(LOCAL_BUFFER_SIZE / 2)
+	for (int block_id = 0; block_id < num_blocks; block_id++)
+	{
+		const int end_idx = MIN_VALUE((block_id + 1) * block_size, size);
+		int carry = block_sum[block_id];
+		int local_buffer[LOCAL_BUFFER_SIZE];
 
-		// Scan the tree downward (from the root).
-		// First, swap the values between nodes, then update the right node with the sum
-		for (int offset = MIN_WARP_SIZE >> 1; offset > 0; offset >>= 1)
+		#pragma acc cache(local_buffer[0: LOCAL_BUFFER_SIZE])
+
+		#pragma acc loop seq
+		for (int begin_idx = block_id * block_size; begin_idx < end_idx;
+				begin_idx += LOCAL_BUFFER_SIZE)
 		{
+			// Copy to the local buffer
 			#pragma acc loop vector
-			for (int i = offset - 1; i < MIN_WARP_SIZE; i += 2 * offset)
+			for (int i = 0; i < LOCAL_BUFFER_SIZE; i++)
 			{
-				int temp = local_buffer[i];
-				local_buffer[i] = local_buffer[i + offset];
-				local_buffer[i + offset] += temp;
+				if (i + begin_idx < end_idx) local_buffer[i] = vector[i + begin_idx];
+				else local_buffer[i] = 0;
 			}
-		}
 
-		// Store the results in the global vector
-		#pragma acc loop vector
-		for (int i = 0; i < MIN_WARP_SIZE; i++)
-			if (i + begin_idx < size) vector[i + begin_idx] = local_buffer[i];
+			// Scan the tree upward (in direction to the root).
+			// Add the values of each node and stores the result in the right node
+			for (int offset = 1; offset < LOCAL_BUFFER_SIZE; offset *= 2)
+			{
+				#pragma acc loop vector
+				for (int i = offset - 1; i < LOCAL_BUFFER_SIZE; i += 2 * offset)
+					local_buffer[i + offset] += local_buffer[i];
+			}
+
+			// Keep the total sum of the chunk and reset the last position of the vector
+			const int chunk_sum = local_buffer[LOCAL_BUFFER_SIZE - 1];
+			local_buffer[LOCAL_BUFFER_SIZE - 1] = 0;
+
+			// Scan the tree downward (from the root).
+			// First, swap the values between nodes, then update the right node with the sum
+			for (int offset = LOCAL_BUFFER_SIZE >> 1; offset > 0; offset >>= 1)
+			{
+				#pragma acc loop vector
+				for (int i = offset - 1; i < LOCAL_BUFFER_SIZE; i += 2 * offset)
+				{
+					int temp = local_buffer[i];
+					local_buffer[i] = local_buffer[i + offset];
+					local_buffer[i + offset] += temp;
+				}
+			}
+
+			// Store the results (plus the offset of the chunk) in the global vector
+			#pragma acc loop vector
+			for (int i = 0; i < LOCAL_BUFFER_SIZE; i++)
+				if (i + begin_idx < end_idx) vector[i + begin_idx] = local_buffer[i] + carry;
+
+			carry += chunk_sum;
+		}
 	}
 }
 
-// Prefix Sum (Exclusive) - Multiple warps per thread block
-void prefix_sum_full(int *restrict vector, int *restrict block_sum, const int num_blocks,
-        const int size)
+// Prefix/Scan Sum (Exclusive) in the host. Same strategy as the OpenACC version, with one block
+// per OpenMP thread
+void prefix_sum_openmp(int *restrict vector, const int size)
 {
-	// Prefix sum using a binomial tree
-	#pragma acc parallel loop gang vector_length(LOCAL_BUFFER_SIZE / 2) //
-	for (int block_id = 0; block_id < num_blocks; block_id++)
+#ifdef _OPENMP
+	const int max_threads = omp_get_max_threads();
+#else
+	const int max_threads = 1;
+#endif
+	int block_sum[max_threads + 1];
+
+	#pragma omp parallel
 	{
-		const int begin_idx = block_id * LOCAL_BUFFER_SIZE;
-		int local_buffer[LOCAL_BUFFER_SIZE];
+#ifdef _OPENMP
+		const int n_threads = omp_get_num_threads();
+		const int tid = omp_get_thread_num();
+#else
+		const int n_threads = 1;
+		const int tid = 0;
+#endif
+		const int begin_idx = (long) size * tid / n_threads;
+		const int end_idx = (long) size * (tid + 1) / n_threads;
 
-		#pragma acc cache(local_buffer[0: LOCAL_BUFFER_SIZE])
+		int sum = 0;
+		for (int i = begin_idx; i < end_idx; i++)
+			sum += vector[i];
+		block_sum[tid + 1] = sum;
 
-		// Copy to the local buffer
-		#pragma acc loop vector
-		for (int i = 0; i < LOCAL_BUFFER_SIZE; i++)
+		#pragma omp barrier
+		#pragma omp single
 		{
-			if (i + begin_idx < size) local_buffer[i] = vector[i + begin_idx];
-			else local_buffer[i] = 0;
+			block_sum[0] = 0;
+			for (int t = 1; t <= n_threads; t++)
+				block_sum[t] += block_sum[t - 1];
 		}
 
-		// Scan the tree upward (in direction to the root).
-		// Add the values of each node and stores the result in the right node
-		for (int offset = 1; offset < LOCAL_BUFFER_SIZE; offset *= 2)
+		int acc = block_sum[tid];
+		for (int i = begin_idx; i < end_idx; i++)
 		{
-			#pragma acc loop vector
-			for (int i = offset - 1; i < LOCAL_BUFFER_SIZE; i += 2 * offset)
-				local_buffer[i + offset] += local_buffer[i];
-
+			int temp = vector[i];
+			vector[i] = acc;
+			acc += temp;
 		}
+	}
+}
 
-		// Store the total sum in the block sum vector and reset the last position of the vector
-		block_sum[block_id] = local_buffer[LOCAL_BUFFER_SIZE - 1];
-		local_buffer[LOCAL_BUFFER_SIZE - 1] = 0;
+/*********************************************************************************************
+ Stream Compaction
+ *********************************************************************************************/
 
-		// Scan the tree downward (from the root).
-		// First, swap the values between nodes, then update the right node with the sum
-		for (int offset = LOCAL_BUFFER_SIZE >> 1; offset > 0; offset >>= 1)
-		{
-			#pragma acc loop vector
-			for (int i = offset - 1; i < LOCAL_BUFFER_SIZE; i += 2 * offset)
-			{
-				int temp = local_buffer[i];
-				local_buffer[i] = local_buffer[i + offset];
-				local_buffer[i + offset] += temp;
-			}
-		}
+// Stream compaction (index computation). On input, select[i] is 1 if the element i is selected
+// and 0 otherwise (the vector has size + 1 elements, the last is ignored). On output, select[i]
+// is the position of the element i in the compacted vector (element i is selected if
+// select[i + 1] > select[i]) and select[size] is the number of selected elements (returned).
+// The scan reduces each block before writing any position, so no atomics are needed
+int stream_compact_openacc(int *restrict select, const int size, t_scratch_pool *pool)
+{
+	select[size] = 0;
+	prefix_sum_openacc(select, size + 1, pool);
+	return select[size];
+}
+
+/*********************************************************************************************
+ Scratch Pools
+ *********************************************************************************************/
 
-		// Store the results in the global vector
-		#pragma acc loop vector
-		for (int i = 0; i < LOCAL_BUFFER_SIZE; i++)
-			if (i + begin_idx < size) vector[i + begin_idx] = local_buffer[i];
+void scratch_pool_init(t_scratch_pool *pool, const bool device)
+{
+	for (int i = 0; i < SCRATCH_POOL_SLOTS; i++)
+	{
+		pool->buffer[i] = NULL;
+		pool->capacity[i] = 0;
 	}
+
+	pool->n_used = 0;
+	pool->device = device;
 }
 
-// Prefix/Scan Sum (Exclusive)
-void prefix_sum_openacc(int *restrict vector, const int size)
+void scratch_pool_free(t_scratch_pool *pool)
 {
-	int num_blocks;
-	int *restrict block_sum;
-
-	if(size < LOCAL_BUFFER_SIZE / 4)
+	for (int i = 0; i < SCRATCH_POOL_SLOTS; i++)
 	{
-		num_blocks = ceil((float) size / MIN_WARP_SIZE);
-		block_sum = malloc(num_blocks * sizeof(int));
+		if (!pool->buffer[i]) continue;
 
-		prefix_sum_min(vector, block_sum, num_blocks, size);
+		if (pool->device) acc_free(pool->buffer[i]);
+		else free(pool->buffer[i]);
 
-		if (num_blocks > 1)
-		{
-			prefix_sum_openacc(block_sum, num_blocks);
+		pool->buffer[i] = NULL;
+		pool->capacity[i] = 0;
+	}
 
-			// Add the values from the block sum
-			add_block_sum(vector, block_sum, num_blocks, MIN_WARP_SIZE, size);
-		}
-	} else
-	{
-		num_blocks = ceil((float) size / LOCAL_BUFFER_SIZE);
-		block_sum = malloc(num_blocks * sizeof(int));
+	pool->n_used = 0;
+}
 
-		prefix_sum_full(vector, block_sum, num_blocks, size);
+// Return all the buffers to the pool (the memory is kept for the next calls)
+void scratch_pool_reset(t_scratch_pool *pool)
+{
+	pool->n_used = 0;
+}
 
-		if (num_blocks > 1)
-		{
-			prefix_sum_openacc(block_sum, num_blocks);
+// Free the buffers that were not requested since the last reset (they are allocated again, with
+// the requested size, in the next scratch_pool_get)
+void scratch_pool_release(t_scratch_pool *pool)
+{
+	for (int i = pool->n_used; i < SCRATCH_POOL_SLOTS; i++)
+	{
+		if (!pool->buffer[i]) continue;
 
-			// Add the values from the block sum
-			add_block_sum(vector, block_sum, num_blocks, LOCAL_BUFFER_SIZE, size);
-		}
-	}
+		if (pool->device) acc_free(pool->buffer[i]);
+		else free(pool->buffer[i]);
 
-	free(block_sum);
+		pool->buffer[i] = NULL;
+		pool->capacity[i] = 0;
+	}
 }
 
-void prefix_sum_serial(int *restrict vector, const int size)
+// Get the next buffer of the pool with at least size bytes. The buffer content is undefined
+void *scratch_pool_get(t_scratch_pool *pool, const size_t size)
 {
-	int acc = 0;
-	for (int i = 0; i < size; i++)
+	if (pool->n_used == SCRATCH_POOL_SLOTS)
 	{
-		int temp = vector[i];
-		vector[i] = acc;
-		acc += temp;
+		fprintf(stderr, "Scratch pool is full (%d buffers). Increase SCRATCH_POOL_SLOTS.\n",
+				SCRATCH_POOL_SLOTS);
+		exit(1);
 	}
+
+	const int slot = pool->n_used++;
+
+	if (pool->capacity[slot] < size)
+	{
+		size_t new_capacity = pool->capacity[slot] * SCRATCH_POOL_GROWTH;
+		if (new_capacity < size) new_capacity = size;
+		new_capacity = (new_capacity / SCRATCH_POOL_ALIGN + 1) * SCRATCH_POOL_ALIGN;
+
+		if (pool->buffer[slot])
+		{
+			if (pool->device) acc_free(pool->buffer[slot]);
+			else free(pool->buffer[slot]);
+		}
+
+		pool->buffer[slot] = pool->device ? acc_malloc(new_capacity) : malloc(new_capacity);
+		if (!pool->buffer[slot])
+		{
+			fprintf(stderr, "Error allocating a scratch buffer (%zu bytes). Exiting...\n",
+					new_capacity);
+			exit(1);
+		}
+
+		pool->capacity[slot] = new_capacity;
+	}
+
+	return pool->buffer[slot];
 }
 
 /*********************************************************************************************
@@ -5,7 +5,6 @@
 #include <string.h>
 #include <stdbool.h>
 #include <openacc.h>
-#include <cuda.h>
 #include <math.h>
 #include "zpic.h"
 
@@ -18,12 +17,35 @@
 
 #define LOCAL_BUFFER_SIZE 1024
 #define TILE_SIZE 16
-#define MIN_WARP_SIZE 32
+#define SCAN_MAX_BLOCKS 1024 // Maximum number of blocks in the prefix sum (second level)
+
+// Scratch pools
+#define SCRATCH_POOL_SLOTS 16
+#define SCRATCH_POOL_GROWTH 1.5  // Growth factor when a buffer is too small
+#define SCRATCH_POOL_ALIGN 256   // Buffer sizes are rounded up to this value (bytes)
+
+// Set of temporary buffers that persist between calls (e.g., one per time step). After
+// scratch_pool_reset, the n-th scratch_pool_get returns the n-th buffer, enlarging it if needed.
+// The buffers are allocated with acc_malloc (device memory) or malloc (host memory, which is
+// also accessible by the device with managed memory)
+typedef struct {
+	void *buffer[SCRATCH_POOL_SLOTS];
+	size_t capacity[SCRATCH_POOL_SLOTS];  // Bytes
+	int n_used;
+	bool device;
+} t_scratch_pool;
+
+void scratch_pool_init(t_scratch_pool *pool, const bool device);
+void scratch_pool_free(t_scratch_pool *pool);
+void scratch_pool_reset(t_scratch_pool *pool);
+void scratch_pool_release(t_scratch_pool *pool);
+void *scratch_pool_get(t_scratch_pool *pool, const size_t size);
 
 void realloc_buffer(void **restrict ptr, const size_t old_size, const size_t new_size, const size_t type_size);
 
-void prefix_sum_openacc(int *restrict vector, const int size);
-void prefix_sum_serial(int *restrict vector, const int size);
+void prefix_sum_openacc(int *restrict vector, const int size, t_scratch_pool *pool);
+void prefix_sum_openmp(int *restrict vector, const int size);
+int stream_compact_openacc(int *restrict select, const int size, t_scratch_pool *pool);
 
 #ifdef ENABLE_PREFETCH
 void grid_prefetch_openacc(t_vfld *buffer, const int size, const int device, void *stream);
@@ -11,8 +11,24 @@
 #define __ZPIC__
 
 #include <openacc.h>
+
+// DISABLE_CUDA: host-only build (e.g. GCC with -fopenacc) without the CUDA toolkit
+#ifndef DISABLE_CUDA
 #include <cuda.h>
 #include <vector_types.h>
+#else
+typedef struct {
+	int x, y;
+} int2;
+
+typedef struct {
+	float x, y;
+} float2;
+
+typedef struct {
+	float x, y, z;
+} float3;
+#endif
 
 typedef float t_fld;
 typedef float t_part_data;
@@ -0,0 +1,402 @@
+#!/usr/bin/env python3
+"""
+ZPIC - Strong/weak scaling harness
+
+Builds a variant for each input deck (make INPUT=<deck>), sweeps the number of ranks, threads
+and regions, collects the CSV line printed by the -DTEST builds (and the hardware counters,
+if enabled) and computes the scaling efficiency. The results can be compared against a stored
+baseline to catch scaling regressions.
+
+Examples:
+	# Strong scaling (OmpSs-2, 1 to 8 threads, 2 and 4 regions per thread)
+	scripts/scaling.py run --variant ompss2 --decks input/weibel-500-4M-512-512.c \
+		--threads 1,2,4,8 --regions 2x,4x --out results/ompss2
+
+	# Weak scaling (MPI, oversubscribed): the i-th deck runs with the i-th rank count
+	scripts/scaling.py run --variant mpi_ompss2 --weak ranks --ranks 1,4,16 \
+		--decks input/weak/cold-1n.c,input/weak/cold-4n.c,input/weak/cold-16n.c \
+		--regions 8 --out results/mpi --baseline results/mpi-baseline.csv
+
+	# Compare two result sets
+	scripts/scaling.py compare results/mpi/results.csv --baseline results/mpi-baseline.csv
+"""
+
+import argparse
+import csv
+import glob
+import itertools
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Fields of the CSV line printed by each variant when compiled with -DTEST
+TEST_FORMAT = {
+	'ompss2': ['name', 'regions', 'threads', 'time', 'perf'],
+	'openacc': ['name', 'regions', 'gpus', 'prefetch', 'time', 'perf'],
+	'ompss2_openacc': ['name', 'regions', 'gpus', 'prefetch', 'time', 'perf'],
+	'mpi_ompss2': ['name', 'ranks', 'threads', 'regions', 'time'],
+	'gaspi_ompss2': ['name', 'ranks', 'threads', 'regions', 'time'],
+}
+
+MPI_VARIANTS = ('mpi_ompss2', 'gaspi_ompss2')
+
+# Default launchers ({np} is replaced by the number of ranks)
+LAUNCHER = {
+	'mpi_ompss2': 'mpirun --oversubscribe --bind-to none -np {np}',
+	'gaspi_ompss2': 'mpirun --oversubscribe --bind-to none -np {np}',
+}
+
+RESULT_FIELDS = ['variant', 'series', 'deck', 'name', 'ranks', 'threads', 'regions', 'rep', 'time',
+		'work']
+
+# Simulation name: <type>-<number of time steps>-<number of particles>-<grid x>-<grid y>
+NAME_SCHEME = re.compile(r'^[^-]+-(\d+)-(\d+(?:\.\d+)?)([KMGBT]?)-(\d+)-(\d+)')
+NAME_SUFFIX = {'': 1, 'K': 1e3, 'M': 1e6, 'G': 1e9, 'B': 1e9, 'T': 1e12}
+
+#############################################################################################
+# Sweep
+#############################################################################################
+
+def parse_list(text):
+	return [item for item in text.split(',') if item] if text else []
+
+def parse_regions(text, threads):
+	"""Region count (per process), either absolute (16) or relative to the number of threads (4x)"""
+	if text.endswith('x'):
+		return int(text[:-1]) * threads
+	return int(text)
+
+def work_units(name):
+	"""Number of particle pushes of a simulation (from its name), 0 if unknown"""
+	match = NAME_SCHEME.match(name)
+	if not match:
+		sys.stderr.write('Warning: simulation name %s does not follow the naming scheme, '
+				'its amount of work is unknown\n' % name)
+		return 0
+	steps, npart, suffix = int(match.group(1)), float(match.group(2)), match.group(3)
+	return steps * npart * NAME_SUFFIX[suffix]
+
+def sweep(args):
+	"""List of (deck, ranks, threads, regions, series) to run"""
+	decks = parse_list(args.decks)
+	ranks = [int(r) for r in parse_list(args.ranks)]
+	threads = [int(t) for t in parse_list(args.threads)]
+	regions = parse_list(args.regions)
+
+	if args.weak:
+		axis = ranks if args.weak == 'ranks' else threads
+		if len(axis) != len(decks):
+			sys.exit('Error: weak scaling needs one deck per %s count' % args.weak)
+		points = []
+		for deck, n in zip(decks, axis):
+			point_ranks = [n] if args.weak == 'ranks' else ranks
+			point_threads = [n] if args.weak == 'threads' else threads
+			points += itertools.product([deck], point_ranks, point_threads)
+	else:
+		points = itertools.product(decks, ranks, threads)
+
+	# Runs of the same series are compared with each other (efficiency)
+	def series(deck, reg):
+		return '%s/%s' % ('weak' if args.weak else os.path.basename(deck), reg)
+
+	return [(deck, r, t, parse_regions(reg, t), series(deck, reg)) for deck, r, t in points
+			for reg in regions]
+
+#############################################################################################
+# Build and run
+#############################################################################################
+
+def build(args, deck, bin_dir):
+	"""Build the variant with the given input deck and return the path of the executable"""
+	variant_dir = os.path.join(REPO, args.variant)
+	make = ['make', '-C', variant_dir]
+	options = ['INPUT=' + deck] + args.make_args.split()
+
+	subprocess.run(make + ['clean'], check=True, stdout=subprocess.DEVNULL)
+	proc = subprocess.run(make + ['-j%d' % os.cpu_count()] + ([args.target] if args.target else [])
+			+ options, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+
+	if proc.returncode != 0:
+		sys.stderr.write(proc.stdout)
+		sys.exit('Error: failed to build %s with %s' % (args.variant, deck))
+
+	exe = os.path.join(bin_dir, '%s-%s' % (args.variant, os.path.splitext(os.path.basename(deck))[0]))
+	shutil.copy(os.path.join(variant_dir, 'zpic'), exe)
+	subprocess.run(make + ['clean'], check=True, stdout=subprocess.DEVNULL)
+	return exe
+
+def run(args, exe, ranks, threads, regions):
+	"""Run the simulation and return the CSV line (as a dict) printed by rank 0"""
+	env = dict(os.environ, OMP_NUM_THREADS=str(threads))
+
+	# The Nanos6 runtime uses all the CPUs in the process mask. Oversubscribed MPI runs share the
+	# same CPUs between ranks
+	if threads > os.cpu_count():
+		sys.exit('Error: %d threads requested, only %d CPUs available' % (threads, os.cpu_count()))
+	command = ['taskset', '-c', '0-%d' % (threads - 1), exe, str(regions)]
+
+	if args.variant in MPI_VARIANTS:
+		launcher = args.launcher or LAUNCHER[args.variant]
+		command = launcher.format(np=ranks).split() + command
+	elif ranks != 1:
+		sys.exit('Error: %s does not support multiple ranks' % args.variant)
+
+	proc = subprocess.run(command, cwd=os.path.join(REPO, args.variant), env=env,
+			stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True,
+			timeout=args.timeout)
+
+	if proc.returncode != 0:
+		sys.stderr.write(proc.stderr)
+		sys.exit('Error: %s failed (exit code %d)' % (' '.join(command), proc.returncode))
+
+	fields = TEST_FORMAT[args.variant]
+	for line in reversed(proc.stdout.splitlines()):
+		values = line.strip().split(',')
+		if len(values) == len(fields):
+			return dict(zip(fields, values))
+
+	sys.exit('Error: no -DTEST output found (was %s compiled with -DTEST?)' % args.variant)
+
+def collect_counters(args, name, run_dir):
+	"""Copy the hardware counters of the last run (-DENABLE_PERF_COUNTERS), if any"""
+	for path in glob.glob(os.path.join(REPO, args.variant, 'output', name, 'perf_*.csv')):
+		os.makedirs(run_dir, exist_ok=True)
+		shutil.copy(path, run_dir)
+
+def cmd_run(args):
+	# The simulations run in the variant directory
+	args.out = os.path.abspath(args.out)
+	os.makedirs(args.out, exist_ok=True)
+	bin_dir = os.path.join(args.out, 'bin')
+	os.makedirs(bin_dir, exist_ok=True)
+
+	points = sweep(args)
+	exes = {}
+	results = []
+
+	for deck, ranks, threads, regions, series in points:
+		if deck not in exes:
+			print('Building %s (%s)' % (args.variant, deck))
+			exes[deck] = build(args, deck, bin_dir) if not args.no_build else \
+					os.path.join(REPO, args.variant, 'zpic')
+
+		for rep in range(args.reps):
+			out = run(args, exes[deck], ranks, threads, regions)
+			result = {
+				'variant': args.variant, 'series': series, 'deck': deck, 'name': out['name'],
+				'ranks': ranks, 'threads': threads, 'regions': regions, 'rep': rep,
+				'time': float(out['time']), 'work': work_units(out['name'])
+			}
+			results.append(result)
+			print('%-14s %-28s ranks %3d threads %3d regions %4d: %10.3f s' % (args.variant,
+					out['name'], ranks, threads, regions, result['time']))
+
+			collect_counters(args, out['name'], os.path.join(args.out, 'counters',
+					'%s-r%d-t%d-n%d-%d' % (out['name'], ranks, threads, regions, rep)))
+
+	filename = os.path.join(args.out, 'results.csv')
+	write_results(filename, results)
+	print('\nResults saved in %s' % filename)
+
+	report(args, results)
+
+#############################################################################################
+# Analysis
+#############################################################################################
+
+def write_results(filename, results):
+	with open(filename, 'w', newline='') as file:
+		writer = csv.DictWriter(file, fieldnames=RESULT_FIELDS)
+		writer.writeheader()
+		writer.writerows(results)
+
+def read_results(filename):
+	with open(filename, newline='') as file:
+		results = list(csv.DictReader(file))
+	for r in results:
+		for key in ('ranks', 'threads', 'regions', 'rep'):
+			r[key] = int(r[key])
+		for key in ('time', 'work'):
+			r[key] = float(r[key])
+	return results
+
+def summarize(results):
+	"""Best time of the repetitions of each configuration"""
+	best = {}
+	for r in results:
+		key = (r['variant'], r['series'], r['name'], r['ranks'], r['threads'], r['regions'])
+		if key not in best or r['time'] < best[key]['time']:
+			best[key] = r
+	return [best[key] for key in sorted(best)]
+
+def efficiency(results):
+	"""
+	Scaling efficiency relative to the configuration with the fewest workers (ranks x threads)
+	of each series (same deck or weak scaling decks, same region setting). The same formula
+	covers strong scaling (same work) and weak scaling (work ~ workers):
+		efficiency = (time_ref / time) * (work / work_ref) * (workers_ref / workers)
+	"""
+	series = {}
+	for r in summarize(results):
+		series.setdefault((r['variant'], r['series']), []).append(r)
+
+	rows = []
+	for key, runs in sorted(series.items()):
+		runs.sort(key=lambda r: (r['ranks'] * r['threads'], r['work']))
+		ref = runs[0]
+		ref_workers = ref['ranks'] * ref['threads']
+		for r in runs:
+			workers = r['ranks'] * r['threads']
+			if r['work'] > 0 and ref['work'] > 0:
+				work_ratio = r['work'] / ref['work']
+			elif r['name'] == ref['name']:
+				work_ratio = 1 # Same simulation (strong scaling)
+			else:
+				sys.exit('Error: unknown amount of work for %s or %s (series %s), cannot compare '
+						'them' % (r['name'], ref['name'], r['series']))
+			speedup = ref['time'] / r['time'] * work_ratio
+			rows.append(dict(r, workers=workers, speedup=speedup,
+					efficiency=speedup * ref_workers / workers))
+	return rows
+
+def print_table(rows):
+	print('\n%-14s %-24s %-28s %5s %7s %7s %10s %8s %6s' % ('variant', 'series', 'simulation',
+			'ranks', 'threads', 'regions', 'time [s]', 'speedup', 'eff.'))
+	for r in rows:
+		print('%-14s %-24s %-28s %5d %7d %7d %10.3f %8.2f %6.2f' % (r['variant'], r['series'],
+				r['name'], r['ranks'], r['threads'], r['regions'], r['time'], r['speedup'],
+				r['efficiency']))
+
+def plot(rows, filename):
+	try:
+		import matplotlib
+		matplotlib.use('Agg')
+		import matplotlib.pyplot as plt
+	except ImportError:
+		print('matplotlib not available, skipping the plots')
+		return
+
+	fig, axes = plt.subplots(1, 2, figsize=(10, 4))
+	series = {}
+	for r in rows:
+		series.setdefault((r['variant'], r['series']), []).append(r)
+
+	for (variant, name), runs in sorted(series.items()):
+		label = '%s %s' % (variant, name)
+		workers = [r['workers'] for r in runs]
+		axes[0].plot(workers, [r['speedup'] for r in runs], 'o-', label=label)
+		axes[1].plot(workers, [r['efficiency'] for r in runs], 'o-', label=label)
+
+	for ax, ylabel in zip(axes, ('Speedup', 'Efficiency')):
+		ax.set_xscale('log', base=2)
+		ax.set_xlabel('Workers (ranks x threads)')
+		ax.set_ylabel(ylabel)
+		ax.grid(True)
+	axes[1].set_ylim(0, 1.1)
+	axes[0].legend(fontsize='small')
+
+	fig.tight_layout()
+	fig.savefig(filename)
+	print('Plot saved in %s' % filename)
+
+def compare(results, baseline, tolerance):
+	"""Report the configurations that are slower (or scale worse) than the baseline"""
+	def index(rows):
+		return {(r['variant'], r['series'], r['name'], r['ranks'], r['threads'], r['regions']): r
+				for r in rows}
+
+	current = index(efficiency(results))
+	reference = index(efficiency(baseline))
+	regressions = 0
+
+	print('\nComparison with the baseline (tolerance %.0f%%):' % (100 * tolerance))
+	for key in sorted(current):
+		if key not in reference:
+			continue
+		cur, ref = current[key], reference[key]
+		slowdown = cur['time'] / ref['time'] - 1
+		eff_loss = ref['efficiency'] - cur['efficiency']
+		status = 'ok'
+		if slowdown > tolerance or eff_loss > tolerance:
+			status = 'REGRESSION'
+			regressions += 1
+		print('%-14s %-28s ranks %3d threads %3d regions %4d: time %+6.1f%%, efficiency %.2f -> '
+				'%.2f  %s' % (key[:1] + key[2:] + (100 * slowdown, ref['efficiency'],
+				cur['efficiency'], status)))
+
+	if regressions:
+		print('%d scaling regression(s) found' % regressions)
+	return regressions
+
+def report(args, results):
+	rows = efficiency(results)
+	print_table(rows)
+
+	with open(os.path.join(args.out, 'efficiency.csv'), 'w', newline='') as file:
+		fields = RESULT_FIELDS + ['workers', 'speedup', 'efficiency']
+		writer = csv.DictWriter(file, fieldnames=fields)
+		writer.writeheader()
+		writer.writerows(rows)
+
+	plot(rows, os.path.join(args.out, 'scaling.png'))
+
+	if args.save_baseline:
+		write_results(args.save_baseline, results)
+		print('Baseline saved in %s' % args.save_baseline)
+
+	if args.baseline and compare(results, read_results(args.baseline), args.tolerance):
+		sys.exit(1)
+
+def cmd_compare(args):
+	results = read_results(args.results)
+	args.out = os.path.dirname(os.path.abspath(args.results))
+	args.save_baseline = None
+	report(args, results)
+
+#############################################################################################
+# Main
+#############################################################################################
+
+def main():
+	parser = argparse.ArgumentParser(description='ZPIC strong/weak scaling harness',
+			formatter_class=argparse.RawDescriptionHelpFormatter, epilog=__doc__)
+	sub = parser.add_subparsers(dest='command')
+	sub.required = True
+
+	p = sub.add_parser('run', help='build, run the sweep and report the scaling efficiency')
+	p.add_argument('--variant', required=True, choices=sorted(TEST_FORMAT))
+	p.add_argument('--decks', required=True, help='input decks (relative to the variant directory)')
+	p.add_argument('--ranks', default='1', help='list of rank counts (MPI variants)')
+	p.add_argument('--threads', default='1', help='list of thread counts (CPUs per process)')
+	p.add_argument('--regions', default='1x',
+			help='list of region counts per process, absolute (16) or per thread (4x)')
+	p.add_argument('--weak', choices=('ranks', 'threads'),
+			help='weak scaling: pair the i-th deck with the i-th rank/thread count')
+	p.add_argument('--reps', type=int, default=1, help='repetitions (the best time is used)')
+	p.add_argument('--target', help='make target (e.g., openmp)')
+	p.add_argument('--make-args', default='', help='extra make arguments (e.g., "CC=mcc")')
+	p.add_argument('--no-build', action='store_true', help='use the existing executable')
+	p.add_argument('--launcher', help='MPI launcher, {np} is replaced by the number of ranks')
+	p.add_argument('--timeout', type=float, default=None, help='timeout per run (seconds)')
+	p.add_argument('--out', default='scaling-results', help='output directory')
+	p.add_argument('--baseline', help='results.csv of a previous run to compare against')
+	p.add_argument('--save-baseline', help='save the results as a new baseline')
+	p.add_argument('--tolerance', type=float, default=0.1,
+			help='allowed relative slowdown / efficiency loss (default: 0.1)')
+	p.set_defaults(func=cmd_run)
+
+	p = sub.add_parser('compare', help='report a previous run (and compare it with a baseline)')
+	p.add_argument('results', help='results.csv')
+	p.add_argument('--baseline', help='results.csv of the baseline')
+	p.add_argument('--tolerance', type=float, default=0.1)
+	p.set_defaults(func=cmd_compare)
+
+	args = parser.parse_args()
+	args.func(args)
+
+if __name__ == '__main__':
+	main()
@@ -16,6 +16,7 @@
 #include <string.h>
 
 #include "zdf.h"
+#include "timer.h"
 
 // Constructor
 void current_new(t_current *current, int nx[], t_fld box[], float dt)
@@ -77,11 +78,13 @@ void current_zero(t_current *current)
 {
 	// zero fields
 	size_t size;
+	uint64_t t0 = timer_ticks();
 
 	size = (current->gc[0][0] + current->nx[0] + current->gc[0][1])
 			* (current->gc[1][0] + current->nx[1] + current->gc[1][1]) * sizeof(t_vfld);
 	memset(current->J_buf, 0, size);
 
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 }
 
 void current_update(t_current *current)
@@ -90,6 +93,8 @@ void current_update(t_current *current)
 	const int nrow = current->nrow;
 	t_vfld *restrict const J = current->J;
 
+	uint64_t t0 = timer_ticks();
+
 	// x
 	if (!current->moving_window)
 	{
@@ -130,8 +135,12 @@ void current_update(t_current *current)
 
 	}
 
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
+
 	// Smoothing
+	t0 = timer_ticks();
 	current_smooth(current);
+	timer_phase_add(TIMER_FILTER, t0);
 
 	current->iter++;
 
@@ -19,13 +19,11 @@
 #include "emf.h"
 #include "zdf.h"
 #include "timer.h"
-#include "csv_handler.h"
-
-static double _emf_time = 0.0;
+#include "npy_handler.h"
 
 double emf_time(void)
 {
-	return _emf_time;
+	return timer_phase_seconds(TIMER_SOLVE);
 }
 
 /*********************************************************************************************
@@ -568,8 +566,12 @@ void emf_advance(t_emf *emf, const t_current *current)
 
 	yee_b(emf, dt / 2.0f);
 
+	timer_phase_add(TIMER_SOLVE, t0);
+
 	// Update guard cells with new values
+	t0 = timer_ticks();
 	emf_update_gc(emf);
+	timer_phase_add(TIMER_GUARD_CELLS, t0);
 
 	// Advance internal iteration number
 	emf->iter += 1;
@@ -577,11 +579,10 @@ void emf_advance(t_emf *emf, const t_current *current)
 	// Move simulation window if needed
 	if (emf->moving_window)
 	{
+		t0 = timer_ticks();
 		emf_move_window(emf);
+		timer_phase_add(TIMER_SOLVE, t0);
 	}
-
-	// Update timing information
-	_emf_time += timer_interval_seconds(t0, timer_ticks());
 }
 
 double emf_get_energy(t_emf *emf)
@@ -627,11 +628,11 @@ void emf_report_magnitude(const t_emf *emf, const char name[64])
 		}
 	}
 
-	sprintf(filenameE, "e_mag_map_%d.csv", emf->iter);
-	sprintf(filenameB, "b_mag_map_%d.csv", emf->iter);
+	sprintf(filenameE, "e_mag_map_%d.npy", emf->iter);
+	sprintf(filenameB, "b_mag_map_%d.npy", emf->iter);
 
-	save_data_csv(E_magnitude, emf->nx[0], emf->nx[1], filenameE, name);
-	save_data_csv(B_magnitude, emf->nx[0], emf->nx[1], filenameB, name);
+	save_data_npy(E_magnitude, emf->nx[0], emf->nx[1], filenameE, name);
+	save_data_npy(B_magnitude, emf->nx[0], emf->nx[1], filenameB, name);
 
 	free(E_magnitude);
 	free(B_magnitude);
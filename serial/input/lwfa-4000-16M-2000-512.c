@@ -53,7 +53,7 @@ void sim_init(t_simulation *sim)
 
 void sim_report(t_simulation *sim)
 {
-	//sim_report_csv(sim);
+	//sim_report_npy(sim);
 	sim_report_energy(sim);
 
 	// Bx, By, Bz
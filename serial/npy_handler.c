@@ -0,0 +1,79 @@
+/*********************************************************************************************
+ ZPIC
+ npy_handler.c
+
+ NumPy .npy writer for the grid reports (open with numpy.load or numpy.memmap).
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <string.h>
+
+#include "npy_handler.h"
+
+// Size of the header (magic string + version + length + dictionary). It must be a multiple of
+// 64 bytes, so the data is aligned for memory mapping
+#define NPY_HEADER_SIZE 128
+
+// NumPy type descriptor of t_fld in the byte order of this machine
+static const char* npy_descr(void)
+{
+	const uint16_t one = 1;
+	return *(const uint8_t*) &one ? "<f4" : ">f4";
+}
+
+void save_data_npy(const t_fld *grid, unsigned int sizeX, unsigned int sizeY, const char filename[128],
+		const char sim_name[64])
+{
+	char fullpath[256];
+	struct stat sb;
+
+	//Create the output directory if it doesn't exists
+	strcpy(fullpath, "output");
+	if (stat(fullpath, &sb) == -1) mkdir(fullpath, 0700);
+
+	strcat(fullpath, "/");
+	strcat(fullpath, sim_name);
+	if (stat(fullpath, &sb) == -1) mkdir(fullpath, 0700);
+
+	strcat(fullpath, "/");
+	strcat(fullpath, filename);
+
+	FILE *file = fopen(fullpath, "wb");
+	if (!file)
+	{
+		printf("Couldn't open %s", filename);
+		exit(1);
+	}
+
+	// Header: magic string, version 1.0, header length (little-endian) and the dictionary
+	// padded with spaces and terminated by a newline
+	char header[NPY_HEADER_SIZE];
+	const int dict_size = NPY_HEADER_SIZE - 10;
+
+	memcpy(header, "\x93NUMPY\x01\x00", 8);
+	header[8] = dict_size & 0xFF;
+	header[9] = dict_size >> 8;
+
+	int len = snprintf(&header[10], dict_size, "{'descr': '%s', 'fortran_order': False, 'shape': (%u, %u), }",
+			npy_descr(), sizeY, sizeX);
+	memset(&header[10 + len], ' ', dict_size - len - 1);
+	header[NPY_HEADER_SIZE - 1] = '\n';
+
+	// The grid is written with a single call (raw values, no conversion)
+	const size_t size = (size_t) sizeX * sizeY;
+	if (fwrite(header, 1, NPY_HEADER_SIZE, file) != NPY_HEADER_SIZE
+			|| fwrite(grid, sizeof(t_fld), size, file) != size)
+	{
+		printf("Error writing %s", filename);
+		exit(1);
+	}
+
+	fclose(file);
+}
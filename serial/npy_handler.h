@@ -0,0 +1,21 @@
+/*********************************************************************************************
+ ZPIC
+ npy_handler.h
+
+ NumPy .npy writer for the grid reports (open with numpy.load or numpy.memmap).
+
+ Copyright 2020 Centro de Física dos Plasmas. All rights reserved.
+
+ *********************************************************************************************/
+
+#ifndef SERIAL_NPY_HANDLER_H_
+#define SERIAL_NPY_HANDLER_H_
+
+#include "zpic.h"
+
+// Write the grid (sizeY rows of sizeX values) into a NumPy .npy file (float32, C order).
+// The file can be opened with numpy.load or numpy.memmap (mode='r', offset=128)
+void save_data_npy(const t_fld *grid, unsigned int sizeX, unsigned int sizeY, const char filename[128],
+		const char sim_name[64]);
+
+#endif /* SERIAL_NPY_HANDLER_H_ */
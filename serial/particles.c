@@ -22,9 +22,8 @@
 
 #include "zdf.h"
 #include "timer.h"
-#include "csv_handler.h"
+#include "npy_handler.h"
 
-static double _spec_time = 0.0;
 static double _spec_npush = 0.0;
 
 /**
@@ -33,7 +32,7 @@ static double _spec_npush = 0.0;
  */
 double spec_time(void)
 {
-	return _spec_time;
+	return timer_phase_seconds(TIMER_PUSH);
 }
 
 /**
@@ -42,7 +41,7 @@ double spec_time(void)
  */
 double spec_perf(void)
 {
-	return (_spec_npush > 0) ? _spec_time / _spec_npush : 0.0;
+	return (_spec_npush > 0) ? spec_time() / _spec_npush : 0.0;
 }
 
 /*********************************************************************************************
@@ -736,7 +735,7 @@ void spec_advance(t_species *spec, t_emf *emf, t_current *current)
 
 
 	_spec_npush += spec->np;
-	_spec_time += timer_interval_seconds(t0, timer_ticks());
+	timer_phase_add(TIMER_PUSH, t0);
 }
 
 /*********************************************************************************************
@@ -1075,7 +1074,7 @@ void spec_report(const t_species *spec, const int rep_type, const int pha_nx[],
 
 }
 
-void spec_report_csv(const t_species *spec, const char sim_name[64])
+void spec_report_npy(const t_species *spec, const char sim_name[64])
 {
 	t_part_data *buf, *charge, *b, *c;
 	size_t size;
@@ -1106,8 +1105,8 @@ void spec_report_csv(const t_species *spec, const char sim_name[64])
 	}
 
 	char filename[128];
-	sprintf(filename, "%s_charge_map_%d.csv", spec->name, spec->iter);
-	save_data_csv(buf, spec->nx[0], spec->nx[1], filename, sim_name);
+	sprintf(filename, "%s_charge_map_%d.npy", spec->name, spec->iter);
+	save_data_npy(buf, spec->nx[0], spec->nx[1], filename, sim_name);
 
 	free(charge);
 	free(buf);
@@ -112,7 +112,7 @@ void spec_report(const t_species *spec, const int rep_type, const int pha_nx[],
 		const float pha_range[][2], const char path[128]);
 
 void spec_deposit_charge(const t_species *spec, float *charge);
-void spec_report_csv(const t_species *spec, const char sim_name[64]);
+void spec_report_npy(const t_species *spec, const char sim_name[64]);
 void spec_calculate_energy(t_species *restrict spec);
 
 #endif
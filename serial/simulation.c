@@ -195,7 +195,10 @@ void sim_timings(t_simulation *sim, uint64_t t0, uint64_t t1)
 	fprintf(stdout, "Time for spec. advance = %f s\n", spec_time());
 	fprintf(stdout, "Time for emf   advance = %f s\n", emf_time());
 	fprintf(stdout, "Total simulation time  = %f s\n", timer_interval_seconds(t0, t1));
-	fprintf(stdout, "\n");
+
+	t_phase_timings timings;
+	timer_phase_collect(&timings);
+	timer_phase_report(&timings);
 
 	if (spec_time() > 0)
 	{
@@ -233,12 +236,12 @@ void sim_report_spec_zdf(t_simulation *sim, const int species, const int rep_typ
 	spec_report(&sim->species[species], rep_type, pha_nx, pha_range, path);
 }
 
-void sim_report_csv(t_simulation *sim)
+void sim_report_npy(t_simulation *sim)
 {
 	emf_report_magnitude(&sim->emf, sim->name);
 
 	for(int i = 0; i < sim->n_species; i++)
-		spec_report_csv(&sim->species[i], sim->name);
+		spec_report_npy(&sim->species[i], sim->name);
 }
 
 